@@ -16,34 +16,41 @@
 #include <M5Core2.h>
 #include <M5GFX.h>
 #include <Unit_Sonic.h>
+#include <Unit_Sonic_Plot.h>
 
 M5GFX display;
-M5Canvas canvas(&display);
 
 SONIC_I2C sensor;
+SONIC_PLOT plot;
 
 void setup() {
     M5.begin();  // Init M5Core2.  初始化M5Core2
     sensor.begin();
     display.begin();
-    canvas.setColorDepth(1);
-    canvas.setFont(&fonts::Orbitron_Light_24);
-    canvas.setTextSize(1);
-    canvas.createSprite(display.width(), display.height());
-    canvas.setPaletteColor(1, ORANGE);
+    display.setFont(&fonts::Orbitron_Light_24);
+    display.setTextSize(1);
+    display.setTextColor(ORANGE, BLACK);
+
+    /* The plot takes the top of the screen (one column per 50ms) and gets every new reading from the sensor */
+    plot.begin(0, 0, display.width(), 185, 50);
+    plot.setColors(ORANGE, BLACK);
+    plot.clear(display);
+    sensor.attach(&plot);
 }
 
-int point      = 0;
-int last_point = 0;
+uint32_t label_ms = 0;
 
 void loop() {
-    canvas.scroll(4);
-    float Distance = sensor.getDistance();
-    Serial.printf("Distance: %.2fmm\r\n", Distance);
-    point = map((int)Distance, 20, 4500, 10, 180);
-    canvas.drawLine(0, point, 4, last_point, 1);
-    last_point = point;
-    canvas.fillRect(0, 190, 320, 50, BLACK);
-    canvas.drawString(String(Distance) + "mm", 80, 190);
-    canvas.pushSprite(0, 0);
+    /* Poll as often as possible - drawing only costs the plot columns completed since the last loop */
+    if(sensor.readingAvailable()) {
+        Serial.printf("Distance: %.2fmm\r\n", sensor.getDistance());
+    }
+    plot.render(display, millis());
+
+    /* A few label updates a second are plenty */
+    if((millis() - label_ms) >= 200) {
+        label_ms = millis();
+        display.fillRect(0, 190, 320, 50, BLACK);
+        display.drawString(String(sensor.getDistance()) + "mm", 80, 190);
+    }
 }
@@ -21,13 +21,15 @@ SONIC_IO sensor;
 void setup() {
     M5.begin(true, false, false);  // Init M5Atom.  初始化M5Atom
     sensor.begin(26, 32);
+    sensor.attachEcho();
 }
 
 void loop() {
-    static float Distance = 0;
-    Distance              = sensor.getDistance();
-    if ((Distance < 4000) && (Distance > 20)) {
-        Serial.printf("Distance: %.2fmm\r\n", Distance);
+    /* Poll every loop - readingAvailable() returns true once per new measurement */
+    if(sensor.readingAvailable()) {
+        float Distance = sensor.getDistance();
+        if((Distance < 4000) && (Distance > 20)) {
+            Serial.printf("Distance: %.2fmm\r\n", Distance);
+        }
     }
-    delay(100);
 }
@@ -22,6 +22,7 @@ void setup() {
     M5.begin();             // Init M5StickC.  初始化M5StickC
     M5.Lcd.setRotation(3);  // Rotating display.  旋转显示屏
     sensor.begin(32, 33);
+    sensor.attachEcho();
     M5.Lcd.setCursor(0, 0,
                      4);  // Set the cursor at (0,0) and set the font to a 4
                           // point font. 将光标设置在(0,0)处,且设置字体为4号字体
@@ -29,11 +30,12 @@ void setup() {
 }
 
 void loop() {
-    static float newvalue = 0;
-    newvalue              = sensor.getDistance();
-    if ((newvalue < 4000) && (newvalue > 20)) {
-        M5.Lcd.setCursor(0, 27);
-        M5.Lcd.printf("%.2fmm", newvalue);
+    /* Poll every loop and only touch the display when there is a new reading */
+    if(sensor.readingAvailable()) {
+        float newvalue = sensor.getDistance();
+        if((newvalue < 4000) && (newvalue > 20)) {
+            M5.Lcd.setCursor(0, 27);
+            M5.Lcd.printf("%.2fmm  ", newvalue);
+        }
     }
-    delay(100);
 }
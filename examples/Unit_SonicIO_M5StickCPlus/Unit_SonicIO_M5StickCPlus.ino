@@ -26,17 +26,16 @@ void setup() {
     // point font. 将光标设置在(0,0)处,且设置字体为4号字体
     M5.Lcd.print("Ultrasonic\nDistance:");
     sensor.begin(32, 33);
+    sensor.attachEcho();
 }
 
-int point      = 0;
-int last_point = 0;
-
 void loop() {
-    static float newvalue = 0;
-    newvalue              = sensor.getDistance();
-    if ((newvalue < 4000) && (newvalue > 20)) {
-        M5.Lcd.setCursor(0, 27);
-        M5.Lcd.printf("%.2fmm", newvalue);
+    /* Poll every loop and only touch the display when there is a new reading */
+    if(sensor.readingAvailable()) {
+        float newvalue = sensor.getDistance();
+        if((newvalue < 4000) && (newvalue > 20)) {
+            M5.Lcd.setCursor(0, 27);
+            M5.Lcd.printf("%.2fmm  ", newvalue);
+        }
     }
-    delay(100);
 }
@@ -0,0 +1,70 @@
+/*
+    Field tuning console.
+
+    An I2C and an IO Unit Sonic run at full rate with statistics, histograms and a background model attached,
+    and SONIC_CONSOLE takes commands on the serial monitor (115200, any line ending).  Its replies are queued
+    and written only as far as the serial TX buffer has room, so a long dump doesn't block the loop.  Try for example:
+        list                    what can be tuned
+        counters                triggers / readings / gated / misses per sensor
+        range front 200 2000    only accept readings between 200mm and 2000mm
+        interval rear 50        ping the IO unit at most every 50ms
+        conv front 0 40         40ms conversion time for near targets
+        speed 400000            run the I2C bus at 400kHz
+        hist front_hist reset   distance and reading interval histograms
+*/
+#include <Arduino.h>
+#include <Unit_Sonic.h>
+#include <Unit_Sonic_Console.h>
+
+#define TRIG_PIN 26
+#define ECHO_PIN 36
+
+SONIC_I2C sensor_i2c;
+SONIC_IO sensor_io;
+
+SONIC_STATS stats_i2c, stats_io;
+SONIC_HISTOGRAM hist_i2c, hist_io;
+SONIC_BACKGROUND background;
+
+SONIC_CONSOLE console;
+
+void setup() {
+    Serial.begin(115200);
+
+    sensor_i2c.begin();
+    sensor_io.begin(TRIG_PIN, ECHO_PIN);
+    sensor_io.attachEcho();
+
+    stats_i2c.begin();
+    stats_io.begin();
+    hist_i2c.begin();
+    hist_io.begin();
+    background.begin();
+
+    sensor_i2c.attach(&stats_i2c);
+    sensor_i2c.attach(&hist_i2c);
+    sensor_i2c.attach(&background);
+    sensor_io.attach(&stats_io);
+    sensor_io.attach(&hist_io);
+
+    console.begin(&Serial);
+    console.add("front", &sensor_i2c);
+    console.add("rear", &sensor_io);
+    console.add("front_stats", &stats_i2c);
+    console.add("rear_stats", &stats_io);
+    console.add("front_hist", &hist_i2c);
+    console.add("rear_hist", &hist_io);
+    console.add("front_bg", &background);
+    console.onSpeed([](uint32_t hz, void *context) -> uint8_t {
+        (void)context;
+        return sensor_i2c.setSpeed(hz);
+    });
+
+    Serial.println("Unit Sonic console - type help");
+}
+
+void loop() {
+    sensor_i2c.readingAvailable();
+    sensor_io.readingAvailable();
+    console.service(&Serial);
+}
@@ -0,0 +1,55 @@
+/*
+    Publishes the readings of an I2C Unit Sonic to an MQTT broker (e.g. Mosquitto) in InfluxDB line protocol.
+
+    Needs the PubSubClient library.  Readings are summarised per sensor and published at most every 250ms,
+    only when the distance moved by 5mm or once every 10s, so the broker sees a few lines per second while
+    the sensor keeps measuring as fast as it can - a slow or lost connection never blocks the loop.
+    Telegraf can feed them into InfluxDB with an mqtt_consumer input using data_format = "influx".
+*/
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <Unit_Sonic.h>
+#include <Unit_Sonic_Publisher.h>
+
+#define WIFI_SSID "your-ssid"
+#define WIFI_PASSWORD "your-password"
+#define MQTT_BROKER "192.168.1.10"
+
+SONIC_I2C sensor;
+
+WiFiClient wifi;
+PubSubClient mqtt(wifi);
+
+SONIC_PUBLISHER publisher;
+SONIC_PUBLISHER_CHANNEL channel(&publisher, 0);
+
+uint32_t last_connect = 0;
+
+void setup() {
+    Serial.begin(115200);
+    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+    mqtt.setServer(MQTT_BROKER, 1883);
+
+    publisher.begin("sensors/sonic", "sonic", "room=lab");
+    publisher.setDeadband(5000);
+    publisher.setInterval(250, 10000);
+
+    sensor.begin();
+    sensor.attach(&channel);
+}
+
+void loop() {
+    sensor.readingAvailable();
+
+    /* Reconnect at most every 5s - meanwhile the readings keep being summarised */
+    if(!mqtt.connected() && (WiFi.status() == WL_CONNECTED) && ((millis() - last_connect) >= 5000)) {
+        last_connect = millis();
+        mqtt.connect("unit-sonic");
+    }
+
+    if(mqtt.connected()) {
+        publisher.publishTo(mqtt, millis());
+        mqtt.loop();
+    }
+}
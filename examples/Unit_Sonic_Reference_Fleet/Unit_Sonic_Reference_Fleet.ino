@@ -0,0 +1,140 @@
+/*
+    Reference application: a small fleet with filters and a live display, all non-blocking.
+
+    Needs M5Unified, which finds the board, its display and its ports at run time, so the same sketch runs on
+    every M5 controller.  An I2C Unit Sonic on Port A and (on boards that have one) an IO Unit Sonic on Port B
+    measure as fast as they can.  Every reading goes through the sinks attached to its sensor:
+        SONIC_STATS       mean / stddev / P90 per second for each sensor
+        SONIC_BACKGROUND  learns the empty scene in front of the I2C unit and reports objects entering/leaving
+        SONIC_PLOT        one live plot per sensor, drawing only the new columns (boards with a display)
+    Once a second the samples per second of each sensor and of the loop are printed and shown, so the cost of
+    the filters and the display on a given board can be read straight off the screen or the serial monitor.
+*/
+#include <M5Unified.h>
+#include <Unit_Sonic.h>
+#include <Unit_Sonic_Stats.h>
+#include <Unit_Sonic_Background.h>
+#include <Unit_Sonic_Plot.h>
+
+#ifndef ARDUINO_BOARD
+    #define ARDUINO_BOARD "unknown board"
+#endif
+
+/* Counts the readings of the sensor it is attached to */
+class RATE_COUNTER : public SONIC_SINK {
+    public:
+        void onReading(uint32_t distance_um, uint32_t timestamp_ms) override {
+            (void)distance_um;
+            (void)timestamp_ms;
+            readings++;
+        }
+
+        uint32_t readings = 0;
+};
+
+SONIC_I2C sensor_i2c;
+SONIC_IO sensor_io;
+int8_t echo_pin = -1;
+
+SONIC_STATS stats_i2c, stats_io;
+SONIC_BACKGROUND background;
+SONIC_PLOT plot_i2c, plot_io;
+RATE_COUNTER rate_i2c, rate_io;
+
+uint8_t has_display = false;
+int16_t label_y = 0;
+
+/* Reports objects entering and leaving the learned scene */
+void on_background(uint8_t event, uint32_t distance_um, uint32_t timestamp_ms, void *context) {
+    (void)context;
+    if(event == SONIC_BG_EVENT_ENTER) {Serial.printf("%lu: object at %.1fmm\r\n", (unsigned long)timestamp_ms, distance_um / 1000.0f);}
+    if(event == SONIC_BG_EVENT_LEAVE) {Serial.printf("%lu: scene clear\r\n", (unsigned long)timestamp_ms);}
+}
+
+void setup() {
+    M5.begin();
+    Serial.begin(115200);
+
+    /* I2C unit on Port A */
+    sensor_i2c.begin(&Wire, 0x57, M5.getPin(m5::pin_name_t::port_a_sda), M5.getPin(m5::pin_name_t::port_a_scl));
+
+    /* IO unit on Port B, if the board has one */
+    echo_pin = M5.getPin(m5::pin_name_t::port_b_in);
+    if(echo_pin >= 0) {
+        sensor_io.begin(M5.getPin(m5::pin_name_t::port_b_out), echo_pin);
+        sensor_io.attachEcho();
+    }
+
+    stats_i2c.begin();
+    stats_io.begin();
+    background.begin();
+    background.onEvent(on_background);
+
+    sensor_i2c.attach(&rate_i2c);
+    sensor_i2c.attach(&stats_i2c);
+    sensor_i2c.attach(&background);
+    sensor_io.attach(&rate_io);
+    sensor_io.attach(&stats_io);
+
+    /* Two plots above a two line label, sized for whatever display the board has */
+    has_display = M5.Display.width() > 0;
+    if(has_display) {
+        int16_t width = M5.Display.width();
+        int16_t label_height = 2 * M5.Display.fontHeight() + 4;
+        int16_t plot_height = (M5.Display.height() - label_height) / 2 - 2;
+
+        M5.Display.fillScreen(TFT_BLACK);
+        M5.Display.setTextColor(TFT_WHITE, TFT_BLACK);
+        label_y = 2 * (plot_height + 2);
+
+        plot_i2c.begin(0, 0, width, plot_height, 50);
+        plot_i2c.setColors(TFT_ORANGE, TFT_BLACK);
+        plot_i2c.clear(M5.Display);
+        sensor_i2c.attach(&plot_i2c);
+
+        plot_io.begin(0, plot_height + 2, width, plot_height, 50);
+        plot_io.setColors(TFT_CYAN, TFT_BLACK);
+        plot_io.clear(M5.Display);
+        sensor_io.attach(&plot_io);
+    }
+}
+
+uint32_t report_ms = 0;
+uint32_t loops = 0;
+
+void loop() {
+    loops++;
+    sensor_i2c.readingAvailable();
+    if(echo_pin >= 0) {sensor_io.readingAvailable();}
+
+    uint32_t now = millis();
+    if(has_display) {
+        plot_i2c.render(M5.Display, now);
+        plot_io.render(M5.Display, now);
+    }
+
+    uint32_t elapsed = now - report_ms;
+    if(elapsed < 1000) {return;}
+
+    SONIC_STATS_SNAPSHOT i2c, io;
+    stats_i2c.snapshot(&i2c, true);
+    stats_io.snapshot(&io, true);
+
+    float i2c_rate = rate_i2c.readings * 1000.0f / elapsed;
+    float io_rate = rate_io.readings * 1000.0f / elapsed;
+    float loop_rate = loops * 1000.0f / elapsed;
+
+    Serial.printf("[%s] I2C %.1f/s %.1fmm sd %.1f P90 %.1f  IO %.1f/s %.1fmm sd %.1f P90 %.1f  loop %.0f/s\r\n", ARDUINO_BOARD,
+                  i2c_rate, i2c.mean, i2c.stddev, i2c.quantile[1], io_rate, io.mean, io.stddev, io.quantile[1], loop_rate);
+
+    if(has_display) {
+        M5.Display.setCursor(0, label_y);
+        M5.Display.printf("I2C %.0f/s %.0fmm  IO %.0f/s %.0fmm   \n", i2c_rate, i2c.mean, io_rate, io.mean);
+        M5.Display.printf("loop %.0f/s   ", loop_rate);
+    }
+
+    report_ms = now;
+    loops = 0;
+    rate_i2c.readings = 0;
+    rate_io.readings = 0;
+}
@@ -0,0 +1,57 @@
+/*
+    Reference application: maximum rate acquisition.
+
+    Runs an I2C and an IO Unit Sonic back-to-back with nothing else in the loop and prints, once a second,
+    the samples per second each of them delivered and how often the loop ran, together with the board it
+    was built for - use it to see what a board can do before adding anything else to the loop.
+    calibrate() shortens the I2C conversion time for the distance in front of the sensor at start up, so
+    keep the usual target in view while the board boots.
+
+    Wiring: I2C unit on the default Wire pins, IO unit trigger on TRIG_PIN and echo on ECHO_PIN.
+*/
+#include <Arduino.h>
+#include <Unit_Sonic.h>
+
+#define TRIG_PIN 26
+#define ECHO_PIN 36
+
+#ifndef ARDUINO_BOARD
+    #define ARDUINO_BOARD "unknown board"
+#endif
+
+SONIC_I2C sensor_i2c;
+SONIC_IO sensor_io;
+
+uint8_t has_i2c = false;
+
+void setup() {
+    Serial.begin(115200);
+
+    has_i2c = sensor_i2c.begin();
+    if(has_i2c) {sensor_i2c.calibrate();}
+
+    sensor_io.begin(TRIG_PIN, ECHO_PIN);
+    sensor_io.attachEcho();
+}
+
+uint32_t report_ms = 0;
+uint32_t loops = 0;
+uint32_t readings_i2c = 0;
+uint32_t readings_io = 0;
+
+void loop() {
+    loops++;
+    if(has_i2c && sensor_i2c.readingAvailable()) {readings_i2c++;}
+    if(sensor_io.readingAvailable()) {readings_io++;}
+
+    uint32_t elapsed = millis() - report_ms;
+    if(elapsed >= 1000) {
+        Serial.printf("[%s] I2C %.1f samples/s (%.1fmm)  IO %.1f samples/s (%.1fmm)  loop %lu/s\r\n", ARDUINO_BOARD,
+                      readings_i2c * 1000.0f / elapsed, sensor_i2c.getDistance(), readings_io * 1000.0f / elapsed,
+                      sensor_io.getDistance(), (unsigned long)(loops * 1000ULL / elapsed));
+        report_ms += elapsed;
+        loops = 0;
+        readings_i2c = 0;
+        readings_io = 0;
+    }
+}
@@ -0,0 +1,36 @@
+/*
+    Compile time fleet: one I2C and two IO Unit Sonics on an M5Stack Core.
+
+    The pins and the I2C address are template parameters of SONIC_FLEET, so a pin used twice fails the
+    build instead of the robot, the sensors are one static object and fleet.service() polls all of them
+    in an unrolled loop.  Bit i of its result is set if sensor i has a new reading.
+
+    Wiring: I2C unit on Port A (21/22), IO units on Port B (26/36) and Port C (17/16).
+    Needs C++17 (the default of the current ESP32 Arduino core).
+*/
+#include <Arduino.h>
+#include <Unit_Sonic_Fleet.h>
+
+typedef SONIC_FLEET<SONIC_FLEET_I2C<21, 22>, SONIC_FLEET_IO<26, 36>, SONIC_FLEET_IO<17, 16>> ROBOT_FLEET;
+
+ROBOT_FLEET fleet;
+
+void setup() {
+    Serial.begin(115200);
+
+    if(!fleet.begin(&Wire)) {Serial.println("A sensor of the fleet was not detected");}
+}
+
+void loop() {
+    uint32_t ready = fleet.service();
+    if(!ready) {return;}
+
+    /* Print the whole fleet whenever one of the sensors has a new reading */
+    std::array<uint32_t, ROBOT_FLEET::COUNT> distances;
+    fleet.getDistances_um(distances);
+
+    for(uint8_t i = 0; i < ROBOT_FLEET::COUNT; i++) {
+        Serial.printf("%c%6.1fmm  ", (ready & (1UL << i)) ? '*' : ' ', distances[i] / 1000.0);
+    }
+    Serial.printf("\r\n");
+}
@@ -24,10 +24,11 @@ void setup() {
 }
 
 void loop() {
-    static float Distance = 0;
-    Distance              = sensor.getDistance();
-    if ((Distance < 4000) && (Distance > 20)) {
-        Serial.printf("Distance: %.2fmm\r\n", Distance);
+    /* Poll every loop - readingAvailable() returns true once per new measurement */
+    if(sensor.readingAvailable()) {
+        float Distance = sensor.getDistance();
+        if((Distance < 4000) && (Distance > 20)) {
+            Serial.printf("Distance: %.2fmm\r\n", Distance);
+        }
     }
-    delay(100);
 }
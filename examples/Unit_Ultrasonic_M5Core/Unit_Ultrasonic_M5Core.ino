@@ -29,11 +29,12 @@ void setup() {
 }
 
 void loop() {
-    static float newvalue = 0;
-    newvalue              = sensor.getDistance();
-    if ((newvalue < 4000) && (newvalue > 20)) {
-        M5.Lcd.setCursor(105, 27);
-        M5.Lcd.printf("%.2fmm", newvalue);
+    /* Poll every loop and only touch the display when there is a new reading */
+    if(sensor.readingAvailable()) {
+        float newvalue = sensor.getDistance();
+        if((newvalue < 4000) && (newvalue > 20)) {
+            M5.Lcd.setCursor(105, 27);
+            M5.Lcd.printf("%.2fmm  ", newvalue);
+        }
     }
-    delay(100);
 }
@@ -0,0 +1,233 @@
+/*
+    Compression ratio and cost of SONIC_BATCH, the encoding used by the telemetry frames and the flash log.
+
+    A few synthetic reading streams are encoded in 256 byte batches (the telemetry frame size) and compared
+    with the raw readings (1 byte sensor, 4 byte timestamp, 4 byte distance) and with plain per reading varint
+    deltas (the previous SONIC_BATCH layout).  Encode and decode cost is reported per reading.  Every decoded
+    reading is compared with the one encoded - a mismatch is reported and (on the host) exits non-zero.
+
+    The same source runs on the host and on an ESP32: on the host build it as below (or use the CMake host
+    project), on an ESP32 copy it into a sketch folder as batch_codec_bench.ino together with the library.
+        g++ -O2 -Isrc extras/benchmarks/batch_codec_bench.cpp src/Unit_Sonic_Batch.cpp -o batch_codec_bench
+
+    Usage: batch_codec_bench [repeats=200]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "Unit_Sonic_Batch.h"
+
+#if defined(ARDUINO)
+    #include <Arduino.h>
+    #define BENCH_REPEATS 5
+#else
+    #include <time.h>
+    #define BENCH_REPEATS 200
+#endif
+
+#define BENCH_READINGS 2000
+#define BENCH_BATCH 256
+#define BENCH_RAW_SIZE 9
+
+/* One reading of a synthetic stream */
+struct bench_reading {
+    uint8_t sensor;
+    uint32_t distance_um;
+    uint32_t timestamp_ms;
+};
+
+static bench_reading bench_stream[BENCH_READINGS];
+static uint32_t bench_random_state = 1;
+
+/* Private function for a deterministic pseudo random number (xorshift32) */
+static uint32_t bench_random() {
+    bench_random_state ^= bench_random_state << 13;
+    bench_random_state ^= bench_random_state >> 17;
+    bench_random_state ^= bench_random_state << 5;
+    return bench_random_state;
+}
+
+/* Private function to get a monotonic time in us */
+static uint32_t bench_micros() {
+    #if defined(ARDUINO)
+        return micros();
+    #else
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (uint32_t)(now.tv_sec * 1000000ULL + now.tv_nsec / 1000);
+    #endif
+}
+
+/* Private function to print a line of results */
+static void bench_print(const char* line) {
+    #if defined(ARDUINO)
+        Serial.println(line);
+    #else
+        puts(line);
+    #endif
+}
+
+/* Private function to fill the stream with one of the scenarios - returns its name */
+static const char* bench_generate(uint8_t scenario) {
+    uint32_t timestamp = 1000;
+    int32_t walk[25] = {0};
+
+    bench_random_state = scenario + 1;
+    for(uint32_t i = 0; i < BENCH_READINGS; i++) {
+        bench_reading& reading = bench_stream[i];
+
+        switch(scenario) {
+            case 0:     //One sensor measuring back-to-back in front of a wall (jitter 0..1ms, noise +-50um)
+                timestamp += 30 + (bench_random() & 1);
+                reading.sensor = 0;
+                reading.distance_um = 1250000 + (bench_random() % 101) - 50;
+                break;
+            case 1:     //One sensor following a target moving back and forth
+                timestamp += 30 + (bench_random() & 1);
+                reading.sensor = 0;
+                reading.distance_um = (uint32_t)(1500000 + 800000 * sin(i / 100.0)) + (bench_random() % 401) - 200;
+                break;
+            case 2:     //8 sensors measured round robin by a reactor (10ms apart, noise +-500um)
+                timestamp += (i % 8) ? 10 : 30;
+                reading.sensor = i % 8;
+                reading.distance_um = 600000 + reading.sensor * 100000 + (bench_random() % 1001) - 500;
+                break;
+            default:    //25 sensors logged every 5s, random walk of +-1mm (extras/benchmarks/log_query_bench.cpp)
+                if(!(i % 25)) {timestamp += 5000 - 24;} else {timestamp++;}
+                reading.sensor = i % 25;
+                walk[reading.sensor] += (int32_t)(bench_random() % 2001) - 1000;
+                reading.distance_um = 1000000 + walk[reading.sensor];
+                break;
+        }
+        reading.timestamp_ms = timestamp;
+    }
+
+    static const char* names[4] = {"still", "moving", "fleet-8", "walk-25"};
+    return names[scenario];
+}
+
+/* Private function for the size of the stream as plain per reading varint deltas */
+static uint32_t bench_varint_size() {
+    uint8_t scratch[SONIC_VARINT_MAX];
+    uint32_t previous[SONIC_BATCH_MAX_SENSORS] = {0};
+    uint32_t timestamp = bench_stream[0].timestamp_ms;
+    uint32_t size = SONIC_CODEC::putVarint(scratch, timestamp);
+
+    for(uint32_t i = 0; i < BENCH_READINGS; i++) {
+        const bench_reading& reading = bench_stream[i];
+
+        size += SONIC_CODEC::putVarint(scratch, reading.sensor);
+        size += SONIC_CODEC::putVarint(scratch, SONIC_CODEC::zigzag((int32_t)(reading.timestamp_ms - timestamp)));
+        size += SONIC_CODEC::putVarint(scratch, SONIC_CODEC::zigzag((int32_t)(reading.distance_um - previous[reading.sensor])));
+        timestamp = reading.timestamp_ms;
+        previous[reading.sensor] = reading.distance_um;
+    }
+    return size;
+}
+
+/* Private function to count the decoded readings */
+static void bench_count(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms, void* context) {
+    (void)sensor;
+    (void)distance_um;
+    (void)timestamp_ms;
+    (*(uint32_t*)context)++;
+}
+
+/* Progress of the verifying decode - the next reading of the stream expected */
+struct bench_check {
+    uint32_t next;
+    uint8_t wrong;
+};
+
+/* Private function to compare a decoded reading with the one encoded */
+static void bench_verify(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms, void* context) {
+    bench_check* check = (bench_check*)context;
+
+    if(check->next >= BENCH_READINGS) {
+        check->wrong = true;
+        return;
+    }
+
+    const bench_reading& reading = bench_stream[check->next++];
+    if((sensor != reading.sensor) || (distance_um != reading.distance_um) || (timestamp_ms != reading.timestamp_ms)) {check->wrong = true;}
+}
+
+/* Private function to run one scenario - returns false if the readings don't decode back to the stream */
+static uint8_t bench_run(uint8_t scenario, uint32_t repeats) {
+    static uint8_t batches[BENCH_READINGS][BENCH_BATCH];
+    static uint16_t lengths[BENCH_READINGS];
+    const char* name = bench_generate(scenario);
+    uint32_t count = 0;
+    uint32_t size = 0;
+    uint32_t decoded = 0;
+    SONIC_BATCH batch;
+
+    /* Encode the stream into full batches, as the telemetry and the log do */
+    uint32_t started = bench_micros();
+    for(uint32_t repeat = 0; repeat < repeats; repeat++) {
+        count = 0;
+        batch.start(batches[0], BENCH_BATCH);
+        for(uint32_t i = 0; i < BENCH_READINGS; i++) {
+            const bench_reading& reading = bench_stream[i];
+
+            if(!batch.add(reading.sensor, reading.distance_um, reading.timestamp_ms)) {
+                lengths[count++] = batch.getLength();
+                batch.start(batches[count], BENCH_BATCH);
+                batch.add(reading.sensor, reading.distance_um, reading.timestamp_ms);
+            }
+        }
+        lengths[count++] = batch.getLength();
+    }
+    uint32_t encode_us = bench_micros() - started;
+
+    for(uint32_t i = 0; i < count; i++) {size += lengths[i];}
+
+    started = bench_micros();
+    for(uint32_t repeat = 0; repeat < repeats; repeat++) {
+        decoded = 0;
+        for(uint32_t i = 0; i < count; i++) {SONIC_BATCH::decode(batches[i], lengths[i], bench_count, &decoded);}
+    }
+    uint32_t decode_us = bench_micros() - started;
+
+    /* Decode once more (untimed) and compare every reading with its input */
+    bench_check check = {0, false};
+    for(uint32_t i = 0; i < count; i++) {
+        if(!SONIC_BATCH::decode(batches[i], lengths[i], bench_verify, &check)) {check.wrong = true;}
+    }
+    uint8_t ok = !check.wrong && (check.next == BENCH_READINGS) && (decoded == BENCH_READINGS);
+
+    uint32_t varint = bench_varint_size();
+    double readings = (double)BENCH_READINGS * repeats;
+    char line[160];
+
+    snprintf(line, sizeof(line), "%-8s %5.2f B/reading (x%4.1f raw, x%4.2f varint)  encode %7.1f ns  decode %7.1f ns%s",
+             name, (double)size / BENCH_READINGS, (double)BENCH_RAW_SIZE * BENCH_READINGS / size, (double)varint / size,
+             encode_us * 1000.0 / readings, decode_us * 1000.0 / readings, ok ? "" : "  DECODE MISMATCH");
+    bench_print(line);
+    return ok;
+}
+
+/* Private function to run all scenarios - returns false if any of them didn't decode back to its stream */
+static uint8_t bench_all(uint32_t repeats) {
+    uint8_t ok = true;
+
+    bench_print("stream   size per reading and ratio to raw / varint deltas, cost per reading");
+    for(uint8_t scenario = 0; scenario < 4; scenario++) {
+        if(!bench_run(scenario, repeats)) {ok = false;}
+    }
+    return ok;
+}
+
+#if defined(ARDUINO)
+    void setup() {
+        Serial.begin(115200);
+        delay(1000);
+        bench_all(BENCH_REPEATS);
+    }
+
+    void loop() {}
+#else
+    int main(int argc, char** argv) {
+        return bench_all((argc > 1) ? strtoul(argv[1], nullptr, 10) : BENCH_REPEATS) ? 0 : 1;
+    }
+#endif
@@ -0,0 +1,164 @@
+/*
+    Soak run of both sensors across several micros()/millis() wraps, at accelerated virtual time.
+
+    Starts a few seconds before the millis() wrap (which is also a micros() wrap) and polls a SONIC_FLEET of one
+    I2C and one IO sensor on the Arduino or ESP-IDF host mock:
+        - dense: polls every step_us for the given number of micros() wraps (~71.6 minutes each) - every reading
+          must be the target distance and no sensor may go longer than SOAK_WRAP_MAX_GAP_US without one
+        - idle: after a reading, the sensors aren't polled for a full millis() wrap (~49.7 days, only the clock
+          keeps running as it would for the rest of the application) - the first poll after it must trigger
+          right away instead of being held by the interval of a stale timestamp
+    Exits with 1 if any check failed, so it can run in CI.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -std=gnu++17 -O2 -DARDUINO=10800 -Isrc -Iextras/mock -Iextras/mock/arduino extras/benchmarks/clock_wrap_soak.cpp \
+            src/Unit_Sonic.cpp src/Unit_Sonic_Core.cpp src/Unit_Sonic_Clock.cpp src/Unit_Sonic_Correction.cpp \
+            src/Unit_Sonic_Burst.cpp extras/mock/host_mock.cpp extras/mock/arduino/arduino_mock.cpp -o clock_wrap_soak_arduino
+
+    Usage: clock_wrap_soak [wraps=3] [step_us=250]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "Unit_Sonic_Fleet.h"
+#include "Unit_Sonic_Clock.h"
+#include "host_mock.h"
+
+#if !defined(SONIC_HAVE_FLEET)
+    #error "clock_wrap_soak must be built as C++17 against the Arduino or the ESP-IDF mock"
+#endif
+
+#if defined(SONIC_PLATFORM_ARDUINO)
+    #define SOAK_ADAPTER "arduino"
+    #define SOAK_BUS (&Wire)
+#else
+    #define SOAK_ADAPTER "esp-idf"
+    #define SOAK_BUS nullptr
+#endif
+
+#define SOAK_TRIG_PIN 26
+#define SOAK_ECHO_PIN 32
+
+#define SOAK_WRAP_MICROS_US 0x100000000ULL                     //micros() wraps after 2^32us
+#define SOAK_WRAP_MILLIS_US (0x100000000ULL * 1000ULL)         //millis() wraps after 2^32ms
+#define SOAK_WRAP_MAX_GAP_US 250000                            //Longest time a polled sensor may go without a reading
+#define SOAK_WRAP_INTERVAL_MS 1000                             //Interval of the idle check
+#define SOAK_WRAP_IDLE_STEP_US 3600000000UL                    //Clock ticks during the idle phase (1h, below a micros() wrap)
+
+typedef SONIC_FLEET<SONIC_FLEET_I2C<21, 22, MOCK_SONIC_ADDR>, SONIC_FLEET_IO<SOAK_TRIG_PIN, SOAK_ECHO_PIN>> soak_fleet;
+
+/* Per sensor bookkeeping */
+struct soak_sensor {
+    const char* name;
+    uint32_t expected_um;
+    uint32_t previous_um;       //A measurement in flight when the target changes still reports the old one
+    uint64_t last_us;
+    uint64_t max_gap_us;
+    uint32_t readings;
+};
+
+static soak_fleet fleet;
+static uint32_t soak_failures = 0;
+
+/* Private function to report a failed check (only the first few are printed) */
+static void soak_fail(const char* what, const soak_sensor& sensor, uint32_t value) {
+    if(++soak_failures <= 10) {printf("FAIL %s %s: %u at %llu us\n", sensor.name, what, (unsigned)value, (unsigned long long)mock_now_us());}
+}
+
+/* Private function to get the distance the fake sensor's echo reports (it is timed in whole us) */
+static uint32_t soak_echo_um(uint32_t distance_um) {
+    uint64_t width_us = ((uint64_t)distance_um * 2) / 343;
+    return U32_SONIC_PULSE_NS_TO_UM(width_us * 1000);
+}
+
+/* Private function to set the target and the distances each sensor must report for it */
+static void soak_target(soak_sensor* sensors, uint32_t distance_um) {
+    mock_set_distance_um(distance_um);
+    sensors[0].previous_um = sensors[0].expected_um;
+    sensors[0].expected_um = distance_um;
+    sensors[1].previous_um = sensors[1].expected_um;
+    sensors[1].expected_um = soak_echo_um(distance_um);
+}
+
+/* Private function to check one new reading */
+static void soak_reading(soak_sensor& sensor, uint32_t distance_um) {
+    uint64_t now = mock_now_us();
+
+    if((distance_um != sensor.expected_um) && (distance_um != sensor.previous_um)) {soak_fail("wrong distance", sensor, distance_um);}
+    sensor.previous_um = sensor.expected_um;
+    if(sensor.readings && (now - sensor.last_us > sensor.max_gap_us)) {sensor.max_gap_us = now - sensor.last_us;}
+    sensor.last_us = now;
+    sensor.readings++;
+}
+
+/* Private function to poll the fleet once and check whatever it collected */
+static void soak_service(soak_sensor* sensors) {
+    uint32_t ready = fleet.service();
+    if(ready & 0x01) {soak_reading(sensors[0], fleet.get<0>().getDistance_um());}
+    if(ready & 0x02) {soak_reading(sensors[1], fleet.get<1>().getDistance_um());}
+}
+
+int main(int argc, char** argv) {
+    uint32_t wraps = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 3;
+    uint32_t step_us = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 250;
+    if(!step_us) {step_us = 1;}
+
+    soak_sensor sensors[soak_fleet::COUNT] = {{"i2c", 0, 0, 0, 0, 0}, {"io", 0, 0, 0, 0, 0}};
+
+    mock_reset(SOAK_WRAP_MILLIS_US - 5000000);
+    mock_gpio_set_echo(SOAK_TRIG_PIN, SOAK_ECHO_PIN);
+    if(!fleet.begin(SOAK_BUS)) {
+        printf("fleet could not be set up\n");
+        return 1;
+    }
+
+    /* Dense phase - a different target per micros() wrap */
+    for(uint32_t wrap = 0; wrap < wraps; wrap++) {
+        uint64_t end = mock_now_us() + SOAK_WRAP_MICROS_US;
+        soak_target(sensors, 300000 + (wrap % 10) * 400000);
+
+        for(uint8_t i = 0; i < soak_fleet::COUNT; i++) {
+            sensors[i].max_gap_us = 0;
+            sensors[i].last_us = mock_now_us();
+        }
+        uint32_t readings[soak_fleet::COUNT] = {sensors[0].readings, sensors[1].readings};
+
+        while(mock_now_us() < end) {
+            soak_service(sensors);
+            mock_advance_us(step_us);
+        }
+
+        for(uint8_t i = 0; i < soak_fleet::COUNT; i++) {
+            if(sensors[i].max_gap_us > SOAK_WRAP_MAX_GAP_US) {soak_fail("gap between readings (us)", sensors[i], (uint32_t)sensors[i].max_gap_us);}
+            printf("%-8s wrap %u %-4s readings=%u max gap=%.1fms\n", SOAK_ADAPTER, (unsigned)wrap, sensors[i].name,
+                   (unsigned)(sensors[i].readings - readings[i]), sensors[i].max_gap_us / 1000.0);
+        }
+    }
+
+    /* 
+        Idle phase - settle on the interval, stop polling right after the last measurement finished and come back
+        exactly one millis() wrap later, when a 32 bit trigger time would put the sensors back inside the interval
+    */
+    fleet.forEach([](auto& sensor, uint8_t) {sensor.setInterval(SOAK_WRAP_INTERVAL_MS);});
+    uint64_t settle = mock_now_us() + 2ULL * SOAK_WRAP_INTERVAL_MS * 1000;
+    while((mock_now_us() < settle) || fleet.get<0>().getStatus() || fleet.get<1>().getStatus()) {
+        soak_service(sensors);
+        mock_advance_us(step_us);
+    }
+
+    for(uint64_t idle = SOAK_WRAP_MILLIS_US; idle; ) {
+        uint32_t step = (idle < SOAK_WRAP_IDLE_STEP_US) ? (uint32_t)idle : SOAK_WRAP_IDLE_STEP_US;
+        mock_advance_us(step);
+        SONIC_CLOCK::micros64();
+        idle -= step;
+    }
+
+    SONIC_COUNTERS before[soak_fleet::COUNT] = {*fleet.get<0>().getCounters(), *fleet.get<1>().getCounters()};
+    fleet.service();
+    const SONIC_COUNTERS* after[soak_fleet::COUNT] = {fleet.get<0>().getCounters(), fleet.get<1>().getCounters()};
+    for(uint8_t i = 0; i < soak_fleet::COUNT; i++) {
+        if(after[i]->triggers == before[i].triggers) {soak_fail("held after the idle wrap, triggers", sensors[i], after[i]->triggers);}
+    }
+
+    printf("%-8s %u micros() wraps, 1 idle millis() wrap: %s\n", SOAK_ADAPTER, (unsigned)wraps, soak_failures ? "FAILED" : "passed");
+    return soak_failures ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+/*
+    Coroutine overhead of SONIC_EXECUTOR compared to the plain readingAvailable() poll loop.
+
+    Both variants drive the same simulated sensors (Unit_Sonic_Sim.h) over the same virtual time, polling
+    every step_us, so the difference is the cost of suspending/resuming the coroutine and of the executor
+    queue.  The size of the coroutine frame is taken from the allocation made when the task starts.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -std=gnu++20 -O2 -Isrc extras/benchmarks/coro_bench.cpp src/Unit_Sonic_Sim.cpp src/Unit_Sonic_Core.cpp \
+            src/Unit_Sonic_Correction.cpp src/Unit_Sonic_Burst.cpp -o coro_bench
+
+    Usage: coro_bench [readings=20000] [step_us=100]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <new>
+#include "Unit_Sonic_Sim.h"
+
+#if !defined(SONIC_HAVE_COROUTINES)
+    #error "coro_bench needs a compiler with C++20 coroutine support"
+#endif
+
+/* Size of the last heap allocation - used to report the coroutine frame size */
+static size_t last_allocation = 0;
+
+#if defined(__GNUC__) && !defined(__clang__)
+    #pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void* operator new(size_t size) {
+    last_allocation = size;
+    void* memory = malloc(size ? size : 1);
+    if(!memory) {throw std::bad_alloc();}
+    return memory;
+}
+
+void operator delete(void* memory) noexcept {free(memory);}
+void operator delete(void* memory, size_t size) noexcept {(void)size; free(memory);}
+
+/* Private function to get the CPU time used by this thread in ns */
+static uint64_t bench_cpu_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static uint64_t checksum = 0;
+
+/* The coroutine under test - one awaited measurement per reading */
+template <typename SENSOR>
+static SONIC_TASK ranging(SONIC_EXECUTOR& executor, SENSOR& sensor, uint32_t readings) {
+    for(uint32_t i = 0; i < readings; i++) {checksum += co_await executor.measure(sensor);}
+}
+
+template <typename SENSOR>
+static void bench_poll(const char* name, SENSOR& sensor, uint32_t readings, uint32_t step_us) {
+    uint64_t polls = 0;
+    uint64_t started = bench_cpu_nanos();
+    checksum = 0;
+
+    for(uint32_t delivered = 0; delivered < readings; polls++) {
+        if(sensor.readingAvailable()) {
+            checksum += sensor.getDistance_um();
+            delivered++;
+        } else {
+            SONIC_SIM_CLOCK::advance_us(step_us);
+        }
+    }
+
+    uint64_t elapsed = bench_cpu_nanos() - started;
+    printf("%-4s poll loop  cpu/reading=%7.1fns cpu/poll=%5.1fns (checksum %llu)\n",
+           name, (double)elapsed / readings, (double)elapsed / polls, (unsigned long long)checksum);
+}
+
+template <typename SENSOR>
+static void bench_coro(const char* name, SENSOR& sensor, uint32_t readings, uint32_t step_us) {
+    SONIC_SIM_EXECUTOR executor;
+    checksum = 0;
+
+    uint64_t started = bench_cpu_nanos();
+    SONIC_TASK task = ranging(executor, sensor, readings);
+    size_t frame = last_allocation;
+    uint8_t completed = executor.run(step_us, 0xFFFFFFFF);
+    uint64_t elapsed = bench_cpu_nanos() - started;
+
+    printf("%-4s coroutine  cpu/reading=%7.1fns frame=%zu bytes%s (checksum %llu)\n",
+           name, (double)elapsed / readings, frame, (completed && task.done()) ? "" : " TIMED OUT", (unsigned long long)checksum);
+}
+
+int main(int argc, char** argv) {
+    uint32_t readings = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20000;
+    uint32_t step_us = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 100;
+
+    /* Start away from 0ms, which the cores treat as a stopped timer */
+    SONIC_SIM_CLOCK::set_us(1000);
+
+    SONIC_I2C_SIM sonic_i2c;
+    SONIC_IO_SIM sonic_io;
+
+    sonic_i2c.setTarget(1234567);
+    sonic_io.setTarget(1234567);
+
+    /* Read as soon as the simulated chip is done, so the loop is dominated by the reading path */
+    for(uint8_t band = 0; band < SONIC_I2C_BANDS; band++) {sonic_i2c.setConversionTime(band, 30);}
+
+    bench_poll("i2c", sonic_i2c, readings, step_us);
+    bench_coro("i2c", sonic_i2c, readings, step_us);
+    bench_poll("io", sonic_io, readings, step_us);
+    bench_coro("io", sonic_io, readings, step_us);
+    return 0;
+}
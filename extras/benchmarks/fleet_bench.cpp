@@ -0,0 +1,101 @@
+/*
+    Cost of servicing a compile time SONIC_FLEET against a runtime configured set of the same sensors.
+
+    The runtime set is what a fleet read from a config file ends up as: a table of sensor pointers and poll
+    trampolines (like SONIC_REQUEST::POLL) walked in a loop.  SONIC_FLEET::service() polls the same sensors
+    through an unrolled fold over its tuple.  Both run on the Arduino or ESP-IDF host mocks with one I2C and
+    one IO sensor, so the numbers are the adapter and dispatch overhead only.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -std=gnu++17 -O2 -DARDUINO=10800 -Isrc -Iextras/mock -Iextras/mock/arduino extras/benchmarks/fleet_bench.cpp \
+            src/Unit_Sonic.cpp src/Unit_Sonic_Core.cpp src/Unit_Sonic_Clock.cpp src/Unit_Sonic_Correction.cpp src/Unit_Sonic_Burst.cpp \
+            extras/mock/host_mock.cpp extras/mock/arduino/arduino_mock.cpp -o fleet_bench_arduino
+
+    Usage: fleet_bench [polls=2000000] [poll_us=50]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Unit_Sonic_Fleet.h"
+#include "host_mock.h"
+
+#if !defined(SONIC_HAVE_FLEET)
+    #error "fleet_bench must be built as C++17 against the Arduino or the ESP-IDF mock"
+#endif
+
+#if defined(SONIC_PLATFORM_ARDUINO)
+    #define BENCH_ADAPTER "arduino"
+    #define BENCH_BUS (&Wire)
+#else
+    #define BENCH_ADAPTER "esp-idf"
+    #define BENCH_BUS nullptr
+#endif
+
+#define BENCH_TRIG_PIN 26
+#define BENCH_ECHO_PIN 32
+
+typedef SONIC_FLEET<SONIC_FLEET_I2C<21, 22, MOCK_SONIC_ADDR>, SONIC_FLEET_IO<BENCH_TRIG_PIN, BENCH_ECHO_PIN>> bench_fleet;
+
+/* One entry of the runtime configured set */
+struct bench_entry {
+    void* sensor;
+    uint8_t (*poll)(void* sensor);
+};
+
+static bench_fleet fleet;
+
+/* Private function to get the CPU time used by this thread in ns */
+static uint64_t bench_cpu_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* Private poll trampoline of the runtime set */
+template <typename SENSOR>
+static uint8_t bench_poll(void* sensor) {return ((SENSOR*)sensor)->readingAvailable();}
+
+/* Private function to print one result */
+static void bench_print(const char* name, uint64_t elapsed, uint32_t polls, uint32_t readings) {
+    printf("%-8s %-8s polls=%u readings=%u cpu/service=%.1fns\n", BENCH_ADAPTER, name, polls, readings, (double)elapsed / polls);
+}
+
+int main(int argc, char** argv) {
+    uint32_t polls = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 2000000;
+    uint32_t poll_us = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 50;
+
+    mock_set_distance_um(1234567);
+    mock_gpio_set_echo(BENCH_TRIG_PIN, BENCH_ECHO_PIN);
+    if(!fleet.begin(BENCH_BUS)) {
+        printf("fleet could not be set up\n");
+        return 1;
+    }
+
+    /* The runtime set polls the very same sensor objects */
+    bench_entry entries[bench_fleet::COUNT] = {
+        {&fleet.get<0>(), bench_poll<SONIC_I2C>},
+        {&fleet.get<1>(), bench_poll<SONIC_IO>},
+    };
+    bench_entry* volatile table = entries;
+
+    uint32_t readings = 0;
+    uint64_t started = bench_cpu_nanos();
+    for(uint32_t i = 0; i < polls; i++) {
+        for(uint8_t j = 0; j < bench_fleet::COUNT; j++) {readings += table[j].poll(table[j].sensor);}
+        mock_advance_us(poll_us);
+    }
+    bench_print("runtime", bench_cpu_nanos() - started, polls, readings);
+
+    readings = 0;
+    started = bench_cpu_nanos();
+    for(uint32_t i = 0; i < polls; i++) {
+        for(uint32_t ready = fleet.service(); ready; ready &= ready - 1) {readings++;}
+        mock_advance_us(poll_us);
+    }
+    bench_print("fleet", bench_cpu_nanos() - started, polls, readings);
+
+    std::array<uint32_t, bench_fleet::COUNT> distances;
+    fleet.getDistances_um(distances);
+    printf("distances %u um / %u um, %u bytes of sensor state\n", (unsigned)distances[0], (unsigned)distances[1], (unsigned)sizeof(fleet));
+    return 0;
+}
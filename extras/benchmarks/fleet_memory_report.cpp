@@ -0,0 +1,105 @@
+/*
+    RAM footprint of a sensor fleet.
+
+    Prints the size of every per-sensor class (the cores, the platform adapters and the common sinks) and what
+    a fleet of BENCH_SENSORS sensors costs with and without a SONIC_STATS per sensor.  The burst buffers are
+    shared (SONIC_BURST_POOL of them) and are counted once for the whole fleet.  The cores and the Arduino/IDF
+    adapters are also checked at compile time against SONIC_I2C_CORE_BYTES / SONIC_IO_CORE_BYTES and
+    SONIC_I2C_BYTES / SONIC_IO_BYTES, this shows where the rest of the RAM goes.
+
+    The same source runs on the host and on an ESP32: on the host build it as below (or use the CMake host
+    project), on an ESP32 copy it into a sketch folder as fleet_memory_report.ino together with the library.
+        g++ -O2 -Isrc extras/benchmarks/fleet_memory_report.cpp src/Unit_Sonic_Burst.cpp -o fleet_memory_report
+
+    Usage: fleet_memory_report [sensors=64]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "Unit_Sonic.h"
+#include "Unit_Sonic_Stats.h"
+#include "Unit_Sonic_Background.h"
+#include "Unit_Sonic_Histogram.h"
+
+#if defined(ARDUINO)
+    #include <Arduino.h>
+#endif
+
+#define BENCH_SENSORS 64
+
+/* The adapters of the platform this is built for (the bare IO core on Linux builds without libgpiod) */
+#if defined(SONIC_PLATFORM_LINUX)
+    typedef SONIC_I2C_LINUX bench_i2c;
+    #if defined(SONIC_HAVE_GPIOD)
+        typedef SONIC_IO_LINUX bench_io;
+    #else
+        typedef SONIC_IO_CORE bench_io;
+    #endif
+#else
+    typedef SONIC_I2C bench_i2c;
+    typedef SONIC_IO bench_io;
+#endif
+
+/* Private function to print a line of results */
+static void bench_print(const char* line) {
+    #if defined(ARDUINO)
+        Serial.println(line);
+    #else
+        puts(line);
+    #endif
+}
+
+/* Private function to print the size of one class */
+static void bench_size(const char* name, uint32_t size) {
+    char line[80];
+
+    snprintf(line, sizeof(line), "%-20s %6u B", name, (unsigned)size);
+    bench_print(line);
+}
+
+/* Private function to print the cost of a fleet */
+static void bench_fleet(const char* name, uint32_t sensors, uint32_t per_sensor) {
+    char line[120];
+    uint32_t pool = SONIC_BURST_POOL * sizeof(SONIC_BURST);
+
+    snprintf(line, sizeof(line), "%-20s %6u B  (%u x %u B + %u B burst pool)", name, (unsigned)(sensors * per_sensor + pool),
+             (unsigned)sensors, (unsigned)per_sensor, (unsigned)pool);
+    bench_print(line);
+}
+
+/* Private function to print the whole report */
+static void bench_all(uint32_t sensors) {
+    char line[80];
+
+    snprintf(line, sizeof(line), "%u bit target, %u sensors", (unsigned)(sizeof(void*) * 8), (unsigned)sensors);
+    bench_print(line);
+
+    bench_size("SONIC_I2C_CORE", sizeof(SONIC_I2C_CORE));
+    bench_size("SONIC_IO_CORE", sizeof(SONIC_IO_CORE));
+    bench_size("I2C adapter", sizeof(bench_i2c));
+    bench_size("IO adapter", sizeof(bench_io));
+    bench_size("SONIC_BURST (shared)", sizeof(SONIC_BURST));
+    bench_size("SONIC_STATS", sizeof(SONIC_STATS));
+    bench_size("SONIC_BACKGROUND", sizeof(SONIC_BACKGROUND));
+    bench_size("SONIC_HISTOGRAM", sizeof(SONIC_HISTOGRAM));
+
+    bench_print("");
+    bench_fleet("I2C fleet", sensors, sizeof(bench_i2c));
+    bench_fleet("IO fleet", sensors, sizeof(bench_io));
+    bench_fleet("I2C fleet + stats", sensors, sizeof(bench_i2c) + sizeof(SONIC_STATS));
+    bench_fleet("IO fleet + stats", sensors, sizeof(bench_io) + sizeof(SONIC_STATS));
+}
+
+#if defined(ARDUINO)
+    void setup() {
+        Serial.begin(115200);
+        delay(1000);
+        bench_all(BENCH_SENSORS);
+    }
+
+    void loop() {}
+#else
+    int main(int argc, char** argv) {
+        bench_all((argc > 1) ? strtoul(argv[1], nullptr, 10) : BENCH_SENSORS);
+        return 0;
+    }
+#endif
@@ -0,0 +1,236 @@
+/*
+    Benchmark for SONIC_LINUX_REACTOR.
+
+    Drives a fleet of fake Unit Sonic I2C sensors (the i2c-dev transfer is replaced, the conversion
+    timers are real timerfds) and then a fleet of fake Unit Sonic IO sensors (the libgpiod mock, whose
+    request fds are pipes - an echo thread writes the edges) from one reactor thread and reports for each:
+      - CPU time (user + system, the echo thread included) per 1000 delivered readings
+      - I2C: latency from the end of the conversion time to the reading being delivered (p50/p99/p99.9/max)
+      - IO: latency from the falling echo edge to the reading being delivered (p50/p99/p99.9/max)
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -O2 -DSONIC_HAVE_GPIOD -Isrc -Iextras/mock/gpiod extras/benchmarks/linux_reactor_bench.cpp \
+            src/Unit_Sonic_LinuxReactor.cpp src/Unit_Sonic_LinuxI2C.cpp src/Unit_Sonic_LinuxGPIO.cpp \
+            src/Unit_Sonic_Core.cpp src/Unit_Sonic_Clock.cpp src/Unit_Sonic_Correction.cpp \
+            src/Unit_Sonic_Burst.cpp extras/mock/gpiod/gpiod_mock.cpp -pthread -o linux_reactor_bench
+
+    Usage: linux_reactor_bench [sensors=200] [readings=100000] [conversion_ms=5]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include "Unit_Sonic_LinuxReactor.h"
+#include "gpiod.h"
+
+#define BENCH_ECHO_DELAY_NS 200000ULL       //Trigger to rising edge
+#define BENCH_ECHO_NS 1000000ULL            //Trigger to falling edge (~17cm)
+
+/* Private function to get the monotonic time in ns */
+static uint64_t bench_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* Private function to get the CPU time used by this process in ns */
+static uint64_t bench_cpu_nanos() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return ((uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1000ULL;
+}
+
+/* Fake RCWL-9620 - remembers when the conversion should be done and answers with a fixed distance */
+class FAKE_SONIC_I2C : public SONIC_I2C_LINUX {
+    public:
+        uint64_t deadline = 0;
+        uint32_t conversion_ns = 0;
+
+    protected:
+        int transfer(struct i2c_msg* msgs, uint32_t count) override {
+            if(msgs[0].flags & I2C_M_RD) {
+                uint32_t distance = 1000000 + _addr * 1000;
+                msgs[0].buf[0] = distance >> 16;
+                msgs[0].buf[1] = distance >> 8;
+                msgs[0].buf[2] = distance;
+            } else if(msgs[0].len) {
+                deadline = bench_nanos() + conversion_ns;
+            }
+            return count;
+        }
+};
+
+/* Fake RCWL-9620 IO echo - due when the echo thread has to play it, falling when it played the falling edge */
+struct FAKE_SONIC_ECHO {
+    std::atomic<uint64_t> due{0};
+    std::atomic<uint64_t> falling{0};
+};
+
+struct BENCH {
+    std::vector<FAKE_SONIC_I2C> *sensors;
+    FAKE_SONIC_ECHO *echoes;
+    std::vector<int> echo_ids;          //Sensor id by request fd
+    std::vector<uint32_t> latency_ns;
+};
+
+/* Reading callback (I2C) - records the delay between the end of the conversion and the delivery */
+static void bench_reading(int id, uint32_t distance_um, void *context) {
+    BENCH *bench = (BENCH *)context;
+    (void)distance_um;
+    bench->latency_ns.push_back((uint32_t)(bench_nanos() - (*bench->sensors)[id].deadline));
+}
+
+/* Reading callback (IO) - records the delay between the falling echo edge and the delivery */
+static void bench_echo_reading(int id, uint32_t distance_um, void *context) {
+    BENCH *bench = (BENCH *)context;
+    (void)distance_um;
+    bench->latency_ns.push_back((uint32_t)(bench_nanos() - bench->echoes[id].falling.load(std::memory_order_acquire)));
+}
+
+/* Trigger pulse hook (reactor thread) - schedules the echo of that sensor */
+static void bench_pulse(int request_fd, void *context) {
+    BENCH *bench = (BENCH *)context;
+    bench->echoes[bench->echo_ids[request_fd]].due.store(bench_nanos() + BENCH_ECHO_NS, std::memory_order_release);
+}
+
+/* Echo thread - plays the due echoes, the falling edge timestamped with the time it is written */
+static void bench_echo_thread(BENCH *bench, std::vector<std::unique_ptr<SONIC_IO_LINUX>> *sensors, std::atomic<uint8_t> *running) {
+    while(running->load()) {
+        uint64_t now = bench_nanos();
+
+        for(size_t id = 0; id < sensors->size(); id++) {
+            FAKE_SONIC_ECHO &echo = bench->echoes[id];
+            uint64_t due = echo.due.load(std::memory_order_acquire);
+            if(!due || (now < due)) {continue;}
+
+            echo.due.store(0, std::memory_order_relaxed);
+            echo.falling.store(now, std::memory_order_release);
+
+            int fd = (*sensors)[id]->getEventFd();
+            mock_gpiod_edge(fd, (unsigned int)id, true, due - BENCH_ECHO_NS + BENCH_ECHO_DELAY_NS);
+            mock_gpiod_edge(fd, (unsigned int)id, false, now);
+        }
+
+        struct timespec pause = {0, 20000};
+        nanosleep(&pause, nullptr);
+    }
+}
+
+/* Private function to run the reactor until it delivered the readings and print the results */
+static int bench_run(const char *name, SONIC_LINUX_REACTOR &reactor, BENCH &bench, uint32_t readings, uint64_t cpu_start, uint64_t wall_start) {
+    while(bench.latency_ns.size() < readings) {
+        if(reactor.run(-1) < 0) {
+            perror("epoll_wait");
+            return 1;
+        }
+    }
+
+    uint64_t cpu = bench_cpu_nanos() - cpu_start;
+    uint64_t wall = bench_nanos() - wall_start;
+    size_t count = bench.latency_ns.size();
+
+    std::sort(bench.latency_ns.begin(), bench.latency_ns.end());
+
+    printf("%s readings:          %zu in %.2fs (%.0f/s)\n", name, count, wall / 1e9, count / (wall / 1e9));
+    printf("%s cpu per 1000 readings: %.3fms\n", name, cpu / 1e6 / (count / 1000.0));
+    printf("%s latency p50:       %.1fus\n", name, bench.latency_ns[count / 2] / 1e3);
+    printf("%s latency p99:       %.1fus\n", name, bench.latency_ns[count * 99 / 100] / 1e3);
+    printf("%s latency p99.9:     %.1fus\n", name, bench.latency_ns[count * 999 / 1000] / 1e3);
+    printf("%s latency max:       %.1fus\n", name, bench.latency_ns[count - 1] / 1e3);
+
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t sensor_count = (argc > 1) ? atoi(argv[1]) : 200;
+    uint32_t readings = (argc > 2) ? atoi(argv[2]) : 100000;
+    uint32_t conversion_ms = (argc > 3) ? atoi(argv[3]) : 5;
+
+    printf("sensors:              %u (conversion %ums, echo %.1fms)\n", sensor_count, conversion_ms, BENCH_ECHO_NS / 1e6);
+
+    /* I2C - conversion deadline to delivery */
+    {
+        std::vector<FAKE_SONIC_I2C> sensors(sensor_count);
+        BENCH bench = {&sensors, nullptr, {}, {}};
+        bench.latency_ns.reserve(readings + SONIC_LINUX_REACTOR_EVENTS);
+
+        SONIC_LINUX_REACTOR reactor;
+        if(!reactor.begin()) {
+            perror("epoll_create1");
+            return 1;
+        }
+        reactor.onReading(bench_reading, &bench);
+
+        uint64_t cpu_start = bench_cpu_nanos();
+        uint64_t wall_start = bench_nanos();
+
+        for(uint32_t i = 0; i < sensor_count; i++) {
+            sensors[i].begin(nullptr, (uint8_t)i);
+            for(uint8_t band = 0; band < SONIC_I2C_BANDS; band++) {sensors[i].setConversionTime(band, conversion_ms);}
+            sensors[i].conversion_ns = conversion_ms * 1000000UL;
+            if(reactor.add(&sensors[i]) < 0) {
+                perror("reactor.add");
+                return 1;
+            }
+        }
+
+        if(bench_run("i2c", reactor, bench, readings, cpu_start, wall_start)) {return 1;}
+    }
+
+    /* IO - falling echo edge to delivery */
+    {
+        std::vector<std::unique_ptr<SONIC_IO_LINUX>> sensors;
+        std::unique_ptr<FAKE_SONIC_ECHO[]> echoes(new FAKE_SONIC_ECHO[sensor_count]);
+        BENCH bench = {nullptr, echoes.get(), {}, {}};
+        bench.latency_ns.reserve(readings + SONIC_LINUX_REACTOR_EVENTS);
+
+        SONIC_LINUX_REACTOR reactor;
+        if(!reactor.begin()) {
+            perror("epoll_create1");
+            return 1;
+        }
+        reactor.onReading(bench_echo_reading, &bench);
+
+        /* Every echo line is its own offset, so all the requests can be open at once */
+        for(uint32_t i = 0; i < sensor_count; i++) {
+            sensors.emplace_back(new SONIC_IO_LINUX());
+            if(!sensors[i]->begin("/dev/gpiochip0", sensor_count + i, i)) {
+                perror("gpiod request");
+                return 1;
+            }
+
+            int fd = sensors[i]->getEventFd();
+            if((int)bench.echo_ids.size() <= fd) {bench.echo_ids.resize(fd + 1, -1);}
+            bench.echo_ids[fd] = (int)i;
+        }
+        mock_gpiod_on_pulse(bench_pulse, &bench);
+
+        std::atomic<uint8_t> running{true};
+        std::thread echo(bench_echo_thread, &bench, &sensors, &running);
+
+        uint64_t cpu_start = bench_cpu_nanos();
+        uint64_t wall_start = bench_nanos();
+
+        for(uint32_t i = 0; i < sensor_count; i++) {
+            if(reactor.add(sensors[i].get()) < 0) {
+                perror("reactor.add");
+                running = false;
+                echo.join();
+                return 1;
+            }
+        }
+
+        int result = bench_run("io ", reactor, bench, readings, cpu_start, wall_start);
+        running = false;
+        echo.join();
+        mock_gpiod_on_pulse(nullptr, nullptr);
+        if(result) {return result;}
+    }
+
+    return 0;
+}
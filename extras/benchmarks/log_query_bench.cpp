@@ -0,0 +1,131 @@
+/*
+    Benchmark for SONIC_LOG_READER.
+
+    Synthesises a month of SONIC_LOG data for a fleet (by default 2 gateways logging 25 sensors each, one
+    reading per sensor every 5s) through the real SONIC_LOG encoder, writes the images to files and then
+    times open() (mmap + sparse index) and an hourly per-sensor aggregate with 1 thread and with all cores.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -O2 -pthread -Isrc extras/benchmarks/log_query_bench.cpp src/Unit_Sonic_LinuxLogReader.cpp \
+            src/Unit_Sonic_Log.cpp src/Unit_Sonic_Batch.cpp -o log_query_bench
+
+    Usage: log_query_bench [days=30] [period_ms=5000] [files=2] [sensors_per_file=25] [directory=/tmp]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Unit_Sonic_LinuxLogReader.h"
+
+/* Log storage in RAM, dumped to a file once it is written */
+class RAM_STORAGE : public SONIC_LOG_STORAGE {
+    public:
+        explicit RAM_STORAGE(uint32_t size) : _data(size, 0xFF) {}
+
+        uint32_t getSize() override {return (uint32_t)_data.size();}
+        uint8_t read(uint32_t offset, void *data, uint32_t length) override {memcpy(data, &_data[offset], length); return true;}
+        uint8_t write(uint32_t offset, const void *data, uint32_t length) override {
+            for(uint32_t i = 0; i < length; i++) {_data[offset + i] &= ((const uint8_t *)data)[i];}
+            return true;
+        }
+        uint8_t erase(uint32_t offset) override {memset(&_data[offset], 0xFF, SONIC_LOG_SECTOR); return true;}
+
+        uint8_t dump(const char *path) {
+            FILE *file = fopen(path, "wb");
+            if(!file) {return false;}
+            uint8_t ok = fwrite(_data.data(), 1, _data.size(), file) == _data.size();
+            return (fclose(file) == 0) && ok;
+        }
+
+    private:
+        std::vector<uint8_t> _data;
+};
+
+/* Private function to get the monotonic time in s */
+static double bench_seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    uint32_t days = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 30;
+    uint32_t period_ms = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 5000;
+    uint32_t files = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 2;
+    uint32_t sensors = (argc > 4) ? strtoul(argv[4], nullptr, 10) : 25;
+    const char *directory = (argc > 5) ? argv[5] : "/tmp";
+
+    if(sensors > SONIC_BATCH_MAX_SENSORS) {sensors = SONIC_BATCH_MAX_SENSORS;}
+
+    uint64_t steps = (uint64_t)days * 86400000ULL / period_ms;
+    uint64_t total = steps * sensors * files;
+    std::vector<std::string> paths;
+
+    /* Write the logs - sized with headroom so the ring doesn't wrap, starting near a millis() wrap */
+    double started = bench_seconds();
+    for(uint32_t f = 0; f < files; f++) {
+        uint64_t size = (steps * sensors * 8 / SONIC_LOG_SECTOR + 2) * SONIC_LOG_SECTOR;
+        RAM_STORAGE storage((uint32_t)size);
+        SONIC_LOG log;
+        std::vector<uint32_t> distance(sensors, 1000000);
+        uint32_t timestamp = 4000000000UL;
+
+        log.begin(&storage);
+        srand(f + 1);
+        for(uint64_t step = 0; step < steps; step++, timestamp += period_ms) {
+            for(uint32_t s = 0; s < sensors; s++) {
+                distance[s] += (rand() % 2001) - 1000;
+                log.add((uint8_t)s, distance[s], timestamp + s);
+            }
+        }
+        log.flush();
+
+        char path[256];
+        snprintf(path, sizeof(path), "%s/sonic_log_bench_%u.bin", directory, f);
+        if(!storage.dump(path)) {
+            fprintf(stderr, "can't write %s\n", path);
+            return 1;
+        }
+        paths.push_back(path);
+    }
+    printf("generated %llu readings (%u files x %u sensors, %u days every %ums) in %.1fs\n",
+           (unsigned long long)total, files, sensors, days, period_ms, bench_seconds() - started);
+
+    unsigned cores = std::thread::hardware_concurrency();
+    unsigned runs[2] = {1, cores ? cores : 1};
+    int status = 0;
+
+    for(unsigned threads : runs) {
+        uint64_t readings = 0;
+        uint64_t bytes = 0;
+        started = bench_seconds();
+
+        for(const std::string &path : paths) {
+            SONIC_LOG_READER reader;
+            std::vector<SONIC_LOG_AGGREGATE> windows;
+
+            if(!reader.open(path.c_str())) {
+                fprintf(stderr, "can't open %s\n", path.c_str());
+                return 1;
+            }
+            readings += reader.aggregate(reader.getStart(), reader.getEnd(), 3600000, threads, &windows);
+            bytes += (uint64_t)reader.getSectors() * SONIC_LOG_SECTOR;
+        }
+
+        double elapsed = bench_seconds() - started;
+        printf("threads=%-3u %llu readings, %.0f MB in %.3fs (%.1f M readings/s)\n", threads, (unsigned long long)readings,
+               bytes / 1e6, elapsed, readings / elapsed / 1e6);
+
+        /* Every reading written must be summarised exactly once, whatever the thread split */
+        if(readings != total) {
+            printf("MISMATCH: %llu readings summarised, %llu written\n", (unsigned long long)readings, (unsigned long long)total);
+            status = 1;
+        }
+    }
+
+    for(const std::string &path : paths) {remove(path.c_str());}
+    return status;
+}
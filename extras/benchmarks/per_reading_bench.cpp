@@ -0,0 +1,107 @@
+/*
+    Per reading cost of the Arduino and the native ESP-IDF adapters.
+
+    The same source is built twice on the host, once against the Arduino mock (extras/mock/arduino) and once
+    against the ESP-IDF mock (extras/mock/idf), and drives SONIC_I2C and SONIC_IO through their public API only.
+    Both mocks sit on the same fake sensor and virtual clock (extras/mock/host_mock.h), so the difference
+    between the two runs is the adapter overhead - the cost of the real Wire / i2c_master transfers has to
+    be measured on the target.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -O2 -DARDUINO=10800 -Isrc -Iextras/mock -Iextras/mock/arduino extras/benchmarks/per_reading_bench.cpp \
+            src/Unit_Sonic.cpp src/Unit_Sonic_Core.cpp src/Unit_Sonic_Clock.cpp src/Unit_Sonic_Correction.cpp src/Unit_Sonic_Burst.cpp \
+            extras/mock/host_mock.cpp extras/mock/arduino/arduino_mock.cpp -o per_reading_bench_arduino
+        g++ -O2 -DESP_PLATFORM -Isrc -Iextras/mock -Iextras/mock/idf extras/benchmarks/per_reading_bench.cpp \
+            src/Unit_Sonic_IDF.cpp src/Unit_Sonic_Core.cpp src/Unit_Sonic_Clock.cpp src/Unit_Sonic_Correction.cpp src/Unit_Sonic_Burst.cpp \
+            extras/mock/host_mock.cpp extras/mock/idf/idf_mock.cpp -o per_reading_bench_idf
+
+    Usage: per_reading_bench [readings=20000] [poll_us=200]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Unit_Sonic.h"
+#include "host_mock.h"
+
+#if defined(SONIC_PLATFORM_ARDUINO)
+    #define BENCH_ADAPTER "arduino"
+#elif defined(SONIC_PLATFORM_IDF)
+    #define BENCH_ADAPTER "esp-idf"
+#else
+    #error "per_reading_bench must be built against the Arduino or the ESP-IDF mock"
+#endif
+
+#define BENCH_TRIG_PIN 26
+#define BENCH_ECHO_PIN 32
+
+/* Private function to get the CPU time used by this thread in ns */
+static uint64_t bench_cpu_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static SONIC_I2C sonic_i2c;
+static SONIC_IO sonic_io;
+
+#if defined(SONIC_PLATFORM_ARDUINO)
+    /* The Arduino adapter leaves the echo interrupt to the user */
+    static void echo_isr() {
+        if(digitalRead(BENCH_ECHO_PIN)) {
+            sonic_io.echo_isr_rising();
+        } else {
+            sonic_io.echo_isr_falling();
+        }
+    }
+#endif
+
+/* Private function to poll a sensor until it has delivered the requested number of readings */
+template <typename SENSOR>
+static void bench_run(const char* name, SENSOR& sensor, uint32_t readings, uint32_t poll_us) {
+    uint64_t polls = 0;
+    uint64_t checksum = 0;
+    uint64_t started = bench_cpu_nanos();
+
+    for(uint32_t delivered = 0; delivered < readings; polls++) {
+        if(sensor.readingAvailable()) {
+            checksum += sensor.getDistance_um();
+            delivered++;
+        }
+        mock_advance_us(poll_us);
+    }
+
+    uint64_t elapsed = bench_cpu_nanos() - started;
+    printf("%-8s %-4s readings=%u polls=%llu cpu/reading=%.0fns cpu/poll=%.1fns (checksum %llu)\n",
+           BENCH_ADAPTER, name, readings, (unsigned long long)polls,
+           (double)elapsed / readings, (double)elapsed / polls, (unsigned long long)checksum);
+}
+
+int main(int argc, char** argv) {
+    uint32_t readings = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 20000;
+    uint32_t poll_us = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 200;
+
+    mock_set_distance_um(1234567);
+
+    #if defined(SONIC_PLATFORM_ARDUINO)
+        if(!sonic_i2c.begin(&Wire, MOCK_SONIC_ADDR)) {
+            printf("I2C sensor not detected\n");
+            return 1;
+        }
+        sonic_io.begin(BENCH_TRIG_PIN, BENCH_ECHO_PIN);
+        mock_gpio_set_echo(BENCH_TRIG_PIN, BENCH_ECHO_PIN);
+        attachInterrupt(digitalPinToInterrupt(BENCH_ECHO_PIN), echo_isr, CHANGE);
+    #else
+        if(!sonic_i2c.begin(nullptr, MOCK_SONIC_ADDR)) {
+            printf("I2C sensor not detected\n");
+            return 1;
+        }
+        if(!sonic_io.begin((gpio_num_t)BENCH_TRIG_PIN, (gpio_num_t)BENCH_ECHO_PIN)) {
+            printf("IO sensor could not be set up\n");
+            return 1;
+        }
+    #endif
+
+    bench_run("i2c", sonic_i2c, readings, poll_us);
+    bench_run("io", sonic_io, readings, poll_us);
+    return 0;
+}
@@ -0,0 +1,150 @@
+/*
+    Frame cost of the example display code, on an in-memory 320x240 RGB565 framebuffer.
+
+    "scroll" is what the M5 examples used to do for every reading: scroll a full screen sprite by 4 pixels,
+    draw the new line segment and the label, and push the whole sprite to the panel.  "plot" is SONIC_PLOT
+    rendering straight to the panel plus the label, redrawn only when its value changed (at most 5 times
+    a second).  Both are fed the same 10s of readings every 30ms.  Besides the CPU time per frame on the host,
+    the pixels sent to the panel are counted and converted into SPI time at 40MHz (16 bits per pixel) - that
+    transfer is what dominates the loop on the device.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -O2 -Isrc extras/benchmarks/plot_bench.cpp src/Unit_Sonic_Plot.cpp -o plot_bench
+
+    Usage: plot_bench [reading_ms=30]
+*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Unit_Sonic_Plot.h"
+
+#define BENCH_WIDTH 320
+#define BENCH_HEIGHT 240
+#define BENCH_SPI_HZ 40000000.0
+
+/* In-memory RGB565 framebuffer with the drawing calls SONIC_PLOT and the examples use - counts the pixels written */
+class BENCH_FRAMEBUFFER {
+    public:
+        BENCH_FRAMEBUFFER() {memset(_pixels, 0, sizeof(_pixels));}
+
+        void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint32_t color) {
+            for(int16_t row = y; row < y + h; row++) {
+                for(int16_t column = x; column < x + w; column++) {set(column, row, color);}
+            }
+        }
+
+        void drawFastVLine(int16_t x, int16_t y, int16_t h, uint32_t color) {fillRect(x, y, 1, h, color);}
+
+        void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint32_t color) {
+            int16_t dx = abs(x1 - x0), dy = -abs(y1 - y0);
+            int16_t sx = (x0 < x1) ? 1 : -1, sy = (y0 < y1) ? 1 : -1;
+            int16_t error = dx + dy;
+
+            for(;;) {
+                set(x0, y0, color);
+                if((x0 == x1) && (y0 == y1)) {break;}
+                int16_t twice = 2 * error;
+                if(twice >= dy) {error += dy; x0 += sx;}
+                if(twice <= dx) {error += dx; y0 += sy;}
+            }
+        }
+
+        /* Scrolls the whole buffer right by dx pixels (M5Canvas::scroll()) */
+        void scroll(int16_t dx) {
+            for(int16_t row = 0; row < BENCH_HEIGHT; row++) {
+                memmove(&_pixels[row][dx], &_pixels[row][0], (BENCH_WIDTH - dx) * sizeof(uint16_t));
+                for(int16_t column = 0; column < dx; column++) {_pixels[row][column] = 0;}
+            }
+        }
+
+        /* Copies the whole buffer to another one (M5Canvas::pushSprite(0, 0)) */
+        void pushSprite(BENCH_FRAMEBUFFER& panel) {
+            memcpy(panel._pixels, _pixels, sizeof(_pixels));
+            panel.written += BENCH_WIDTH * BENCH_HEIGHT;
+        }
+
+        uint64_t written = 0;
+
+    private:
+        void set(int16_t x, int16_t y, uint32_t color) {
+            if((x < 0) || (y < 0) || (x >= BENCH_WIDTH) || (y >= BENCH_HEIGHT)) {return;}
+            _pixels[y][x] = (uint16_t)color;
+            written++;
+        }
+
+        uint16_t _pixels[BENCH_HEIGHT][BENCH_WIDTH];
+};
+
+static BENCH_FRAMEBUFFER bench_panel;
+static BENCH_FRAMEBUFFER bench_canvas;
+
+/* Private function to get the monotonic time in ns */
+static uint64_t bench_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* Private function for the distance of the synthetic target at a time */
+static uint32_t bench_distance(uint32_t ms) {
+    return 1500000 + (uint32_t)(1000000 * sin(ms / 1500.0)) + (rand() % 5001);
+}
+
+/* Private function to print the cost of a run */
+static void bench_report(const char* name, uint32_t frames, uint64_t nanos, uint64_t pixels) {
+    double spi_us = pixels * 16.0 / BENCH_SPI_HZ * 1e6 / frames;
+    printf("%-7s %6u frames  %8.1f us CPU/frame  %8.0f px/frame  %8.1f us SPI/frame\n", name, frames, nanos / 1000.0 / frames,
+           (double)pixels / frames, spi_us);
+}
+
+int main(int argc, char** argv) {
+    uint32_t reading_ms = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 30;
+    uint32_t frames = 0;
+
+    /* The examples: scroll, draw, label, push everything - once per reading */
+    srand(1);
+    int16_t last_point = 0;
+    uint64_t started = bench_nanos();
+    for(uint32_t ms = 0; ms < 10000; ms += reading_ms, frames++) {
+        uint32_t distance_mm = bench_distance(ms) / 1000;
+        int16_t point = (int16_t)(10 + (int32_t)(distance_mm - 20) * (180 - 10) / (4500 - 20));
+
+        bench_canvas.scroll(4);
+        bench_canvas.drawLine(0, point, 4, last_point, 1);
+        last_point = point;
+        bench_canvas.fillRect(0, 190, 320, 50, 0);
+        bench_canvas.fillRect(80, 194, 150, 24, 1);
+        bench_canvas.pushSprite(bench_panel);
+    }
+    bench_report("scroll", frames, bench_nanos() - started, bench_panel.written);
+
+    /* SONIC_PLOT: only new columns, the label only when it changed */
+    SONIC_PLOT plot;
+    plot.begin(0, 0, 320, 185, 50);
+    plot.setColors(1, 0);
+    plot.clear(bench_panel);
+
+    srand(1);
+    frames = 0;
+    bench_panel.written = 0;
+    uint32_t label_ms = 0;
+    uint32_t label_mm = 0;
+    started = bench_nanos();
+    for(uint32_t ms = 0; ms < 10000; ms += reading_ms, frames++) {
+        uint32_t distance_um = bench_distance(ms);
+        plot.add(distance_um, ms);
+        plot.render(bench_panel, ms);
+
+        if(((ms - label_ms) >= 200) && (distance_um / 1000 != label_mm)) {
+            label_ms = ms;
+            label_mm = distance_um / 1000;
+            bench_panel.fillRect(0, 190, 320, 50, 0);
+            bench_panel.fillRect(80, 194, 150, 24, 1);
+        }
+    }
+    bench_report("plot", frames, bench_nanos() - started, bench_panel.written);
+
+    return 0;
+}
@@ -0,0 +1,245 @@
+/*
+    Backpressure test of SONIC_PUBLISHER over SONIC_MQTT_LINUX.
+
+    8 sensors deliver a reading every ms each while the publisher sends to a broker.  By default the broker is
+    an in-process stand-in (a thread speaking just enough MQTT 3.1.1) that stops reading for the middle third
+    of the run, so the socket and the client's TX buffer fill up.  The acquisition loop must never stall: the
+    worst loop time is reported, and at the end every reading must be accounted for in the count fields of
+    the lines the broker received.  Pass a host (and port) to publish to a real broker such as Mosquitto
+    instead (then only the publisher side is reported).  Exits with 1 if a reading went missing, so the stand-in
+    run can go in CI.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -O2 -pthread -Isrc extras/benchmarks/publisher_bench.cpp src/Unit_Sonic_Publisher.cpp \
+            src/Unit_Sonic_LinuxMQTT.cpp src/Unit_Sonic_Clock.cpp -o publisher_bench
+
+    Usage: publisher_bench [host [port=1883]] [seconds=6]
+*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <thread>
+#include "Unit_Sonic_Publisher.h"
+#include "Unit_Sonic_LinuxMQTT.h"
+
+#define BENCH_SENSORS 8
+
+/* Private function to get the monotonic time in us */
+static uint64_t bench_micros() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+}
+
+/* In-process stand-in broker - accepts one client and counts what it publishes */
+class BENCH_BROKER {
+    public:
+        /* Listens on an ephemeral loopback port - returns it (0 on failure) */
+        uint16_t begin() {
+            struct sockaddr_in address;
+            socklen_t length = sizeof(address);
+            int small = 4096;
+
+            _listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+            memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            /* Small kernel buffers so a stalled broker is felt by the client quickly */
+            setsockopt(_listen_fd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+            if(bind(_listen_fd, (struct sockaddr*)&address, sizeof(address)) || listen(_listen_fd, 1) ||
+               getsockname(_listen_fd, (struct sockaddr*)&address, &length)) {return 0;}
+
+            _thread = std::thread(&BENCH_BROKER::run, this);
+            return ntohs(address.sin_port);
+        }
+
+        void end() {
+            _stop = true;
+            if(_thread.joinable()) {_thread.join();}
+            close(_listen_fd);
+        }
+
+        std::atomic<uint8_t> stalled{false};
+        std::atomic<uint32_t> messages{0};
+        std::atomic<uint32_t> lines{0};
+        std::atomic<uint64_t> readings{0};
+
+    private:
+        /* Private function to serve the client until end() */
+        void run() {
+            int fd = accept(_listen_fd, nullptr, nullptr);
+            if(fd < 0) {return;}
+
+            struct timeval timeout = {0, 10000};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            static uint8_t buffer[65536];
+            uint32_t length = 0;
+
+            while(!_stop) {
+                if(stalled) {
+                    usleep(10000);
+                    continue;
+                }
+
+                ssize_t got = recv(fd, &buffer[length], sizeof(buffer) - length, 0);
+                if(got == 0) {break;}
+                if(got < 0) {continue;}
+                length += (uint32_t)got;
+
+                /* Handle every complete packet */
+                uint32_t used;
+                while((used = packet(fd, buffer, length)) != 0) {
+                    memmove(buffer, &buffer[used], length - used);
+                    length -= used;
+                }
+            }
+            close(fd);
+        }
+
+        /* Private function to handle the packet at the start of the buffer - returns its size (0 if incomplete) */
+        uint32_t packet(int fd, const uint8_t* data, uint32_t length) {
+            uint32_t remaining = 0;
+            uint32_t header = 1;
+
+            for(uint8_t shift = 0; ; shift += 7) {
+                if(header >= length) {return 0;}
+                remaining |= (uint32_t)(data[header] & 0x7F) << shift;
+                if(!(data[header++] & 0x80)) {break;}
+            }
+            if(header + remaining > length) {return 0;}
+
+            const uint8_t* body = &data[header];
+            switch(data[0] & 0xF0) {
+                case 0x10: {    //CONNECT --> CONNACK accepted
+                    static const uint8_t connack[4] = {0x20, 0x02, 0x00, 0x00};
+                    send(fd, connack, sizeof(connack), MSG_NOSIGNAL);
+                    break;
+                }
+                case 0x30: {    //PUBLISH (QoS 0) --> count the lines and the readings they summarise
+                    uint32_t topic = 2 + ((body[0] << 8) | body[1]);
+                    const char* text = (const char*)&body[topic];
+                    uint32_t size = remaining - topic;
+
+                    messages++;
+                    for(uint32_t i = 0; i < size; i++) {
+                        if((text[i] == '\n') || (i == 0)) {lines++;}
+                        if((i + 6 < size) && !memcmp(&text[i], "count=", 6)) {readings += strtoul(&text[i + 6], nullptr, 10);}
+                    }
+                    break;
+                }
+                case 0xC0: {    //PINGREQ --> PINGRESP
+                    static const uint8_t pingresp[2] = {0xD0, 0x00};
+                    send(fd, pingresp, sizeof(pingresp), MSG_NOSIGNAL);
+                    break;
+                }
+                default:
+                    break;
+            }
+            return header + remaining;
+        }
+
+        int _listen_fd = -1;
+        std::thread _thread;
+        std::atomic<uint8_t> _stop{false};
+};
+
+int main(int argc, char** argv) {
+    const char* host = "127.0.0.1";
+    uint16_t port = 0;
+    uint32_t seconds = 6;
+    BENCH_BROKER broker;
+
+    /* A numeric first argument is the run time (stand-in broker), anything else a broker host */
+    if((argc > 1) && ((argv[1][0] < '0') || (argv[1][0] > '9'))) {
+        host = argv[1];
+        port = (argc > 2) ? (uint16_t)strtoul(argv[2], nullptr, 10) : 1883;
+        if(argc > 3) {seconds = strtoul(argv[3], nullptr, 10);}
+    } else {
+        if(argc > 1) {seconds = strtoul(argv[1], nullptr, 10);}
+        port = broker.begin();
+        if(!port) {
+            fprintf(stderr, "can't start the stand-in broker\n");
+            return 1;
+        }
+    }
+    uint8_t standin = (argc <= 1) || ((argv[1][0] >= '0') && (argv[1][0] <= '9'));
+
+    SONIC_MQTT_LINUX client;
+    if(!client.begin(host, port, "sonic-bench")) {
+        fprintf(stderr, "can't connect to %s:%u\n", host, port);
+        return 1;
+    }
+    int small = 4096;
+    setsockopt(client.getFd(), SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+
+    SONIC_PUBLISHER publisher;
+    if(!publisher.begin("sonic/bench", "sonic", "gw=bench")) {
+        fprintf(stderr, "the tags don't fit in a line\n");
+        return 1;
+    }
+    publisher.setDeadband(2000);
+    publisher.setInterval(20, 1000);
+
+    uint64_t started = bench_micros();
+    uint64_t produced = 0;
+    uint64_t worst_us = 0;
+    uint64_t total_us = 0;
+    uint64_t loops = 0;
+    uint32_t rejected_stalled = 0;
+
+    /* Acquisition loop: every sensor delivers a reading every ms */
+    for(uint32_t ms = 0; ms < seconds * 1000; ms++) {
+        while(bench_micros() - started < (uint64_t)ms * 1000) {}
+
+        uint8_t stall = standin && (ms >= seconds * 1000 / 3) && (ms < seconds * 2000 / 3);
+        if(stall != broker.stalled) {
+            if(!stall) {rejected_stalled = publisher.getRejected();}
+            broker.stalled = stall;
+        }
+
+        uint64_t loop_started = bench_micros();
+        for(uint8_t sensor = 0; sensor < BENCH_SENSORS; sensor++) {
+            uint32_t distance_um = 1000000 + sensor * 100000 + (uint32_t)(200000 * sin(ms / (500.0 + sensor * 100))) + (rand() % 1001);
+            publisher.add(sensor, distance_um, ms);
+            produced++;
+        }
+        publisher.publishTo(client, ms);
+        client.service();
+
+        uint64_t loop_us = bench_micros() - loop_started;
+        if(loop_us > worst_us) {worst_us = loop_us;}
+        total_us += loop_us;
+        loops++;
+    }
+
+    /* Drain: publish everything still summarised in RAM */
+    publisher.setDeadband(0);
+    for(uint32_t ms = seconds * 1000; ms < seconds * 1000 + 1000; ms++) {
+        publisher.publishTo(client, ms);
+        client.service();
+        usleep(1000);
+    }
+
+    printf("readings %llu, loop %.1fus mean / %lluus worst\n", (unsigned long long)produced, (double)total_us / loops, (unsigned long long)worst_us);
+    printf("publisher: %u messages, %u lines, %u refused (%u while the broker was stalled), client %s\n", publisher.getMessages(),
+           publisher.getLines(), publisher.getRejected(), rejected_stalled, client.connected() ? "connected" : "disconnected");
+
+    client.end();
+    if(!standin) {return 0;}
+
+    usleep(50000);
+    broker.end();
+    printf("broker: %u messages, %u lines, %llu readings summarised (%s)\n", broker.messages.load(), broker.lines.load(),
+           (unsigned long long)broker.readings.load(), (broker.readings == produced) ? "all accounted for" : "MISMATCH");
+
+    return (broker.readings == produced) ? 0 : 1;
+}
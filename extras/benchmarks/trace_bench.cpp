@@ -0,0 +1,129 @@
+/*
+    Where the time of the driver goes, from the SONIC_ENABLE_TRACE trace points.
+
+    Runs an I2C and an IO simulator with statistics and a background model attached for a few virtual seconds,
+    then summarises every trace point (calls, mean/max ns, share of the time spent in readingAvailable()) from
+    the trace ring and writes the ring as Chrome trace JSON - open it in https://ui.perfetto.dev or
+    chrome://tracing.  The cost of one empty trace point (begin + end) is measured first so it can be subtracted
+    from the short paths.  The same trace points built for an ESP32 (build_flags = -DSONIC_ENABLE_TRACE) record
+    CCOUNT instead, and SONIC_TRACE::exportJson() can write their JSON to the serial port.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -O2 -DSONIC_ENABLE_TRACE -DSONIC_TRACE_EVENTS=65536 -Isrc extras/benchmarks/trace_bench.cpp src/Unit_Sonic_Sim.cpp \
+            src/Unit_Sonic_Trace.cpp src/Unit_Sonic_Core.cpp src/Unit_Sonic_Correction.cpp src/Unit_Sonic_Burst.cpp \
+            src/Unit_Sonic_Stats.cpp src/Unit_Sonic_Background.cpp src/Unit_Sonic_Clock.cpp -o trace_bench
+
+    Usage: trace_bench [trace.json] [virtual_seconds=5]
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "Unit_Sonic_Sim.h"
+#include "Unit_Sonic_Stats.h"
+#include "Unit_Sonic_Background.h"
+#include "Unit_Sonic_Trace.h"
+
+#if !defined(SONIC_ENABLE_TRACE)
+    #error "trace_bench needs the library built with SONIC_ENABLE_TRACE"
+#endif
+
+#define BENCH_STEP_US 100
+#define BENCH_OVERHEAD_LOOPS 100000
+
+/* Summary of one trace point */
+struct bench_point {
+    uint64_t calls;
+    uint64_t cycles;
+    uint32_t max;
+};
+
+static uint64_t bench_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static void bench_output(const char *text, void *context) {fputs(text, (FILE *)context);}
+
+int main(int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : "trace.json";
+    uint32_t seconds = (argc > 2) ? (uint32_t)atoi(argv[2]) : 5;
+    double ns_per_cycle = 1e9 / (double)SONIC_TRACE::getFrequency();
+
+    /* Cost of an empty trace point, from the wall clock */
+    uint64_t start = bench_nanos();
+    for(uint32_t i = 0; i < BENCH_OVERHEAD_LOOPS; i++) {SONIC_TRACE_SCOPE(SONIC_TRACE_PUBLISH);}
+    double overhead_ns = (double)(bench_nanos() - start) / BENCH_OVERHEAD_LOOPS;
+    SONIC_TRACE::clear();
+
+    SONIC_I2C_SIM sensor_i2c;
+    SONIC_IO_SIM sensor_io;
+    SONIC_STATS stats_i2c, stats_io;
+    SONIC_BACKGROUND background;
+
+    stats_i2c.begin();
+    stats_io.begin();
+    background.begin();
+    sensor_i2c.attach(&stats_i2c);
+    sensor_i2c.attach(&background);
+    sensor_io.attach(&stats_io);
+    sensor_i2c.setTarget(800000);
+    sensor_io.setTarget(1500000);
+    SONIC_SIM_CLOCK::set_us(1000000);
+
+    uint32_t readings = 0;
+    for(uint64_t step = 0; step < (uint64_t)seconds * 1000000 / BENCH_STEP_US; step++) {
+        SONIC_SIM_CLOCK::advance_us(BENCH_STEP_US);
+        readings += sensor_i2c.readingAvailable();
+        readings += sensor_io.readingAvailable();
+    }
+
+    /* Pair the begin/end events per thread (the points nest) and sum up the durations */
+    std::vector<SONIC_TRACE_EVENT> events(SONIC_TRACE_EVENTS);
+    events.resize(SONIC_TRACE::copy(events.data(), (uint32_t)events.size()));
+
+    bench_point points[SONIC_TRACE_POINTS] = {};
+    std::vector<SONIC_TRACE_EVENT> open[2];
+    for(const SONIC_TRACE_EVENT &event : events) {
+        std::vector<SONIC_TRACE_EVENT> &stack = open[(event.point == SONIC_TRACE_ECHO_RISING) || (event.point == SONIC_TRACE_ECHO_FALLING)];
+        if(event.phase == SONIC_TRACE_BEGIN) {
+            stack.push_back(event);
+            continue;
+        }
+        if(stack.empty() || (stack.back().point != event.point)) {continue;}
+
+        uint32_t cycles = event.cycles - stack.back().cycles;
+        stack.pop_back();
+
+        bench_point &point = points[event.point];
+        point.calls++;
+        point.cycles += cycles;
+        if(cycles > point.max) {point.max = cycles;}
+    }
+
+    uint64_t polling = points[SONIC_TRACE_I2C_POLL].cycles + points[SONIC_TRACE_IO_POLL].cycles;
+
+    printf("%u virtual seconds, %u readings, %u trace events (%zu kept), %.0fMHz cycle counter\n", seconds, readings,
+           SONIC_TRACE::getCount(), events.size(), 1000.0 / ns_per_cycle);
+    printf("empty trace point: %.1fns\n\n", overhead_ns);
+    printf("%-14s %10s %10s %10s %8s\n", "point", "calls", "mean ns", "max ns", "of poll");
+    for(uint8_t i = 0; i < SONIC_TRACE_POINTS; i++) {
+        const bench_point &point = points[i];
+        if(!point.calls) {continue;}
+
+        printf("%-14s %10llu %10.1f %10.1f %7.1f%%\n", SONIC_TRACE::getName(i), (unsigned long long)point.calls,
+               point.cycles * ns_per_cycle / point.calls, point.max * ns_per_cycle, polling ? 100.0 * point.cycles / polling : 0.0);
+    }
+
+    FILE *file = fopen(path, "w");
+    if(!file) {
+        fprintf(stderr, "can't write %s\n", path);
+        return 1;
+    }
+    SONIC_TRACE::exportJson(bench_output, file);
+    fclose(file);
+    printf("\nwrote %s\n", path);
+
+    return 0;
+}
@@ -0,0 +1,166 @@
+/*
+    Fuzz target for the I2C state machine, through the real Arduino adapter on the host mock.
+
+    Every input is a program of time steps (starting anywhere, including right before the millis() wrap),
+    target distances, bus faults (NAKed reads and triggers, short reads, reads whose bytes never arrive so
+    Wire::read() returns -1),
+    conversion times, range gates, intervals and bursts.  After every poll the invariants are checked:
+        - a reading handed out is the distance the fake sensor reported - a faulted read is a counted miss and
+          no reading, never a silently wrong or made up distance
+        - a NAKed trigger is a counted miss that starts no measurement
+        - readings respect the range gate, the status is a flag and the counters add up
+        - a measurement never stays busy for more than one poll past the full conversion time
+
+    Build with clang and -DSONIC_FUZZ=ON (libFuzzer), or with any compiler against extras/fuzz/fuzz_main.cpp
+    for the deterministic driver - see the CMake host project.
+*/
+#include "Unit_Sonic.h"
+#include "host_mock.h"
+#include "fuzz_input.h"
+
+/* Operations of a fuzz program */
+#define FUZZ_OP_ADVANCE_US 0
+#define FUZZ_OP_ADVANCE_MS 1
+#define FUZZ_OP_DISTANCE 2
+#define FUZZ_OP_FAULT 3
+#define FUZZ_OP_CONVERSION 4
+#define FUZZ_OP_RANGE 5
+#define FUZZ_OP_INTERVAL 6
+#define FUZZ_OP_BURST 7
+#define FUZZ_OP_STOP_BURST 8
+#define FUZZ_OPS 9
+
+/* State of one fuzz run */
+struct fuzz_state {
+    SONIC_I2C* sensor;
+    uint32_t distance_um;
+    uint8_t fault;
+    uint8_t bursting;
+    uint32_t trigger_ms;
+    uint8_t overdue;
+    uint32_t nak_triggers;
+};
+
+/* Private function to poll the sensor once (or drive its burst) and check the invariants */
+static void fuzz_poll(fuzz_state& state) {
+    SONIC_I2C& sensor = *state.sensor;
+    SONIC_COUNTERS before = *sensor.getCounters();
+    uint32_t nak_triggers = mock_i2c_nak_triggers();
+    SONIC_BURST_RESULT result;
+    uint8_t reading;
+
+    if(state.bursting) {
+        uint8_t done = sensor.burstAvailable(&result);
+        reading = (sensor.getCounters()->readings != before.readings);
+
+        if(done) {
+            state.bursting = false;
+            FUZZ_CHECK((result.samples >= 1) && (result.samples <= SONIC_BURST_MAX), "burst sample count out of bounds");
+            FUZZ_CHECK(result.rejected < result.samples, "burst rejected every sample");
+        }
+    } else {
+        reading = sensor.readingAvailable();
+        FUZZ_CHECK(reading == (sensor.getCounters()->readings != before.readings), "reading returned without being counted");
+    }
+
+    const SONIC_COUNTERS* after = sensor.getCounters();
+    if(after->triggers != before.triggers) {state.trigger_ms = millis();}
+
+    /* A NAKed trigger starts no conversion - it is a miss, and the adapter must not wait for one and read it */
+    if(mock_i2c_nak_triggers() != nak_triggers) {
+        state.nak_triggers++;
+        FUZZ_CHECK((after->triggers == before.triggers) && (after->misses == before.misses + 1), "NAKed trigger not counted as a miss");
+        FUZZ_CHECK(!sensor.getStatus(), "NAKed trigger left the sensor busy");
+    }
+
+    /* A reading is the reported distance - a faulted read (a counted miss) is no reading */
+    FUZZ_CHECK(!reading || (after->misses == before.misses), "faulted read reported as a reading");
+    if(reading) {
+        uint32_t expected = (state.distance_um < SONIC_MAX_DISTANCE_UM) ? state.distance_um : SONIC_MAX_DISTANCE_UM;
+        uint32_t distance = sensor.getDistance_um();
+
+        FUZZ_CHECK(distance == expected, "silently wrong I2C reading");
+
+        uint16_t min_mm, max_mm;
+        sensor.getRange(&min_mm, &max_mm);
+        FUZZ_CHECK((distance >= (uint32_t)min_mm * 1000) && (distance <= (uint32_t)max_mm * 1000), "reading outside of the range gate");
+    }
+
+    FUZZ_CHECK(sensor.getStatus() <= 1, "status is not a flag");
+    FUZZ_CHECK(sensor.getDistance_um() <= SONIC_MAX_DISTANCE_UM, "distance above the maximum");
+    FUZZ_CHECK(after->readings + after->gated <= after->triggers, "more results than measurements");
+    FUZZ_CHECK(after->misses <= 2 * after->triggers + state.nak_triggers, "more misses than reads and NAKed triggers");
+
+    /* Bounded latency - a NAK after a shortened conversion time may cost one more poll, never more */
+    if(sensor.getStatus() && ((uint32_t)(millis() - state.trigger_ms) > SONIC_I2C_DATA_TIME + 1)) {
+        FUZZ_CHECK(++state.overdue <= 1, "I2C measurement stuck busy");
+    } else {
+        state.overdue = 0;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    FUZZ_INPUT input(data, size);
+    SONIC_I2C sensor;
+    fuzz_state state = {&sensor, 1000000, MOCK_I2C_FAULT_NONE, false, 0, 0, 0};
+
+    mock_reset(fuzz_start_us(input));
+    mock_set_distance_um(state.distance_um);
+    if(!sensor.begin(&Wire, MOCK_SONIC_ADDR)) {fuzz_fail("fake sensor not detected", __FILE__, __LINE__);}
+    state.trigger_ms = millis();
+
+    while(input.available()) {
+        switch(input.take8() % FUZZ_OPS) {
+            case FUZZ_OP_ADVANCE_US:
+                mock_advance_us(input.take16());
+                fuzz_poll(state);
+                break;
+
+            case FUZZ_OP_ADVANCE_MS:
+                mock_advance_us((uint32_t)input.take8() * 1000);
+                fuzz_poll(state);
+                break;
+
+            case FUZZ_OP_DISTANCE:
+                /* The chip reports 24 bits - anything up to that, including beyond the maximum distance */
+                state.distance_um = input.take32() & 0xFFFFFF;
+                mock_set_distance_um(state.distance_um);
+                break;
+
+            case FUZZ_OP_FAULT: {
+                uint8_t fault = input.take8();
+                state.fault = fault % 5;
+                mock_i2c_set_fault(state.fault, (fault >> 2) % 4);
+                break;
+            }
+
+            case FUZZ_OP_CONVERSION: {
+                uint8_t band = input.take8();
+                sensor.setConversionTime(band % (SONIC_I2C_BANDS + 1), input.take8());
+                break;
+            }
+
+            case FUZZ_OP_RANGE: {
+                uint16_t min_mm = input.take16() % (SONIC_MAX_DISTANCE + 100);
+                sensor.setRange(min_mm, input.take16() % (SONIC_MAX_DISTANCE + 100));
+                break;
+            }
+
+            case FUZZ_OP_INTERVAL:
+                sensor.setInterval(input.take8());
+                break;
+
+            case FUZZ_OP_BURST:
+                state.bursting = sensor.startBurst(input.take8() % (SONIC_BURST_MAX + 2));
+                FUZZ_CHECK(state.bursting, "burst pool exhausted with a single sensor");
+                break;
+
+            case FUZZ_OP_STOP_BURST:
+                sensor.stopBurst();
+                state.bursting = false;
+                break;
+        }
+    }
+
+    return 0;
+}
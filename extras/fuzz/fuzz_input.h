@@ -0,0 +1,54 @@
+/*
+    Shared pieces of the Unit Sonic fuzz targets.
+
+    FUZZ_INPUT hands the fuzzer's bytes out as operations and arguments (zeros once they run out, so every
+    input is a valid program), FUZZ_CHECK aborts with a message when an invariant breaks - libFuzzer turns
+    that into a crash report with the input that caused it.
+*/
+#ifndef _SONIC_FUZZ_INPUT_H_
+    #define _SONIC_FUZZ_INPUT_H_
+
+    #include <stdint.h>
+    #include <stddef.h>
+    #include <stdio.h>
+    #include <stdlib.h>
+
+    #define FUZZ_CHECK(condition, message) do {if(!(condition)) {fuzz_fail(message, __FILE__, __LINE__);}} while(0)
+
+    static inline void fuzz_fail(const char* message, const char* file, int line) {
+        fprintf(stderr, "%s:%d: invariant broken: %s\n", file, line, message);
+        abort();
+    }
+
+    class FUZZ_INPUT {
+        public:
+            FUZZ_INPUT(const uint8_t* data, size_t size) : _data(data), _size(size) {}
+
+            /* Checks whether there are bytes left */
+            uint8_t available() const {return _index < _size;}
+
+            /* Takes the next 1/2/4 bytes (little endian, zeros past the end) */
+            uint8_t take8() {return (_index < _size) ? _data[_index++] : 0;}
+            uint16_t take16() {return take8() | ((uint16_t)take8() << 8);}
+            uint32_t take32() {return take16() | ((uint32_t)take16() << 16);}
+
+        private:
+            const uint8_t* _data;
+            size_t _size;
+            size_t _index = 0;
+    };
+
+    /* Picks the virtual start time - 0, right before the micros() or the millis() wrap, or anywhere */
+    static inline uint64_t fuzz_start_us(FUZZ_INPUT& input) {
+        uint8_t where = input.take8();
+        uint32_t offset = input.take32();
+
+        switch(where & 0x03) {
+            case 0: return 0;
+            case 1: return 0x100000000ULL - (offset % 2000000);                 //micros() wraps within 2s
+            case 2: return 0x100000000ULL * 1000ULL - (offset % 2000000);       //millis() wraps within 2s
+            default: return ((uint64_t)offset << 10);
+        }
+    }
+
+#endif
@@ -0,0 +1,188 @@
+/*
+    Fuzz target for the IO (echo pulse) state machine, through the real Arduino adapter on the host mock.
+
+    Every input is a program of time steps (starting anywhere, including right before the micros() and the
+    millis() wraps), target distances, lost echo edges, stray edges (a falling edge before the rising one, a
+    second rising edge), range gates, intervals and bursts.  After every poll the invariants are checked:
+        - a reading handed out is the distance of the echo, or the out of range value with a timeout counted -
+          unless a stray edge landed inside the echo, which no driver can tell from a real one
+        - readings respect the range gate, the status is a flag and the counters add up
+        - a measurement never stays busy past the echo timeout
+
+    Build with clang and -DSONIC_FUZZ=ON (libFuzzer), or with any compiler against extras/fuzz/fuzz_main.cpp
+    for the deterministic driver - see the CMake host project.
+*/
+#include "Unit_Sonic.h"
+#include "host_mock.h"
+#include "fuzz_input.h"
+
+#define FUZZ_TRIG_PIN 26
+#define FUZZ_ECHO_PIN 32
+
+/* Operations of a fuzz program */
+#define FUZZ_OP_ADVANCE_US 0
+#define FUZZ_OP_ADVANCE_MS 1
+#define FUZZ_OP_DISTANCE 2
+#define FUZZ_OP_DROP_EDGES 3
+#define FUZZ_OP_STRAY_EDGE 4
+#define FUZZ_OP_RANGE 5
+#define FUZZ_OP_INTERVAL 6
+#define FUZZ_OP_BURST 7
+#define FUZZ_OP_STOP_BURST 8
+#define FUZZ_OPS 9
+
+/* State of one fuzz run */
+struct fuzz_state {
+    SONIC_IO* sensor;
+    uint32_t distance_um;
+    uint32_t echo_um;           //Distance the echo of the running measurement reports
+    uint8_t tainted;            //A stray edge may have restarted the running pulse
+    uint8_t bursting;
+    uint32_t trigger_ms;
+};
+
+static SONIC_IO* fuzz_sensor = nullptr;
+static uint8_t fuzz_rising_seen = false;
+
+/* Private function for the echo pin interrupt (both edges) */
+static void fuzz_echo_isr() {
+    if(digitalRead(FUZZ_ECHO_PIN)) {
+        fuzz_rising_seen = true;
+        fuzz_sensor->echo_isr_rising();
+    } else {
+        fuzz_sensor->echo_isr_falling();
+    }
+}
+
+/* Private function to get the distance the fake sensor's echo reports (it is timed in whole us) */
+static uint32_t fuzz_echo_um(uint32_t distance_um) {
+    uint64_t width_us = ((uint64_t)distance_um * 2) / 343;
+    return U32_SONIC_PULSE_NS_TO_UM(width_us * 1000);
+}
+
+/* Private function to poll the sensor once (or drive its burst) and check the invariants */
+static void fuzz_poll(fuzz_state& state) {
+    SONIC_IO& sensor = *state.sensor;
+    SONIC_COUNTERS before = *sensor.getCounters();
+    SONIC_BURST_RESULT result;
+    uint8_t reading;
+
+    if(state.bursting) {
+        uint8_t done = sensor.burstAvailable(&result);
+        reading = (sensor.getCounters()->readings != before.readings);
+
+        if(done) {
+            state.bursting = false;
+            FUZZ_CHECK((result.samples >= 1) && (result.samples <= SONIC_BURST_MAX), "burst sample count out of bounds");
+            FUZZ_CHECK(result.rejected < result.samples, "burst rejected every sample");
+        }
+    } else {
+        reading = sensor.readingAvailable();
+        FUZZ_CHECK(reading == (sensor.getCounters()->readings != before.readings), "reading returned without being counted");
+    }
+
+    /* The trigger is sent at the end of the poll, after any reading of the previous measurement */
+    const SONIC_COUNTERS* after = sensor.getCounters();
+    uint8_t triggered = (after->triggers != before.triggers);
+
+    /* A reading is the echo distance - or, if an edge was lost, the out of range value with a timeout */
+    if(reading) {
+        uint32_t expected = (state.echo_um < SONIC_MAX_DISTANCE_UM) ? state.echo_um : SONIC_MAX_DISTANCE_UM;
+        uint32_t distance = sensor.getDistance_um();
+        uint8_t timed_out = (after->misses != before.misses) && (distance == SONIC_MAX_DISTANCE_UM);
+
+        FUZZ_CHECK(state.tainted || (distance == expected) || timed_out, "silently wrong IO reading");
+
+        uint16_t min_mm, max_mm;
+        sensor.getRange(&min_mm, &max_mm);
+        FUZZ_CHECK((distance >= (uint32_t)min_mm * 1000) && (distance <= (uint32_t)max_mm * 1000), "reading outside of the range gate");
+    }
+
+    if(triggered) {
+        state.trigger_ms = millis();
+        state.echo_um = fuzz_echo_um(state.distance_um);
+        state.tainted = false;
+        fuzz_rising_seen = false;
+    }
+
+    FUZZ_CHECK(sensor.getStatus() <= 1, "status is not a flag");
+    FUZZ_CHECK(sensor.getDistance_um() <= SONIC_MAX_DISTANCE_UM, "distance above the maximum");
+    FUZZ_CHECK(after->readings + after->gated <= after->triggers, "more results than measurements");
+    FUZZ_CHECK(after->misses <= after->triggers, "more timeouts than measurements");
+
+    /* Bounded latency - the timeout always ends a measurement (+1ms for the trigger pulse crossing a ms) */
+    FUZZ_CHECK(!sensor.getStatus() || ((uint32_t)(millis() - state.trigger_ms) <= SONIC_IO_TIMEOUT_MS + 1), "IO measurement stuck busy");
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    FUZZ_INPUT input(data, size);
+    SONIC_IO sensor;
+    fuzz_state state = {&sensor, 1000000, 0, false, false, 0};
+
+    mock_reset(fuzz_start_us(input));
+    mock_set_distance_um(state.distance_um);
+    mock_gpio_set_echo(FUZZ_TRIG_PIN, FUZZ_ECHO_PIN);
+
+    fuzz_sensor = &sensor;
+    fuzz_rising_seen = false;
+    sensor.begin(FUZZ_TRIG_PIN, FUZZ_ECHO_PIN);
+    attachInterrupt(digitalPinToInterrupt(FUZZ_ECHO_PIN), fuzz_echo_isr, CHANGE);
+    state.trigger_ms = millis();
+
+    while(input.available()) {
+        switch(input.take8() % FUZZ_OPS) {
+            case FUZZ_OP_ADVANCE_US:
+                mock_advance_us(input.take16());
+                fuzz_poll(state);
+                break;
+
+            case FUZZ_OP_ADVANCE_MS:
+                mock_advance_us((uint32_t)input.take8() * 1000);
+                fuzz_poll(state);
+                break;
+
+            case FUZZ_OP_DISTANCE:
+                /* Up to ~16.7m, so the echo still ends before the timeout */
+                state.distance_um = input.take32() & 0xFFFFFF;
+                mock_set_distance_um(state.distance_um);
+                break;
+
+            case FUZZ_OP_DROP_EDGES:
+                mock_gpio_set_echo_faults(input.take8() & (MOCK_ECHO_DROP_RISING | MOCK_ECHO_DROP_FALLING));
+                break;
+
+            case FUZZ_OP_STRAY_EDGE: {
+                /* 
+                    A falling edge before any rising edge of the measurement must be ignored.  A rising edge may restart
+                    the pulse and a falling edge after one may end it, just like a real edge would.
+                */
+                uint8_t level = input.take8() & 1;
+                if(level || fuzz_rising_seen) {state.tainted = true;}
+                mock_gpio_echo_edge(level);
+                break;
+            }
+
+            case FUZZ_OP_RANGE: {
+                uint16_t min_mm = input.take16() % (SONIC_MAX_DISTANCE + 100);
+                sensor.setRange(min_mm, input.take16() % (SONIC_MAX_DISTANCE + 100));
+                break;
+            }
+
+            case FUZZ_OP_INTERVAL:
+                sensor.setInterval(input.take8());
+                break;
+
+            case FUZZ_OP_BURST:
+                state.bursting = sensor.startBurst(input.take8() % (SONIC_BURST_MAX + 2));
+                FUZZ_CHECK(state.bursting, "burst pool exhausted with a single sensor");
+                break;
+
+            case FUZZ_OP_STOP_BURST:
+                sensor.stopBurst();
+                state.bursting = false;
+                break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+/*
+    Deterministic driver for the fuzz targets when libFuzzer isn't available (e.g. gcc builds).
+
+    With file arguments it replays them (crash inputs, a corpus), otherwise it runs the target on a fixed
+    sequence of pseudo random inputs, so a failure always reproduces with the same runs/seed.
+
+    Usage: fuzz_<target> [runs=100000] [seed=1]
+           fuzz_<target> input...
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <vector>
+
+#define FUZZ_MAX_INPUT 1024
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+static uint32_t fuzz_random_state = 1;
+
+/* Private function for a deterministic pseudo random number (xorshift32) */
+static uint32_t fuzz_random() {
+    fuzz_random_state ^= fuzz_random_state << 13;
+    fuzz_random_state ^= fuzz_random_state >> 17;
+    fuzz_random_state ^= fuzz_random_state << 5;
+    return fuzz_random_state;
+}
+
+/* Private function to run the target on a file - returns false if it can't be read */
+static uint8_t fuzz_replay(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if(!file) {return false;}
+
+    std::vector<uint8_t> data;
+    int value;
+    while((value = fgetc(file)) != EOF) {data.push_back((uint8_t)value);}
+    fclose(file);
+
+    LLVMFuzzerTestOneInput(data.data(), data.size());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    /* Replay mode */
+    if((argc > 1) && fuzz_replay(argv[1])) {
+        for(int i = 2; i < argc; i++) {
+            if(!fuzz_replay(argv[i])) {fprintf(stderr, "can't read %s\n", argv[i]);}
+        }
+        printf("replayed %d inputs\n", argc - 1);
+        return 0;
+    }
+
+    uint32_t runs = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 100000;
+    fuzz_random_state = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 1;
+    if(!fuzz_random_state) {fuzz_random_state = 1;}
+
+    uint8_t data[FUZZ_MAX_INPUT];
+    for(uint32_t run = 0; run < runs; run++) {
+        uint32_t size = fuzz_random() % FUZZ_MAX_INPUT;
+        for(uint32_t i = 0; i < size; i++) {data[i] = (uint8_t)fuzz_random();}
+        LLVMFuzzerTestOneInput(data, size);
+    }
+
+    printf("%u runs passed\n", runs);
+    return 0;
+}
@@ -0,0 +1,46 @@
+/* Minimal host mock of the Arduino API used by the Unit Sonic adapters (see extras/mock/host_mock.h) */
+#ifndef _SONIC_MOCK_ARDUINO_H_
+    #define _SONIC_MOCK_ARDUINO_H_
+
+    #include <stdint.h>
+    #include <stddef.h>
+    #include <algorithm>
+    #include "host_mock.h"
+
+    using std::min;
+    using std::max;
+
+    #define HIGH 0x1
+    #define LOW 0x0
+    #define INPUT 0x01
+    #define OUTPUT 0x03
+    #define RISING 0x01
+    #define FALLING 0x02
+    #define CHANGE 0x03
+    #define IRAM_ATTR
+
+    inline unsigned long millis() {return (unsigned long)(uint32_t)(mock_now_us() / 1000);}
+    inline unsigned long micros() {return (unsigned long)(uint32_t)mock_now_us();}
+    inline void delay(uint32_t ms) {mock_advance_us(ms * 1000);}
+    inline void delayMicroseconds(uint32_t us) {mock_advance_us(us);}
+
+    inline void pinMode(uint8_t pin, uint8_t mode) {(void)pin; (void)mode;}
+    inline void digitalWrite(uint8_t pin, uint8_t level) {mock_gpio_write(pin, level);}
+    inline int digitalRead(uint8_t pin) {return mock_gpio_read(pin);}
+    inline int digitalPinToInterrupt(uint8_t pin) {return pin;}
+    void attachInterrupt(uint8_t pin, void (*isr)(), int mode);
+    void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode);
+
+    /* Serial writes to stdout and always has room in its TX buffer */
+    class HardwareSerial {
+        public:
+            void begin(uint32_t baud) {(void)baud;}
+            int availableForWrite() {return 128;}
+            size_t write(const uint8_t* data, size_t length);
+            size_t write(uint8_t data) {return write(&data, 1);}
+            int printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    };
+
+    extern HardwareSerial Serial;
+
+#endif
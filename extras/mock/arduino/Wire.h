@@ -0,0 +1,35 @@
+/* Minimal host mock of the Arduino Wire API, backed by the fake sensor in extras/mock/host_mock.h */
+#ifndef _SONIC_MOCK_WIRE_H_
+    #define _SONIC_MOCK_WIRE_H_
+
+    #include "Arduino.h"
+
+    class TwoWire {
+        public:
+            bool begin(int sda, int scl, uint32_t frequency) {(void)sda; (void)scl; (void)frequency; return true;}
+            bool end() {return true;}
+            bool setClock(uint32_t frequency) {(void)frequency; return true;}
+
+            void beginTransmission(uint8_t addr) {_addr = addr; _length = 0;}
+            size_t write(uint8_t data) {if(_length < sizeof(_buffer)) {_buffer[_length++] = data;} return 1;}
+            uint8_t endTransmission(bool stop = true) {(void)stop; return mock_i2c_write(_addr, _buffer, _length) ? 0 : 2;}
+
+            uint8_t requestFrom(uint8_t addr, uint8_t length) {
+                if(length > sizeof(_buffer)) {length = sizeof(_buffer);}
+                _length = mock_i2c_read(addr, _buffer, length);
+                _index = 0;
+                return mock_i2c_phantom() ? length : _length;
+            }
+            int available() {return _length - _index;}
+            int read() {return (_index < _length) ? _buffer[_index++] : -1;}
+
+        private:
+            uint8_t _addr = 0;
+            uint8_t _buffer[32];
+            uint8_t _length = 0;
+            uint8_t _index = 0;
+    };
+
+    extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,36 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include "Arduino.h"
+#include "Wire.h"
+
+TwoWire Wire;
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(const uint8_t* data, size_t length) {return fwrite(data, 1, length, stdout);}
+
+int HardwareSerial::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vprintf(format, args);
+    va_end(args);
+    return length;
+}
+
+static void (*pin_isr)() = nullptr;
+
+/* The Arduino ISRs take no argument, so bounce through the host mock's (void*) interrupt */
+static void pin_isr_bounce(void* arg) {
+    (void)arg;
+    if(pin_isr) {pin_isr();}
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(), int mode) {
+    (void)mode;
+    pin_isr = isr;
+    mock_gpio_set_isr(pin, pin_isr_bounce, nullptr);
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+    (void)mode;
+    mock_gpio_set_isr(pin, isr, arg);
+}
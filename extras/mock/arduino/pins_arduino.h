@@ -0,0 +1,8 @@
+/* Minimal host mock of the Arduino pin definitions */
+#ifndef _SONIC_MOCK_PINS_ARDUINO_H_
+    #define _SONIC_MOCK_PINS_ARDUINO_H_
+
+    #define SDA 21
+    #define SCL 22
+
+#endif
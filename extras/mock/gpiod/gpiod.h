@@ -0,0 +1,69 @@
+/*
+    Minimal host mock of the libgpiod v2 API used by SONIC_IO_LINUX.
+
+    Every line request's fd is the read end of a pipe: mock_gpiod_edge() writes an edge event into the request
+    with that fd, so the adapter's poll()/epoll + gpiod_line_request_read_edge_events() path runs unchanged
+    without a gpio chip.  Trigger pulses are counted per request and can be hooked to play the echo.
+*/
+#ifndef _SONIC_GPIOD_MOCK_H_
+    #define _SONIC_GPIOD_MOCK_H_
+
+    #include <stddef.h>
+    #include <stdint.h>
+
+    enum gpiod_line_value {GPIOD_LINE_VALUE_ERROR = -1, GPIOD_LINE_VALUE_INACTIVE = 0, GPIOD_LINE_VALUE_ACTIVE = 1};
+    enum gpiod_line_direction {GPIOD_LINE_DIRECTION_AS_IS = 1, GPIOD_LINE_DIRECTION_INPUT, GPIOD_LINE_DIRECTION_OUTPUT};
+    enum gpiod_line_edge {GPIOD_LINE_EDGE_NONE = 1, GPIOD_LINE_EDGE_RISING, GPIOD_LINE_EDGE_FALLING, GPIOD_LINE_EDGE_BOTH};
+    enum gpiod_line_clock {GPIOD_LINE_CLOCK_MONOTONIC = 1, GPIOD_LINE_CLOCK_REALTIME, GPIOD_LINE_CLOCK_HTE};
+    enum gpiod_edge_event_type {GPIOD_EDGE_EVENT_RISING_EDGE = 1, GPIOD_EDGE_EVENT_FALLING_EDGE};
+
+    struct gpiod_chip;
+    struct gpiod_line_settings;
+    struct gpiod_line_config;
+    struct gpiod_request_config;
+    struct gpiod_line_request;
+    struct gpiod_edge_event;
+    struct gpiod_edge_event_buffer;
+
+    /* Chip */
+    struct gpiod_chip* gpiod_chip_open(const char* path);
+    void gpiod_chip_close(struct gpiod_chip* chip);
+    struct gpiod_line_request* gpiod_chip_request_lines(struct gpiod_chip* chip, struct gpiod_request_config* req_cfg, struct gpiod_line_config* line_cfg);
+
+    /* Line settings / configs (accepted and ignored) */
+    struct gpiod_line_settings* gpiod_line_settings_new(void);
+    void gpiod_line_settings_free(struct gpiod_line_settings* settings);
+    int gpiod_line_settings_set_direction(struct gpiod_line_settings* settings, enum gpiod_line_direction direction);
+    int gpiod_line_settings_set_edge_detection(struct gpiod_line_settings* settings, enum gpiod_line_edge edge);
+    int gpiod_line_settings_set_event_clock(struct gpiod_line_settings* settings, enum gpiod_line_clock clock);
+    int gpiod_line_settings_set_output_value(struct gpiod_line_settings* settings, enum gpiod_line_value value);
+    struct gpiod_line_config* gpiod_line_config_new(void);
+    void gpiod_line_config_free(struct gpiod_line_config* config);
+    int gpiod_line_config_add_line_settings(struct gpiod_line_config* config, const unsigned int* offsets, size_t num_offsets, struct gpiod_line_settings* settings);
+    struct gpiod_request_config* gpiod_request_config_new(void);
+    void gpiod_request_config_free(struct gpiod_request_config* config);
+    void gpiod_request_config_set_consumer(struct gpiod_request_config* config, const char* consumer);
+
+    /* Line request */
+    void gpiod_line_request_release(struct gpiod_line_request* request);
+    int gpiod_line_request_set_value(struct gpiod_line_request* request, unsigned int offset, enum gpiod_line_value value);
+    int gpiod_line_request_get_fd(struct gpiod_line_request* request);
+    int gpiod_line_request_read_edge_events(struct gpiod_line_request* request, struct gpiod_edge_event_buffer* buffer, size_t max_events);
+
+    /* Edge events */
+    struct gpiod_edge_event_buffer* gpiod_edge_event_buffer_new(size_t capacity);
+    void gpiod_edge_event_buffer_free(struct gpiod_edge_event_buffer* buffer);
+    struct gpiod_edge_event* gpiod_edge_event_buffer_get_event(struct gpiod_edge_event_buffer* buffer, unsigned long index);
+    enum gpiod_edge_event_type gpiod_edge_event_get_event_type(struct gpiod_edge_event* event);
+    uint64_t gpiod_edge_event_get_timestamp_ns(struct gpiod_edge_event* event);
+    unsigned int gpiod_edge_event_get_line_offset(struct gpiod_edge_event* event);
+
+    /* 
+        Mock control - queues an edge event on the request with the given fd, counts its trigger pulses (rising edges
+        of any output) and calls the hook on every pulse, from the thread that sent it
+    */
+    void mock_gpiod_edge(int request_fd, unsigned int offset, uint8_t rising, uint64_t timestamp_ns);
+    uint32_t mock_gpiod_pulses(int request_fd);
+    void mock_gpiod_on_pulse(void (*hook)(int request_fd, void* context), void* context);
+
+#endif
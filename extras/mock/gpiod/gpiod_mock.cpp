@@ -0,0 +1,133 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+#include "gpiod.h"
+
+/* Edge event as it travels through the pipe */
+struct gpiod_edge_event {
+    unsigned int offset;
+    enum gpiod_edge_event_type type;
+    uint64_t timestamp_ns;
+};
+
+struct gpiod_chip {int unused;};
+struct gpiod_line_settings {int unused;};
+struct gpiod_line_config {int unused;};
+struct gpiod_request_config {int unused;};
+struct gpiod_line_request {int fds[2]; uint32_t pulses;};
+struct gpiod_edge_event_buffer {std::vector<gpiod_edge_event> events;};
+
+static std::vector<gpiod_line_request*> mock_requests;
+static void (*mock_pulse_hook)(int, void*) = nullptr;
+static void* mock_pulse_context = nullptr;
+
+/* Private function to find the open request by its fd */
+static gpiod_line_request* mock_find(int request_fd) {
+    for(gpiod_line_request* request : mock_requests) {
+        if(request->fds[0] == request_fd) {return request;}
+    }
+    return nullptr;
+}
+
+/* Chip */
+struct gpiod_chip* gpiod_chip_open(const char* path) {return path ? new gpiod_chip() : nullptr;}
+void gpiod_chip_close(struct gpiod_chip* chip) {delete chip;}
+
+struct gpiod_line_request* gpiod_chip_request_lines(struct gpiod_chip* chip, struct gpiod_request_config* req_cfg, struct gpiod_line_config* line_cfg) {
+    (void)req_cfg;
+    (void)line_cfg;
+    if(!chip) {return nullptr;}
+
+    /* The read end is non-blocking, like the kernel's line request fd once the events are drained */
+    gpiod_line_request* request = new gpiod_line_request();
+    if(pipe2(request->fds, O_CLOEXEC | O_NONBLOCK) < 0) {
+        delete request;
+        return nullptr;
+    }
+
+    mock_requests.push_back(request);
+    return request;
+}
+
+/* Line settings / configs */
+struct gpiod_line_settings* gpiod_line_settings_new(void) {return new gpiod_line_settings();}
+void gpiod_line_settings_free(struct gpiod_line_settings* settings) {delete settings;}
+int gpiod_line_settings_set_direction(struct gpiod_line_settings*, enum gpiod_line_direction) {return 0;}
+int gpiod_line_settings_set_edge_detection(struct gpiod_line_settings*, enum gpiod_line_edge) {return 0;}
+int gpiod_line_settings_set_event_clock(struct gpiod_line_settings*, enum gpiod_line_clock) {return 0;}
+int gpiod_line_settings_set_output_value(struct gpiod_line_settings*, enum gpiod_line_value) {return 0;}
+struct gpiod_line_config* gpiod_line_config_new(void) {return new gpiod_line_config();}
+void gpiod_line_config_free(struct gpiod_line_config* config) {delete config;}
+int gpiod_line_config_add_line_settings(struct gpiod_line_config*, const unsigned int*, size_t, struct gpiod_line_settings*) {return 0;}
+struct gpiod_request_config* gpiod_request_config_new(void) {return new gpiod_request_config();}
+void gpiod_request_config_free(struct gpiod_request_config* config) {delete config;}
+void gpiod_request_config_set_consumer(struct gpiod_request_config*, const char*) {}
+
+/* Line request */
+void gpiod_line_request_release(struct gpiod_line_request* request) {
+    close(request->fds[0]);
+    close(request->fds[1]);
+    for(size_t i = 0; i < mock_requests.size(); i++) {
+        if(mock_requests[i] == request) {mock_requests.erase(mock_requests.begin() + i); break;}
+    }
+    delete request;
+}
+
+int gpiod_line_request_set_value(struct gpiod_line_request* request, unsigned int offset, enum gpiod_line_value value) {
+    (void)offset;
+    if(value == GPIOD_LINE_VALUE_ACTIVE) {
+        request->pulses++;
+        if(mock_pulse_hook) {mock_pulse_hook(request->fds[0], mock_pulse_context);}
+    }
+    return 0;
+}
+
+int gpiod_line_request_get_fd(struct gpiod_line_request* request) {return request->fds[0];}
+
+int gpiod_line_request_read_edge_events(struct gpiod_line_request* request, struct gpiod_edge_event_buffer* buffer, size_t max_events) {
+    buffer->events.clear();
+
+    gpiod_edge_event event;
+    while((buffer->events.size() < max_events) && (read(request->fds[0], &event, sizeof(event)) == (ssize_t)sizeof(event))) {
+        buffer->events.push_back(event);
+    }
+
+    /* The kernel would block on an empty request, the mock reports the EAGAIN of its non-blocking pipe */
+    return buffer->events.empty() ? -1 : (int)buffer->events.size();
+}
+
+/* Edge events */
+struct gpiod_edge_event_buffer* gpiod_edge_event_buffer_new(size_t capacity) {
+    gpiod_edge_event_buffer* buffer = new gpiod_edge_event_buffer();
+    buffer->events.reserve(capacity);
+    return buffer;
+}
+
+void gpiod_edge_event_buffer_free(struct gpiod_edge_event_buffer* buffer) {delete buffer;}
+
+struct gpiod_edge_event* gpiod_edge_event_buffer_get_event(struct gpiod_edge_event_buffer* buffer, unsigned long index) {
+    return (index < buffer->events.size()) ? &buffer->events[index] : nullptr;
+}
+
+enum gpiod_edge_event_type gpiod_edge_event_get_event_type(struct gpiod_edge_event* event) {return event->type;}
+uint64_t gpiod_edge_event_get_timestamp_ns(struct gpiod_edge_event* event) {return event->timestamp_ns;}
+unsigned int gpiod_edge_event_get_line_offset(struct gpiod_edge_event* event) {return event->offset;}
+
+/* Mock control */
+void mock_gpiod_edge(int request_fd, unsigned int offset, uint8_t rising, uint64_t timestamp_ns) {
+    gpiod_line_request* request = mock_find(request_fd);
+    if(!request) {return;}
+
+    gpiod_edge_event event = {offset, rising ? GPIOD_EDGE_EVENT_RISING_EDGE : GPIOD_EDGE_EVENT_FALLING_EDGE, timestamp_ns};
+    if(write(request->fds[1], &event, sizeof(event)) != (ssize_t)sizeof(event)) {return;}
+}
+
+uint32_t mock_gpiod_pulses(int request_fd) {
+    gpiod_line_request* request = mock_find(request_fd);
+    return request ? request->pulses : 0;
+}
+
+void mock_gpiod_on_pulse(void (*hook)(int request_fd, void* context), void* context) {
+    mock_pulse_hook = hook;
+    mock_pulse_context = context;
+}
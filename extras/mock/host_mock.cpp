@@ -0,0 +1,120 @@
+#include "host_mock.h"
+
+static uint64_t now_us = 0;
+static uint32_t distance_um = 1000000;
+
+/* I2C model */
+static uint64_t i2c_triggered_at = 0;
+static uint8_t i2c_fault = MOCK_I2C_FAULT_NONE;
+static uint8_t i2c_fault_bytes = 0;
+static uint8_t i2c_phantom = false;
+static uint32_t i2c_nak_triggers = 0;
+
+/* GPIO model */
+static uint8_t trig_pin = 0xFF;
+static uint8_t echo_pin = 0xFF;
+static uint8_t trig_level = 0;
+static uint8_t echo_level = 0;
+static uint64_t echo_rise_at = 0;
+static uint64_t echo_fall_at = 0;
+static uint8_t echo_faults = 0;
+static void (*echo_isr)(void*) = nullptr;
+static void* echo_isr_arg = nullptr;
+
+/* Changes the echo level and plays the interrupt (unless it is lost), with the clock sitting exactly on the edge */
+static void echo_edge(uint8_t level, uint64_t at, uint8_t lost) {
+    uint64_t later = now_us;
+    now_us = at;
+    echo_level = level;
+    if(echo_isr && !lost) {echo_isr(echo_isr_arg);}
+    now_us = later;
+}
+
+void mock_advance_us(uint32_t us) {
+    now_us += us;
+
+    if(echo_rise_at && (now_us >= echo_rise_at)) {
+        echo_edge(1, echo_rise_at, echo_faults & MOCK_ECHO_DROP_RISING);
+        echo_rise_at = 0;
+    }
+    if(!echo_rise_at && echo_fall_at && (now_us >= echo_fall_at)) {
+        echo_edge(0, echo_fall_at, echo_faults & MOCK_ECHO_DROP_FALLING);
+        echo_fall_at = 0;
+    }
+}
+
+uint64_t mock_now_us() {return now_us;}
+
+void mock_reset(uint64_t now) {
+    now_us = now;
+    i2c_triggered_at = 0;
+    i2c_fault = MOCK_I2C_FAULT_NONE;
+    i2c_phantom = false;
+    i2c_nak_triggers = 0;
+    trig_level = 0;
+    echo_level = 0;
+    echo_rise_at = 0;
+    echo_fall_at = 0;
+    echo_faults = 0;
+}
+
+void mock_set_distance_um(uint32_t distance) {distance_um = distance;}
+
+uint8_t mock_i2c_write(uint8_t addr, const uint8_t* data, uint32_t length) {
+    if(addr != MOCK_SONIC_ADDR) {return false;}
+    if((length == 1) && (data[0] == 0x01)) {
+        if(i2c_fault == MOCK_I2C_FAULT_NAK_TRIGGER) {
+            i2c_nak_triggers++;
+            return false;
+        }
+        i2c_triggered_at = now_us;
+    }
+    return true;
+}
+
+uint32_t mock_i2c_read(uint8_t addr, uint8_t* data, uint32_t length) {
+    i2c_phantom = false;
+    if((addr != MOCK_SONIC_ADDR) || (now_us - i2c_triggered_at < MOCK_SONIC_LATENCY_US)) {return 0;}
+    if(i2c_fault == MOCK_I2C_FAULT_NAK) {return 0;}
+
+    for(uint32_t i = 0; i < length; i++) {data[i] = (i < 3) ? (uint8_t)(distance_um >> (8 * (2 - i))) : 0xFF;}
+    if((i2c_fault == MOCK_I2C_FAULT_NONE) || (i2c_fault_bytes >= length)) {return length;}
+
+    i2c_phantom = (i2c_fault == MOCK_I2C_FAULT_PHANTOM);
+    return i2c_fault_bytes;
+}
+
+void mock_i2c_set_fault(uint8_t fault, uint8_t bytes) {
+    i2c_fault = fault;
+    i2c_fault_bytes = bytes;
+}
+
+uint8_t mock_i2c_phantom() {return i2c_phantom;}
+
+uint32_t mock_i2c_nak_triggers() {return i2c_nak_triggers;}
+
+void mock_gpio_write(uint8_t pin, uint8_t level) {
+    /* Falling edge of the trigger pulse --> schedule the echo (twice the flight time at 343um/us) */
+    if((pin == trig_pin) && trig_level && !level) {
+        echo_rise_at = now_us + MOCK_SONIC_ECHO_DELAY_US;
+        echo_fall_at = echo_rise_at + ((uint64_t)distance_um * 2) / 343;
+    }
+    if(pin == trig_pin) {trig_level = level;}
+}
+
+uint8_t mock_gpio_read(uint8_t pin) {return (pin == echo_pin) ? echo_level : 0;}
+
+void mock_gpio_set_echo(uint8_t trig, uint8_t echo) {
+    trig_pin = trig;
+    echo_pin = echo;
+}
+
+void mock_gpio_set_echo_faults(uint8_t faults) {echo_faults = faults;}
+
+void mock_gpio_echo_edge(uint8_t level) {echo_edge(level, now_us, false);}
+
+void mock_gpio_set_isr(uint8_t pin, void (*isr)(void*), void* arg) {
+    if(pin != echo_pin) {return;}
+    echo_isr = isr;
+    echo_isr_arg = arg;
+}
@@ -0,0 +1,54 @@
+/*
+    Host side model of a Unit Sonic (RCWL-9620) and a virtual clock.
+
+    Shared by the Arduino and ESP-IDF API mocks so the real adapters can be built and benchmarked on a
+    host.  Time only moves when mock_advance_us() is called; the echo pulse of the IO version is played
+    back through the registered pin interrupt with the right virtual timing.  The fuzz targets (extras/fuzz)
+    inject bus and edge faults into the same model.
+*/
+#ifndef _SONIC_HOST_MOCK_H_
+    #define _SONIC_HOST_MOCK_H_
+
+    #include <stdint.h>
+
+    #define MOCK_SONIC_ADDR 0x57            //I2C address the fake sensor answers on
+    #define MOCK_SONIC_LATENCY_US 30000     //Time the fake I2C sensor needs before its data can be read
+    #define MOCK_SONIC_ECHO_DELAY_US 500    //Delay between the end of the trigger pulse and the echo pulse
+
+    /* I2C faults - MOCK_I2C_FAULT_SHORT/PHANTOM deliver only the given number of bytes */
+    #define MOCK_I2C_FAULT_NONE 0           //The fake sensor answers normally
+    #define MOCK_I2C_FAULT_NAK 1            //Reads are NAKed
+    #define MOCK_I2C_FAULT_SHORT 2          //Reads return fewer bytes than requested
+    #define MOCK_I2C_FAULT_PHANTOM 3        //Reads report the requested length but fewer bytes arrive
+    #define MOCK_I2C_FAULT_NAK_TRIGGER 4    //Triggers are NAKed (no conversion starts)
+
+    /* Echo faults (OR them together) */
+    #define MOCK_ECHO_DROP_RISING 0x01      //The rising edge of the following echoes is lost
+    #define MOCK_ECHO_DROP_FALLING 0x02     //The falling edge of the following echoes is lost
+
+    /* Virtual clock */
+    void mock_advance_us(uint32_t us);
+    uint64_t mock_now_us();
+
+    /* Sets the clock and clears the sensor state and the faults (the pins and the interrupt stay registered) */
+    void mock_reset(uint64_t now_us);
+
+    /* Target distance seen by the fake sensor (um) */
+    void mock_set_distance_um(uint32_t distance_um);
+
+    /* I2C - both return false/0 (NAK) unless the address matches and, for reads, the conversion is done */
+    uint8_t mock_i2c_write(uint8_t addr, const uint8_t* data, uint32_t length);
+    uint32_t mock_i2c_read(uint8_t addr, uint8_t* data, uint32_t length);
+    void mock_i2c_set_fault(uint8_t fault, uint8_t bytes = 0);
+    uint8_t mock_i2c_phantom();     //Whether the last read should report more bytes than it returned
+    uint32_t mock_i2c_nak_triggers();   //Triggers NAKed by MOCK_I2C_FAULT_NAK_TRIGGER since mock_reset()
+
+    /* GPIO - the fake sensor watches every pin for a trigger pulse and answers on mock_gpio_echo_pin */
+    void mock_gpio_write(uint8_t pin, uint8_t level);
+    uint8_t mock_gpio_read(uint8_t pin);
+    void mock_gpio_set_echo(uint8_t trig_pin, uint8_t echo_pin);
+    void mock_gpio_set_isr(uint8_t pin, void (*isr)(void*), void* arg);
+    void mock_gpio_set_echo_faults(uint8_t faults);
+    void mock_gpio_echo_edge(uint8_t level);        //Plays a stray echo edge right now
+
+#endif
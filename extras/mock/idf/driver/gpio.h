@@ -0,0 +1,30 @@
+/* Minimal host mock of the ESP-IDF gpio driver, backed by the fake sensor in extras/mock/host_mock.h */
+#ifndef _SONIC_MOCK_GPIO_H_
+    #define _SONIC_MOCK_GPIO_H_
+
+    #include <stdint.h>
+    #include "esp_err.h"
+
+    typedef enum {GPIO_NUM_NC = -1, GPIO_NUM_0 = 0, GPIO_NUM_26 = 26, GPIO_NUM_32 = 32, GPIO_NUM_MAX = 40} gpio_num_t;
+    typedef enum {GPIO_MODE_DISABLE = 0, GPIO_MODE_INPUT = 1, GPIO_MODE_OUTPUT = 2} gpio_mode_t;
+    typedef enum {GPIO_PULLUP_DISABLE = 0, GPIO_PULLUP_ENABLE} gpio_pullup_t;
+    typedef enum {GPIO_PULLDOWN_DISABLE = 0, GPIO_PULLDOWN_ENABLE} gpio_pulldown_t;
+    typedef enum {GPIO_INTR_DISABLE = 0, GPIO_INTR_POSEDGE, GPIO_INTR_NEGEDGE, GPIO_INTR_ANYEDGE} gpio_int_type_t;
+    typedef void (*gpio_isr_t)(void* arg);
+
+    typedef struct {
+        uint64_t pin_bit_mask;
+        gpio_mode_t mode;
+        gpio_pullup_t pull_up_en;
+        gpio_pulldown_t pull_down_en;
+        gpio_int_type_t intr_type;
+    } gpio_config_t;
+
+    esp_err_t gpio_config(const gpio_config_t* config);
+    esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level);
+    int gpio_get_level(gpio_num_t pin);
+    esp_err_t gpio_install_isr_service(int flags);
+    esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t isr, void* arg);
+    esp_err_t gpio_isr_handler_remove(gpio_num_t pin);
+
+#endif
@@ -0,0 +1,23 @@
+/* Minimal host mock of the ESP-IDF gptimer driver, counting the virtual clock of extras/mock/host_mock.h */
+#ifndef _SONIC_MOCK_GPTIMER_H_
+    #define _SONIC_MOCK_GPTIMER_H_
+
+    #include <stdint.h>
+    #include "esp_err.h"
+
+    typedef struct gptimer_t* gptimer_handle_t;
+    typedef enum {GPTIMER_CLK_SRC_DEFAULT = 0} gptimer_clock_source_t;
+    typedef enum {GPTIMER_COUNT_DOWN = 0, GPTIMER_COUNT_UP} gptimer_count_direction_t;
+
+    typedef struct {
+        gptimer_clock_source_t clk_src;
+        gptimer_count_direction_t direction;
+        uint32_t resolution_hz;
+    } gptimer_config_t;
+
+    esp_err_t gptimer_new_timer(const gptimer_config_t* config, gptimer_handle_t* handle);
+    esp_err_t gptimer_enable(gptimer_handle_t timer);
+    esp_err_t gptimer_start(gptimer_handle_t timer);
+    esp_err_t gptimer_get_raw_count(gptimer_handle_t timer, uint64_t* value);
+
+#endif
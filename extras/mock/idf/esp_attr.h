@@ -0,0 +1,7 @@
+/* Minimal host mock of the ESP-IDF attributes */
+#ifndef _SONIC_MOCK_ESP_ATTR_H_
+    #define _SONIC_MOCK_ESP_ATTR_H_
+
+    #define IRAM_ATTR
+
+#endif
@@ -0,0 +1,14 @@
+/* Minimal host mock of the ESP-IDF error codes */
+#ifndef _SONIC_MOCK_ESP_ERR_H_
+    #define _SONIC_MOCK_ESP_ERR_H_
+
+    typedef int esp_err_t;
+
+    #define ESP_OK 0
+    #define ESP_FAIL -1
+    #define ESP_ERR_INVALID_ARG 0x102
+    #define ESP_ERR_INVALID_STATE 0x103
+    #define ESP_ERR_NOT_FOUND 0x105
+    #define ESP_ERR_TIMEOUT 0x107
+
+#endif
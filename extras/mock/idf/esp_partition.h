@@ -0,0 +1,25 @@
+/* Minimal host mock of the ESP-IDF partition API - one 64KB data partition labelled "sonic_log" in RAM */
+#ifndef _SONIC_MOCK_ESP_PARTITION_H_
+    #define _SONIC_MOCK_ESP_PARTITION_H_
+
+    #include <stdint.h>
+    #include <stddef.h>
+    #include "esp_err.h"
+
+    typedef enum {ESP_PARTITION_TYPE_APP = 0x00, ESP_PARTITION_TYPE_DATA = 0x01} esp_partition_type_t;
+    typedef enum {ESP_PARTITION_SUBTYPE_ANY = 0xFF} esp_partition_subtype_t;
+
+    typedef struct {
+        esp_partition_type_t type;
+        esp_partition_subtype_t subtype;
+        uint32_t address;
+        uint32_t size;
+        char label[17];
+    } esp_partition_t;
+
+    const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label);
+    esp_err_t esp_partition_read(const esp_partition_t* partition, size_t offset, void* data, size_t length);
+    esp_err_t esp_partition_write(const esp_partition_t* partition, size_t offset, const void* data, size_t length);
+    esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t length);
+
+#endif
@@ -0,0 +1,10 @@
+/* Minimal host mock of the ESP-IDF ROM delay */
+#ifndef _SONIC_MOCK_ESP_ROM_SYS_H_
+    #define _SONIC_MOCK_ESP_ROM_SYS_H_
+
+    #include <stdint.h>
+    #include "host_mock.h"
+
+    inline void esp_rom_delay_us(uint32_t us) {mock_advance_us(us);}
+
+#endif
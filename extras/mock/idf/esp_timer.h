@@ -0,0 +1,10 @@
+/* Minimal host mock of the ESP-IDF high resolution timer */
+#ifndef _SONIC_MOCK_ESP_TIMER_H_
+    #define _SONIC_MOCK_ESP_TIMER_H_
+
+    #include <stdint.h>
+    #include "host_mock.h"
+
+    inline int64_t esp_timer_get_time() {return (int64_t)mock_now_us();}
+
+#endif
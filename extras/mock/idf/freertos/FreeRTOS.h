@@ -0,0 +1,11 @@
+/* Minimal host mock of the FreeRTOS critical sections (single threaded host) */
+#ifndef _SONIC_MOCK_FREERTOS_H_
+    #define _SONIC_MOCK_FREERTOS_H_
+
+    typedef struct {int owner; int count;} portMUX_TYPE;
+
+    #define portMUX_INITIALIZER_UNLOCKED {0, 0}
+    #define portENTER_CRITICAL(mux) ((mux)->count++)
+    #define portEXIT_CRITICAL(mux) ((mux)->count--)
+
+#endif
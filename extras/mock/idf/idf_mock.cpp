@@ -0,0 +1,163 @@
+#include <string.h>
+#include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "driver/gptimer.h"
+#include "nvs.h"
+#include "esp_partition.h"
+#include "host_mock.h"
+
+/* i2c_master - a device handle is just its address */
+struct i2c_master_dev_t {uint16_t address;};
+static i2c_master_dev_t devices[8];
+static uint8_t device_count = 0;
+
+esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus, const i2c_device_config_t* config, i2c_master_dev_handle_t* handle) {
+    (void)bus;
+    if(device_count >= sizeof(devices) / sizeof(devices[0])) {return ESP_ERR_INVALID_STATE;}
+    devices[device_count].address = config->device_address;
+    *handle = &devices[device_count++];
+    return ESP_OK;
+}
+
+esp_err_t i2c_master_bus_rm_device(i2c_master_dev_handle_t handle) {(void)handle; return ESP_OK;}
+
+esp_err_t i2c_master_probe(i2c_master_bus_handle_t bus, uint16_t address, int timeout_ms) {
+    (void)bus;
+    (void)timeout_ms;
+    return mock_i2c_write((uint8_t)address, nullptr, 0) ? ESP_OK : ESP_ERR_NOT_FOUND;
+}
+
+esp_err_t i2c_master_transmit(i2c_master_dev_handle_t handle, const uint8_t* data, size_t length, int timeout_ms) {
+    (void)timeout_ms;
+    return mock_i2c_write((uint8_t)handle->address, data, length) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t i2c_master_receive(i2c_master_dev_handle_t handle, uint8_t* data, size_t length, int timeout_ms) {
+    (void)timeout_ms;
+    return (mock_i2c_read((uint8_t)handle->address, data, length) == length) ? ESP_OK : ESP_FAIL;
+}
+
+/* gpio - the first output pin configured is the trigger, the first interrupt pin the echo */
+static int trig_pin = -1;
+static int echo_pin = -1;
+
+esp_err_t gpio_config(const gpio_config_t* config) {
+    for(int pin = 0; pin < 64; pin++) {
+        if(!(config->pin_bit_mask & (1ULL << pin))) {continue;}
+        if(config->mode == GPIO_MODE_OUTPUT) {trig_pin = pin;}
+        if(config->intr_type != GPIO_INTR_DISABLE) {echo_pin = pin;}
+    }
+    mock_gpio_set_echo((uint8_t)trig_pin, (uint8_t)echo_pin);
+    return ESP_OK;
+}
+
+esp_err_t gpio_set_level(gpio_num_t pin, uint32_t level) {
+    mock_gpio_write((uint8_t)pin, (uint8_t)level);
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t pin) {return mock_gpio_read((uint8_t)pin);}
+
+esp_err_t gpio_install_isr_service(int flags) {
+    static uint8_t installed = false;
+    (void)flags;
+    if(installed) {return ESP_ERR_INVALID_STATE;}
+    installed = true;
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_add(gpio_num_t pin, gpio_isr_t isr, void* arg) {
+    mock_gpio_set_isr((uint8_t)pin, isr, arg);
+    return ESP_OK;
+}
+
+esp_err_t gpio_isr_handler_remove(gpio_num_t pin) {
+    mock_gpio_set_isr((uint8_t)pin, nullptr, nullptr);
+    return ESP_OK;
+}
+
+/* gptimer - counts the virtual clock at the requested resolution */
+struct gptimer_t {uint32_t resolution_hz;};
+static gptimer_t timer;
+
+esp_err_t gptimer_new_timer(const gptimer_config_t* config, gptimer_handle_t* handle) {
+    timer.resolution_hz = config->resolution_hz;
+    *handle = &timer;
+    return ESP_OK;
+}
+
+esp_err_t gptimer_enable(gptimer_handle_t handle) {(void)handle; return ESP_OK;}
+esp_err_t gptimer_start(gptimer_handle_t handle) {(void)handle; return ESP_OK;}
+
+esp_err_t gptimer_get_raw_count(gptimer_handle_t handle, uint64_t* value) {
+    *value = mock_now_us() * (handle->resolution_hz / 1000000);
+    return ESP_OK;
+}
+
+/* nvs - one namespace, a handful of small blobs in memory */
+struct nvs_entry {char key[16]; uint8_t value[32]; size_t length;};
+static nvs_entry entries[8];
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* handle) {(void)name; (void)mode; *handle = 1; return ESP_OK;}
+esp_err_t nvs_commit(nvs_handle_t handle) {(void)handle; return ESP_OK;}
+void nvs_close(nvs_handle_t handle) {(void)handle;}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    (void)handle;
+    if(length > sizeof(entries[0].value)) {return ESP_ERR_INVALID_ARG;}
+    for(nvs_entry& entry : entries) {
+        if(!entry.key[0] || !strncmp(entry.key, key, sizeof(entry.key))) {
+            strncpy(entry.key, key, sizeof(entry.key) - 1);
+            memcpy(entry.value, value, length);
+            entry.length = length;
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* value, size_t* length) {
+    (void)handle;
+    for(nvs_entry& entry : entries) {
+        if(entry.key[0] && !strncmp(entry.key, key, sizeof(entry.key))) {
+            if(*length < entry.length) {return ESP_ERR_INVALID_ARG;}
+            memcpy(value, entry.value, entry.length);
+            *length = entry.length;
+            return ESP_OK;
+        }
+    }
+    return ESP_ERR_NOT_FOUND;
+}
+
+/* esp_partition - NOR flash semantics, erase sets 0xFF and writes only clear bits */
+static esp_partition_t partition = {ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, 0x110000, 0x10000, "sonic_log"};
+static uint8_t partition_data[0x10000];
+static uint8_t partition_erased = false;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char* label) {
+    (void)subtype;
+    if((type != partition.type) || (label && strcmp(label, partition.label))) {return nullptr;}
+    if(!partition_erased) {
+        memset(partition_data, 0xFF, sizeof(partition_data));
+        partition_erased = true;
+    }
+    return &partition;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* part, size_t offset, void* data, size_t length) {
+    if(offset + length > part->size) {return ESP_ERR_INVALID_ARG;}
+    memcpy(data, &partition_data[offset], length);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* part, size_t offset, const void* data, size_t length) {
+    if(offset + length > part->size) {return ESP_ERR_INVALID_ARG;}
+    for(size_t i = 0; i < length; i++) {partition_data[offset + i] &= ((const uint8_t*)data)[i];}
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* part, size_t offset, size_t length) {
+    if((offset % 4096) || (length % 4096) || (offset + length > part->size)) {return ESP_ERR_INVALID_ARG;}
+    memset(&partition_data[offset], 0xFF, length);
+    return ESP_OK;
+}
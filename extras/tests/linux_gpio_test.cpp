@@ -0,0 +1,101 @@
+/*
+    Test of the Linux libgpiod v2 backend with edge events fed through a fake line request fd.
+
+    Built against the libgpiod mock in extras/mock/gpiod, whose request fd is a pipe, so SONIC_IO_LINUX's own
+    poll + read_edge_events path handles the events.  Checks the echo readings, the edges that must be ignored
+    (before the trigger, on another line, a falling edge without a rising one), the timeout and that a timeout
+    dropped by the range gate isn't reported as a reading.
+*/
+#include <poll.h>
+#include <time.h>
+#include "Unit_Sonic_LinuxGPIO.h"
+#include "gpiod.h"
+#include "sonic_test.h"
+
+#define TEST_TRIG 17
+#define TEST_ECHO 27
+#define TEST_ECHO_DELAY_NS 200000ULL        //Trigger to rising edge
+
+/* Private function to get the clock the kernel timestamps the edges on */
+static uint64_t test_nanos() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/* Private function to poll the sensor for up to timeout_ms - returns whether a reading came */
+static uint8_t test_wait_reading(SONIC_IO_LINUX& sensor, uint32_t timeout_ms) {
+    uint64_t end = test_nanos() + timeout_ms * 1000000ULL;
+
+    while(test_nanos() < end) {
+        if(sensor.readingAvailable()) {return true;}
+
+        struct pollfd pending[2] = {{sensor.getEventFd(), POLLIN, 0}, {sensor.getTimerFd(), POLLIN, 0}};
+        ::poll(pending, 2, 1);
+    }
+
+    return false;
+}
+
+/* Private function to start a measurement - returns the trigger time */
+static uint64_t test_trigger(SONIC_IO_LINUX& sensor) {
+    uint32_t pulses = mock_gpiod_pulses(sensor.getEventFd());
+
+    /* The polled path sends the trigger once the core allows it */
+    for(uint8_t i = 0; (i < 100) && (mock_gpiod_pulses(sensor.getEventFd()) == pulses); i++) {
+        TEST_CHECK(!sensor.readingAvailable(), "reading before the trigger");
+        ::poll(nullptr, 0, 1);
+    }
+    TEST_CHECK(mock_gpiod_pulses(sensor.getEventFd()) == pulses + 1, "no trigger pulse");
+
+    return test_nanos();
+}
+
+/* Private function to play an echo pulse of width_ns - returns the distance it must read as */
+static uint32_t test_echo(SONIC_IO_LINUX& sensor, uint64_t triggered_ns, uint64_t width_ns) {
+    mock_gpiod_edge(sensor.getEventFd(), TEST_ECHO, true, triggered_ns + TEST_ECHO_DELAY_NS);
+    mock_gpiod_edge(sensor.getEventFd(), TEST_ECHO, false, triggered_ns + TEST_ECHO_DELAY_NS + width_ns);
+    return U32_SONIC_PULSE_NS_TO_UM(width_ns);
+}
+
+int main() {
+    SONIC_IO_LINUX sensor;
+    TEST_CHECK(sensor.begin("/dev/gpiochip0", TEST_TRIG, TEST_ECHO), "lines not requested");
+
+    /* Plain readings */
+    uint32_t expected = test_echo(sensor, test_trigger(sensor), 5830904);
+    TEST_CHECK(test_wait_reading(sensor, 50), "no reading for the echo");
+    TEST_CHECK(sensor.getDistance_um() == expected, "wrong distance");
+
+    /* Edges that don't belong to the running measurement are ignored */
+    uint64_t triggered = test_trigger(sensor);
+    mock_gpiod_edge(sensor.getEventFd(), TEST_ECHO, true, triggered - 5000000);
+    mock_gpiod_edge(sensor.getEventFd(), TEST_ECHO + 1, true, triggered + 1000);
+    mock_gpiod_edge(sensor.getEventFd(), TEST_ECHO + 1, false, triggered + 2000);
+    mock_gpiod_edge(sensor.getEventFd(), TEST_ECHO, false, triggered + 3000);
+    TEST_CHECK(!test_wait_reading(sensor, 10), "reading from a stray edge");
+    expected = test_echo(sensor, triggered, 2915452);
+    TEST_CHECK(test_wait_reading(sensor, 50), "no reading after stray edges");
+    TEST_CHECK(sensor.getDistance_um() == expected, "stray edge changed the distance");
+
+    /* A lost echo times out as the out of range reading */
+    uint32_t misses = sensor.getCounters()->misses;
+    test_trigger(sensor);
+    TEST_CHECK(test_wait_reading(sensor, SONIC_IO_TIMEOUT_MS + 100), "no timeout reading");
+    TEST_CHECK(sensor.getDistance_um() == SONIC_MAX_DISTANCE_UM, "timeout isn't the max distance");
+    TEST_CHECK(sensor.getCounters()->misses == misses + 1, "timeout not counted");
+
+    /* A timeout dropped by the range gate is no reading (and the previous distance stays) */
+    expected = test_echo(sensor, test_trigger(sensor), 5830904);
+    TEST_CHECK(test_wait_reading(sensor, 50), "no reading before the gated timeout");
+    sensor.setRange(0, 3000);
+    SONIC_COUNTERS before = *sensor.getCounters();
+    test_trigger(sensor);
+    TEST_CHECK(!test_wait_reading(sensor, SONIC_IO_TIMEOUT_MS + 100), "gated timeout reported as a reading");
+    TEST_CHECK(sensor.getCounters()->gated == before.gated + 1, "gated timeout not counted");
+    TEST_CHECK(sensor.getCounters()->readings == before.readings, "gated timeout counted as a reading");
+    TEST_CHECK(sensor.getDistance_um() == expected, "gated timeout replaced the distance");
+
+    sensor.end();
+    return test_result("linux_gpio_test");
+}
@@ -0,0 +1,114 @@
+/*
+    Test of the Linux i2c-dev backend against a fake i2c device.
+
+    SONIC_I2C_LINUX is begun without a bus and its transfer() is overridden, so the real trigger --> timerfd -->
+    read path runs against a fake chip that can NAK.  Checks the readings, the interval hold of the polled path,
+    the retry delay after a NAKed trigger and that the fd owning class can't be copied.
+*/
+#include <poll.h>
+#include <type_traits>
+#include "Unit_Sonic_LinuxI2C.h"
+#include "Unit_Sonic_Clock.h"
+#include "sonic_test.h"
+
+#define TEST_ADDR 0x57
+#define TEST_CONVERSION_MS 10
+
+static_assert(!std::is_copy_constructible<SONIC_I2C_LINUX>::value, "SONIC_I2C_LINUX must not be copyable");
+static_assert(!std::is_copy_assignable<SONIC_I2C_LINUX>::value, "SONIC_I2C_LINUX must not be copy assignable");
+
+/* Fake RCWL-9620 - answers on TEST_ADDR with the distance in um (big endian) */
+class FAKE_I2C : public SONIC_I2C_LINUX {
+    public:
+        uint32_t distance_um = 1234567;
+        uint8_t nak_trigger = false;
+        uint8_t nak_read = false;
+        uint32_t triggers = 0;
+        uint32_t reads = 0;
+
+    protected:
+        int transfer(struct i2c_msg* msgs, uint32_t count) override {
+            for(uint32_t i = 0; i < count; i++) {
+                if(msgs[i].addr != TEST_ADDR) {return -1;}
+
+                if(msgs[i].flags & I2C_M_RD) {
+                    reads++;
+                    if(nak_read || (msgs[i].len != 3)) {return -1;}
+                    msgs[i].buf[0] = (uint8_t)(distance_um >> 16);
+                    msgs[i].buf[1] = (uint8_t)(distance_um >> 8);
+                    msgs[i].buf[2] = (uint8_t)distance_um;
+                } else if((msgs[i].len == 1) && (msgs[i].buf[0] == 0x01)) {
+                    triggers++;
+                    if(nak_trigger) {return -1;}
+                }
+            }
+
+            return (int)count;
+        }
+};
+
+/* Private function to poll the sensor (waiting on its timerfd in between) for up to timeout_ms - returns whether a reading came */
+static uint8_t test_wait_reading(FAKE_I2C& sensor, uint32_t timeout_ms) {
+    uint64_t end = SONIC_CLOCK::millis64() + timeout_ms;
+
+    while(SONIC_CLOCK::millis64() < end) {
+        if(sensor.readingAvailable()) {return true;}
+
+        struct pollfd pending = {sensor.getTimerFd(), POLLIN, 0};
+        ::poll(&pending, 1, 1);
+    }
+
+    return false;
+}
+
+/* Private function to keep polling for duration_ms */
+static void test_spin(FAKE_I2C& sensor, uint32_t duration_ms) {
+    uint64_t end = SONIC_CLOCK::millis64() + duration_ms;
+    while(SONIC_CLOCK::millis64() < end) {
+        sensor.readingAvailable();
+        ::poll(nullptr, 0, 1);
+    }
+}
+
+int main() {
+    FAKE_I2C sensor;
+
+    {
+        FAKE_I2C other;
+        TEST_CHECK(!other.begin(nullptr, TEST_ADDR + 1), "a sensor was detected on the wrong address");
+    }
+
+    TEST_CHECK(sensor.begin(nullptr, TEST_ADDR), "fake sensor not detected");
+    for(uint8_t band = 0; band < SONIC_I2C_BANDS; band++) {sensor.setConversionTime(band, TEST_CONVERSION_MS);}
+
+    /* Polled readings */
+    TEST_CHECK(test_wait_reading(sensor, 200), "no reading from the fake sensor");
+    TEST_CHECK(sensor.getDistance_um() == sensor.distance_um, "wrong distance");
+    sensor.distance_um = 2345678;
+    TEST_CHECK(test_wait_reading(sensor, 200) && (sensor.getDistance_um() == 2345678), "second reading wrong or missing");
+
+    /* The interval holds the next trigger off */
+    sensor.setInterval(150);
+    TEST_CHECK(test_wait_reading(sensor, 200), "no reading with an interval");
+    uint32_t triggers = sensor.triggers;
+    test_spin(sensor, 80);
+    TEST_CHECK(sensor.triggers == triggers, "triggered inside the interval");
+    TEST_CHECK(test_wait_reading(sensor, 200), "no reading after the interval");
+    TEST_CHECK(sensor.triggers == triggers + 1, "more than one trigger per interval");
+
+    /* A NAKed trigger is counted and retried after the full conversion time, not on every poll */
+    sensor.setInterval(0);
+    sensor.nak_trigger = true;
+    triggers = sensor.triggers;
+    uint32_t misses = sensor.getCounters()->misses;
+    test_spin(sensor, SONIC_I2C_DATA_TIME / 2);
+    TEST_CHECK(sensor.triggers - triggers <= 1, "NAKed trigger retried without a delay");
+    TEST_CHECK(sensor.getCounters()->misses == misses + (sensor.triggers - triggers), "NAKed trigger not counted as a miss");
+    TEST_CHECK(!sensor.getStatus(), "busy after a NAKed trigger");
+
+    sensor.nak_trigger = false;
+    TEST_CHECK(test_wait_reading(sensor, SONIC_I2C_DATA_TIME + 100), "no reading after the trigger came back");
+
+    sensor.end();
+    return test_result("linux_i2c_test");
+}
@@ -0,0 +1,116 @@
+/*
+    Test of SONIC_LINUX_REACTOR with a fake i2c device and the libgpiod mock.
+
+    Checks that the reactor keeps an IO sensor running after a reading the range gate dropped, that it holds the
+    next trigger for setInterval() instead of re-triggering straight from the delivery and that a NAKed trigger
+    is retried once the sensor's timer fires.
+*/
+#include "Unit_Sonic_LinuxReactor.h"
+#include "Unit_Sonic_Clock.h"
+#include "gpiod.h"
+#include "sonic_test.h"
+
+#define TEST_ADDR 0x57
+#define TEST_TRIG 17
+#define TEST_ECHO 27
+#define TEST_CONVERSION_MS 10
+
+/* Fake RCWL-9620 - answers on TEST_ADDR with a fixed distance */
+class FAKE_I2C : public SONIC_I2C_LINUX {
+    public:
+        uint8_t nak_trigger = false;
+        uint32_t triggers = 0;
+
+    protected:
+        int transfer(struct i2c_msg* msgs, uint32_t count) override {
+            if(msgs[0].addr != TEST_ADDR) {return -1;}
+
+            if(msgs[0].flags & I2C_M_RD) {
+                msgs[0].buf[0] = 0x12;
+                msgs[0].buf[1] = 0x34;
+                msgs[0].buf[2] = 0x56;
+            } else if(msgs[0].len) {
+                triggers++;
+                if(nak_trigger) {return -1;}
+            }
+
+            return (int)count;
+        }
+};
+
+struct TEST_READINGS {
+    uint32_t count[2];
+};
+
+/* Reading callback - counts the readings per sensor */
+static void test_reading(int id, uint32_t distance_um, void* context) {
+    (void)distance_um;
+    ((TEST_READINGS*)context)->count[id]++;
+}
+
+/* Private function to run the reactor for duration_ms */
+static void test_run(SONIC_LINUX_REACTOR& reactor, uint32_t duration_ms) {
+    uint64_t end = SONIC_CLOCK::millis64() + duration_ms;
+    while(SONIC_CLOCK::millis64() < end) {reactor.run(1);}
+}
+
+/* Private function to answer the running ping of the IO sensor with an echo of width_ns */
+static void test_echo(SONIC_IO_LINUX& sensor, uint64_t width_ns) {
+    uint64_t now = SONIC_CLOCK::micros64() * 1000ULL;
+    mock_gpiod_edge(sensor.getEventFd(), TEST_ECHO, true, now);
+    mock_gpiod_edge(sensor.getEventFd(), TEST_ECHO, false, now + width_ns);
+}
+
+int main() {
+    TEST_READINGS readings = {};
+    SONIC_LINUX_REACTOR reactor;
+    TEST_CHECK(reactor.begin(), "no epoll set");
+    reactor.onReading(test_reading, &readings);
+
+    FAKE_I2C i2c;
+    TEST_CHECK(i2c.begin(nullptr, TEST_ADDR), "fake sensor not detected");
+    for(uint8_t band = 0; band < SONIC_I2C_BANDS; band++) {i2c.setConversionTime(band, TEST_CONVERSION_MS);}
+    i2c.setInterval(100);
+
+    SONIC_IO_LINUX io;
+    TEST_CHECK(io.begin("/dev/gpiochip0", TEST_TRIG, TEST_ECHO), "lines not requested");
+    io.setRange(0, 500);
+
+    TEST_CHECK(reactor.add(&i2c) == 0, "i2c sensor not added");
+    TEST_CHECK(reactor.add(&io) == 1, "io sensor not added");
+
+    /* A gated echo is no reading, but the sensor is triggered again */
+    uint32_t pulses = mock_gpiod_pulses(io.getEventFd());
+    TEST_CHECK(pulses == 1, "io sensor not triggered by add()");
+    test_echo(io, 5830904);
+    test_run(reactor, 20);
+    TEST_CHECK(readings.count[1] == 0, "gated echo delivered");
+    TEST_CHECK(io.getCounters()->gated == 1, "gated echo not counted");
+    TEST_CHECK(mock_gpiod_pulses(io.getEventFd()) == pulses + 1, "io sensor stalled after a gated echo");
+
+    test_echo(io, 583090);
+    test_run(reactor, 20);
+    TEST_CHECK(readings.count[1] == 1, "echo in range not delivered");
+
+    /* The interval holds the i2c sensor (~270ms so far --> triggers at 0, 100 and 200ms) */
+    test_run(reactor, 230);
+    TEST_CHECK(readings.count[0] >= 2, "i2c readings missing");
+    TEST_CHECK(readings.count[0] <= 3, "reactor ignored the interval");
+    TEST_CHECK(i2c.triggers <= readings.count[0] + 1, "more triggers than readings");
+
+    /* A NAKed trigger is retried by the sensor's own timer */
+    i2c.setInterval(0);
+    i2c.nak_trigger = true;
+    uint32_t triggers = i2c.triggers;
+    test_run(reactor, SONIC_I2C_DATA_TIME / 2);
+    TEST_CHECK(i2c.triggers - triggers <= 1, "NAKed trigger retried without a delay");
+    i2c.nak_trigger = false;
+    uint32_t count = readings.count[0];
+    test_run(reactor, SONIC_I2C_DATA_TIME + 100);
+    TEST_CHECK(readings.count[0] > count, "no reading after the trigger came back");
+
+    reactor.end();
+    io.end();
+    i2c.end();
+    return test_result("linux_reactor_test");
+}
@@ -0,0 +1,180 @@
+/*
+    Test of SONIC_LOG_READER on a log image written by SONIC_LOG across a millis() wrap.
+
+    Checks that the timestamps are unwrapped onto one 64 bit time line, that scan() returns every reading in log
+    order with its sensor, distance and timestamp, and that aggregate() gives the right count, sum, min, max and
+    mean per sensor and window - with one and with several threads, for a range straddling the wrap.
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <type_traits>
+#include <vector>
+#include "Unit_Sonic_LinuxLogReader.h"
+#include "sonic_test.h"
+
+#define TEST_SENSORS 4
+#define TEST_STEPS 7200                         //2h of one reading per sensor and s
+#define TEST_PERIOD_MS 1000
+#define TEST_BASE (0xFFFFFFFFUL - 1800000UL)    //The millis() wrap is 30 min into the log
+#define TEST_WINDOW_MS 300000
+
+static_assert(!std::is_copy_constructible<SONIC_LOG_READER>::value, "SONIC_LOG_READER must not be copyable");
+
+/* Log storage in RAM, dumped to a file once it is written */
+class TEST_STORAGE : public SONIC_LOG_STORAGE {
+    public:
+        explicit TEST_STORAGE(uint32_t size) : _data(size, 0xFF) {}
+
+        uint32_t getSize() override {return (uint32_t)_data.size();}
+        uint8_t read(uint32_t offset, void* data, uint32_t length) override {memcpy(data, &_data[offset], length); return true;}
+        uint8_t write(uint32_t offset, const void* data, uint32_t length) override {
+            for(uint32_t i = 0; i < length; i++) {_data[offset + i] &= ((const uint8_t*)data)[i];}
+            return true;
+        }
+        uint8_t erase(uint32_t offset) override {memset(&_data[offset], 0xFF, SONIC_LOG_SECTOR); return true;}
+
+        uint8_t dump(int fd) {return write_all(fd, _data.data(), _data.size());}
+
+    private:
+        static uint8_t write_all(int fd, const uint8_t* data, size_t length) {
+            while(length) {
+                ssize_t written = ::write(fd, data, length);
+                if(written <= 0) {return false;}
+                data += written;
+                length -= (size_t)written;
+            }
+            return true;
+        }
+
+        std::vector<uint8_t> _data;
+};
+
+/* Reading k of the log (step k / TEST_SENSORS, sensor k % TEST_SENSORS) */
+struct TEST_READING {
+    uint8_t sensor;
+    uint32_t distance_um;
+    uint64_t timestamp_ms;      //Unwrapped
+};
+
+/* What scan() returned, checked against the readings in log order */
+struct TEST_SCAN {
+    const std::vector<TEST_READING>* expected;
+    size_t next;
+    uint8_t wrong;
+};
+
+/* Scan callback - compares a reading with the next one written */
+static void test_scanned(uint8_t sensor, uint32_t distance_um, uint64_t timestamp_ms, void* context) {
+    TEST_SCAN* scan = (TEST_SCAN*)context;
+
+    /* Skip the readings before the range (the first one scanned sets the position) */
+    while((scan->next < scan->expected->size()) && ((*scan->expected)[scan->next].timestamp_ms < timestamp_ms)) {scan->next++;}
+    if(scan->next >= scan->expected->size()) {
+        scan->wrong = true;
+        return;
+    }
+
+    const TEST_READING& reading = (*scan->expected)[scan->next++];
+    if((reading.sensor != sensor) || (reading.distance_um != distance_um) || (reading.timestamp_ms != timestamp_ms)) {scan->wrong = true;}
+}
+
+/* Private function to summarise the expected readings of a range like aggregate() does */
+static std::vector<SONIC_LOG_AGGREGATE> test_aggregate(const std::vector<TEST_READING>& readings, uint64_t from_ms, uint64_t to_ms, uint64_t window_ms) {
+    std::vector<SONIC_LOG_AGGREGATE> result(((to_ms - from_ms) / window_ms + 1) * SONIC_BATCH_MAX_SENSORS, {0, 0, UINT32_MAX, 0});
+
+    for(const TEST_READING& reading : readings) {
+        if((reading.timestamp_ms < from_ms) || (reading.timestamp_ms > to_ms)) {continue;}
+
+        SONIC_LOG_AGGREGATE& summary = result[(reading.timestamp_ms - from_ms) / window_ms * SONIC_BATCH_MAX_SENSORS + reading.sensor];
+        summary.count++;
+        summary.sum += reading.distance_um;
+        if(reading.distance_um < summary.min) {summary.min = reading.distance_um;}
+        if(reading.distance_um > summary.max) {summary.max = reading.distance_um;}
+    }
+    return result;
+}
+
+/* Private function to compare an aggregate() result with the expected one */
+static uint8_t test_same(const std::vector<SONIC_LOG_AGGREGATE>& result, const std::vector<SONIC_LOG_AGGREGATE>& expected) {
+    if(result.size() != expected.size()) {return false;}
+
+    for(size_t i = 0; i < result.size(); i++) {
+        if(result[i].count != expected[i].count) {return false;}
+        if(!expected[i].count) {continue;}
+        if((result[i].sum != expected[i].sum) || (result[i].min != expected[i].min) || (result[i].max != expected[i].max)) {return false;}
+        if(result[i].mean() != (double)expected[i].sum / expected[i].count) {return false;}
+    }
+    return true;
+}
+
+int main() {
+    /* Write the log - a random walk per sensor, sensor s logged s ms after the step */
+    TEST_STORAGE storage(128 * SONIC_LOG_SECTOR);
+    SONIC_LOG log;
+    std::vector<TEST_READING> readings;
+    uint32_t distance[TEST_SENSORS] = {500000, 1000000, 1500000, 2000000};
+
+    TEST_CHECK(log.begin(&storage), "log not mounted");
+    srand(1);
+    for(uint32_t step = 0; step < TEST_STEPS; step++) {
+        for(uint8_t sensor = 0; sensor < TEST_SENSORS; sensor++) {
+            uint64_t timestamp = (uint64_t)TEST_BASE + (uint64_t)step * TEST_PERIOD_MS + sensor;
+
+            distance[sensor] += (rand() % 2001) - 1000;
+            TEST_CHECK(log.add(sensor, distance[sensor], (uint32_t)timestamp), "reading not logged");
+            readings.push_back({sensor, distance[sensor], timestamp});
+        }
+    }
+    TEST_CHECK(log.flush(), "batch not flushed");
+    TEST_CHECK(log.getUsedSectors() < log.getSectors(), "the ring wrapped (the image is too small)");
+
+    char path[] = "/tmp/sonic_log_reader_test_XXXXXX";
+    int fd = mkstemp(path);
+    TEST_CHECK(fd >= 0, "no temporary file");
+    if(fd < 0) {return test_result("log_reader_test");}
+    TEST_CHECK(storage.dump(fd), "image not written");
+    ::close(fd);
+
+    SONIC_LOG_READER reader;
+    TEST_CHECK(reader.open(path), "image not opened");
+    unlink(path);
+
+    /* The time line starts at the first raw timestamp and continues past 2^32 */
+    TEST_CHECK(reader.getStart() == readings.front().timestamp_ms, "wrong start");
+    TEST_CHECK(reader.getEnd() == readings.back().timestamp_ms, "wrong end (timestamps not unwrapped)");
+    TEST_CHECK(reader.getEnd() > 0xFFFFFFFFULL, "the log doesn't cross the millis() wrap");
+
+    /* Every reading, in log order */
+    TEST_SCAN all = {&readings, 0, false};
+    TEST_CHECK(reader.scan(0, UINT64_MAX, test_scanned, &all) == readings.size(), "scan() missed readings");
+    TEST_CHECK(!all.wrong && (all.next == readings.size()), "scan() returned a wrong reading");
+
+    /* A range straddling the wrap (20 to 40 min into the log) */
+    uint64_t from = readings.front().timestamp_ms + 1200000;
+    uint64_t to = readings.front().timestamp_ms + 2400000;
+    uint64_t inside = 0;
+    for(const TEST_READING& reading : readings) {inside += (reading.timestamp_ms >= from) && (reading.timestamp_ms <= to);}
+
+    TEST_SCAN range = {&readings, 0, false};
+    TEST_CHECK(reader.scan(from, to, test_scanned, &range) == inside, "scan() of a range across the wrap miscounted");
+    TEST_CHECK(!range.wrong, "scan() of a range across the wrap returned a wrong reading");
+
+    /* The per sensor and window summaries, single threaded and split across threads */
+    std::vector<SONIC_LOG_AGGREGATE> expected = test_aggregate(readings, from, to, TEST_WINDOW_MS);
+    for(unsigned threads : {1u, 4u}) {
+        std::vector<SONIC_LOG_AGGREGATE> result;
+        TEST_CHECK(reader.aggregate(from, to, TEST_WINDOW_MS, threads, &result) == inside, "aggregate() miscounted the range");
+        TEST_CHECK(test_same(result, expected), "aggregate() summaries differ from the readings");
+    }
+
+    std::vector<SONIC_LOG_AGGREGATE> whole;
+    TEST_CHECK(reader.aggregate(reader.getStart(), reader.getEnd(), 0, 0, &whole) == readings.size(), "aggregate() of the whole log miscounted");
+    TEST_CHECK(test_same(whole, test_aggregate(readings, reader.getStart(), reader.getEnd(), reader.getEnd() - reader.getStart() + 1)), "aggregate() of the whole log differs");
+
+    /* Too many windows are refused instead of allocated */
+    std::vector<SONIC_LOG_AGGREGATE> refused;
+    TEST_CHECK(!reader.aggregate(reader.getStart(), reader.getEnd(), 1, 1, &refused) && refused.empty(), "1ms windows over 2h not refused");
+
+    return test_result("log_reader_test");
+}
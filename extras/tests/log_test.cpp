@@ -0,0 +1,223 @@
+/*
+    Test of SONIC_LOG on a RAM storage with NOR flash semantics.
+
+    Checks that the ring wraps onto the oldest sectors, that a remount finds the ring and the append position
+    again, that a failed sector header write and a failed record write only lose that one batch (the readings
+    before and after them stay readable, also after a remount) and that a query across a millis() wrap finds
+    the readings on both sides of it.
+*/
+#include <string.h>
+#include "Unit_Sonic_Log.h"
+#include "sonic_test.h"
+
+#define TEST_STEP_MS 100
+
+/* RAM storage - a write only clears bits, and the next header / record write can be made to fail (writing nothing) */
+class TEST_STORAGE : public SONIC_LOG_STORAGE {
+    public:
+        uint8_t fail_header = false;
+        uint8_t fail_record = false;
+
+        TEST_STORAGE(uint32_t sectors) : _size(sectors * SONIC_LOG_SECTOR) {
+            _data = new uint8_t[_size];
+            memset(_data, 0xFF, _size);
+        }
+        ~TEST_STORAGE() {delete[] _data;}
+
+        uint32_t getSize() override {return _size;}
+
+        uint8_t read(uint32_t offset, void* data, uint32_t length) override {
+            if(offset + length > _size) {return false;}
+            memcpy(data, &_data[offset], length);
+            return true;
+        }
+
+        uint8_t write(uint32_t offset, const void* data, uint32_t length) override {
+            uint8_t* failed = (offset % SONIC_LOG_SECTOR) ? &fail_record : &fail_header;
+            if(*failed) {
+                *failed = false;
+                return false;
+            }
+
+            if(offset + length > _size) {return false;}
+            for(uint32_t i = 0; i < length; i++) {_data[offset + i] &= ((const uint8_t*)data)[i];}
+            return true;
+        }
+
+        uint8_t erase(uint32_t offset) override {
+            if((offset % SONIC_LOG_SECTOR) || (offset + SONIC_LOG_SECTOR > _size)) {return false;}
+            memset(&_data[offset], 0xFF, SONIC_LOG_SECTOR);
+            return true;
+        }
+
+    private:
+        uint8_t* _data;
+        uint32_t _size;
+};
+
+/* What a query returned - reading i is sensor i % 3 with 100000 + 10 * i um at base + i * TEST_STEP_MS */
+struct TEST_QUERY {
+    uint32_t base;
+    uint32_t count;
+    uint32_t first;
+    uint32_t last;
+    uint8_t wrong;          //A reading that doesn't decode to its index, or is out of order
+};
+
+/* Private function to add reading i */
+static uint8_t test_add(SONIC_LOG& log, uint32_t base, uint32_t i) {
+    return log.add(i % 3, 100000 + 10 * i, base + i * TEST_STEP_MS);
+}
+
+/* Query callback - checks the reading against its index */
+static void test_reading(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms, void* context) {
+    TEST_QUERY* query = (TEST_QUERY*)context;
+    uint32_t i = (distance_um - 100000) / 10;
+
+    if((sensor != i % 3) || (timestamp_ms != query->base + i * TEST_STEP_MS)) {query->wrong = true;}
+    if(query->count && (i <= query->last)) {query->wrong = true;}
+
+    if(!query->count) {query->first = i;}
+    query->last = i;
+    query->count++;
+}
+
+/* Private function to query the log between the timestamps of readings from and to */
+static TEST_QUERY test_query(SONIC_LOG& log, uint32_t base, uint32_t from, uint32_t to) {
+    TEST_QUERY query = {base, 0, 0, 0, false};
+    uint32_t found = log.query(base + from * TEST_STEP_MS, base + to * TEST_STEP_MS, test_reading, &query);
+
+    if(found != query.count) {query.wrong = true;}
+    return query;
+}
+
+/* The ring recycles its oldest sectors and keeps the newest readings in one piece, also after a remount */
+static void test_ring(uint32_t base) {
+    TEST_STORAGE storage(4);
+    SONIC_LOG log;
+    TEST_CHECK(log.begin(&storage), "log not mounted");
+
+    uint32_t count = 100000;
+    for(uint32_t i = 0; i < count; i++) {TEST_CHECK(test_add(log, base, i), "reading not added");}
+    TEST_CHECK(log.flush(), "batch not flushed");
+    TEST_CHECK(log.getUsedSectors() == log.getSectors(), "ring not full");
+    TEST_CHECK(log.getErases() > 2 * log.getSectors(), "ring didn't wrap");
+
+    TEST_QUERY all = test_query(log, base, 0, count);
+    TEST_CHECK(!all.wrong, "wrong reading in the ring");
+    TEST_CHECK(all.last == count - 1, "newest reading missing");
+    TEST_CHECK(all.first > 0, "oldest readings not recycled");
+    TEST_CHECK(all.count == all.last - all.first + 1, "hole in the ring");
+
+    /* A remount finds the same readings and appends behind them */
+    SONIC_LOG remount;
+    TEST_CHECK(remount.begin(&storage), "log not remounted");
+    TEST_CHECK(remount.getUsedSectors() == log.getUsedSectors(), "remount lost sectors");
+
+    TEST_QUERY again = test_query(remount, base, 0, count);
+    TEST_CHECK(!again.wrong && (again.count == all.count) && (again.first == all.first), "remount changed the readings");
+
+    for(uint32_t i = count; i < count + 100; i++) {test_add(remount, base, i);}
+    TEST_CHECK(remount.flush(), "batch not flushed after the remount");
+
+    TEST_QUERY appended = test_query(remount, base, 0, count + 100);
+    TEST_CHECK(!appended.wrong && (appended.last == count + 99), "readings after the remount missing");
+    TEST_CHECK(appended.count == appended.last - appended.first + 1, "remount overwrote readings");
+}
+
+/* A failed record write loses that batch only - the sector is closed instead of leaving a hole in it */
+static void test_failed_record() {
+    TEST_STORAGE storage(8);
+    SONIC_LOG log;
+    TEST_CHECK(log.begin(&storage), "log not mounted");
+
+    for(uint32_t i = 0; i < 300; i++) {test_add(log, 0, i);}
+    TEST_CHECK(log.flush(), "batch not flushed");
+
+    test_add(log, 0, 300);
+    storage.fail_record = true;
+    TEST_CHECK(!log.flush(), "failed record write not reported");
+
+    for(uint32_t i = 301; i < 601; i++) {test_add(log, 0, i);}
+    TEST_CHECK(log.flush(), "batch not flushed after the failed write");
+    TEST_CHECK(test_query(log, 0, 0, 1000).count == 600, "readings behind the failed write lost");
+
+    /* The remount must append behind the readings after the failed write, not over them */
+    SONIC_LOG remount;
+    TEST_CHECK(remount.begin(&storage), "log not remounted");
+    TEST_CHECK(test_query(remount, 0, 0, 1000).count == 600, "readings lost by the remount");
+
+    for(uint32_t i = 601; i < 901; i++) {test_add(remount, 0, i);}
+    TEST_CHECK(remount.flush(), "batch not flushed after the remount");
+
+    TEST_QUERY query = test_query(remount, 0, 0, 1000);
+    TEST_CHECK(!query.wrong, "wrong reading after the failed write");
+    TEST_CHECK(query.count == 900, "readings overwritten after the remount");
+}
+
+/* A failed sector header write loses that batch only - the next one opens the sector again */
+static void test_failed_header() {
+    TEST_STORAGE storage(8);
+    SONIC_LOG log;
+    TEST_CHECK(log.begin(&storage), "log not mounted");
+
+    /* The header of the very first sector fails --> reading 0 is lost and nothing is in the ring */
+    test_add(log, 0, 0);
+    storage.fail_header = true;
+    TEST_CHECK(!log.flush(), "failed header write of the first sector not reported");
+    TEST_CHECK(log.getUsedSectors() == 0, "sector without a header used");
+
+    /* One reading per record from here, so a failed write loses exactly one (the second sector's header fails) */
+    uint32_t failed = 0;
+    uint32_t i = 1;
+    uint8_t armed = false;
+    for(; log.getUsedSectors() < 3; i++) {
+        if((log.getUsedSectors() == 1) && !armed) {storage.fail_header = armed = true;}
+        test_add(log, 0, i);
+        if(!log.flush()) {failed++;}
+    }
+
+    TEST_CHECK(failed == 1, "failed header write not reported once");
+    TEST_QUERY query = test_query(log, 0, 0, i);
+    TEST_CHECK(!query.wrong, "wrong reading after the failed header");
+    TEST_CHECK((query.first == 1) && (query.count == i - 2), "failed header lost more than its batch");
+
+    SONIC_LOG remount;
+    TEST_CHECK(remount.begin(&storage), "log not remounted");
+    TEST_CHECK(remount.getUsedSectors() == 3, "remount found the wrong sectors");
+    TEST_CHECK(test_query(remount, 0, 0, i).count == i - 2, "readings lost by the remount");
+}
+
+/* A query across a millis() wrap finds the readings on both sides */
+static void test_wrap() {
+    TEST_STORAGE storage(8);
+    SONIC_LOG log;
+    uint32_t base = 0xFFFFFFFFUL - 500 * TEST_STEP_MS;
+    TEST_CHECK(log.begin(&storage), "log not mounted");
+
+    for(uint32_t i = 0; i < 1000; i++) {test_add(log, base, i);}
+    TEST_CHECK(log.flush(), "batch not flushed");
+
+    TEST_QUERY across = test_query(log, base, 400, 700);
+    TEST_CHECK(!across.wrong, "wrong reading across the wrap");
+    TEST_CHECK((across.count == 301) && (across.first == 400) && (across.last == 700), "wrong range across the wrap");
+
+    TEST_QUERY all = test_query(log, base, 0, 999);
+    TEST_CHECK(all.count == 1000, "readings missing across the wrap");
+
+    /* Once the history spans the wrap, 0 is a time inside it - query(0, now) starts at the wrap (reading 501) */
+    TEST_QUERY since_wrap = {base, 0, 0, 0, false};
+    log.query(0, base + 999 * TEST_STEP_MS, test_reading, &since_wrap);
+    TEST_CHECK(!since_wrap.wrong && (since_wrap.first == 501) && (since_wrap.count == 499), "query(0, now) didn't start at the wrap");
+
+    /* The ring itself across the wrap */
+    test_ring(base);
+}
+
+int main() {
+    test_ring(0);
+    test_failed_record();
+    test_failed_header();
+    test_wrap();
+    return test_result("log_test");
+}
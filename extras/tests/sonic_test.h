@@ -0,0 +1,28 @@
+/*
+    Shared pieces of the Unit Sonic host tests (registered with CTest).
+
+    TEST_CHECK prints the failed condition and counts it, test_result() turns the count into the exit code, so a
+    test keeps running after the first failure and reports everything that broke.
+*/
+#ifndef _SONIC_TEST_H_
+    #define _SONIC_TEST_H_
+
+    #include <stdio.h>
+    #include <stdint.h>
+
+    #define TEST_CHECK(condition, message) do {if(!(condition)) {test_fail(message, __FILE__, __LINE__);}} while(0)
+
+    static uint32_t test_failures = 0;
+
+    static inline void test_fail(const char* message, const char* file, int line) {
+        fprintf(stderr, "%s:%d: FAIL %s\n", file, line, message);
+        test_failures++;
+    }
+
+    /* Prints the summary - returns the exit code of the test */
+    static inline int test_result(const char* name) {
+        printf("%s: %s\n", name, test_failures ? "FAILED" : "passed");
+        return test_failures ? 1 : 0;
+    }
+
+#endif
@@ -0,0 +1,97 @@
+/*
+    Host query tool for SONIC_LOG images (partition dumps or host build log files).
+
+    Prints one CSV line per file, sensor and time window with the count, min, max and mean distance, or with -r
+    every raw reading.  Times are ms on the log's unwrapped time line (see Unit_Sonic_LinuxLogReader.h).
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -O2 -pthread -Isrc extras/tools/sonic_log_query.cpp src/Unit_Sonic_LinuxLogReader.cpp \
+            src/Unit_Sonic_Batch.cpp -o sonic_log_query
+
+    Usage: sonic_log_query [-w window_ms=3600000] [-f from_ms] [-t to_ms] [-j threads=cores] [-r] log.bin...
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "Unit_Sonic_LinuxLogReader.h"
+
+/* Prints every raw reading as file,timestamp_ms,sensor,distance_um */
+static void print_reading(uint8_t sensor, uint32_t distance_um, uint64_t timestamp_ms, void *context) {
+    printf("%d,%llu,%u,%u\n", *(int *)context, (unsigned long long)timestamp_ms, sensor, distance_um);
+}
+
+/* Private function to get the monotonic time in s */
+static double tool_seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    uint64_t window_ms = 3600000;
+    uint64_t from_ms = 0;
+    uint64_t to_ms = UINT64_MAX;
+    unsigned threads = 0;
+    uint8_t raw = false;
+    int option;
+
+    while((option = getopt(argc, argv, "w:f:t:j:r")) != -1) {
+        switch(option) {
+            case 'w': window_ms = strtoull(optarg, nullptr, 10); break;
+            case 'f': from_ms = strtoull(optarg, nullptr, 10); break;
+            case 't': to_ms = strtoull(optarg, nullptr, 10); break;
+            case 'j': threads = (unsigned)strtoul(optarg, nullptr, 10); break;
+            case 'r': raw = true; break;
+            default:
+                fprintf(stderr, "usage: %s [-w window_ms] [-f from_ms] [-t to_ms] [-j threads] [-r] log.bin...\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if(optind >= argc) {
+        fprintf(stderr, "no log files given\n");
+        return 1;
+    }
+
+    printf(raw ? "file,timestamp_ms,sensor,distance_um\n" : "file,sensor,window_start_ms,count,min_um,max_um,mean_um\n");
+
+    for(int file = 0; optind + file < argc; file++) {
+        const char *path = argv[optind + file];
+        SONIC_LOG_READER reader;
+        double started = tool_seconds();
+
+        if(!reader.open(path)) {
+            fprintf(stderr, "%s: not a readable Unit Sonic log\n", path);
+            continue;
+        }
+
+        uint64_t from = (from_ms > reader.getStart()) ? from_ms : reader.getStart();
+        uint64_t to = (to_ms < reader.getEnd()) ? to_ms : reader.getEnd();
+        uint64_t readings;
+
+        if(raw) {
+            readings = reader.scan(from, to, print_reading, &file);
+        } else {
+            std::vector<SONIC_LOG_AGGREGATE> windows;
+            readings = reader.aggregate(from, to, window_ms, threads, &windows);
+            if(windows.empty() && (from <= to) && reader.getSectors()) {
+                fprintf(stderr, "%s: more than %u windows, use a longer window\n", path, (unsigned)SONIC_LOG_READER_MAX_WINDOWS);
+                continue;
+            }
+
+            for(size_t i = 0; i < windows.size(); i++) {
+                const SONIC_LOG_AGGREGATE &window = windows[i];
+                if(!window.count) {continue;}
+
+                printf("%d,%u,%llu,%llu,%u,%u,%.1f\n", file, (unsigned)(i % SONIC_BATCH_MAX_SENSORS),
+                       (unsigned long long)(from + (i / SONIC_BATCH_MAX_SENSORS) * window_ms), (unsigned long long)window.count,
+                       window.min, window.max, window.mean());
+            }
+        }
+
+        fprintf(stderr, "%s: %u sectors, %llu readings in %.3fs\n", path, reader.getSectors(), (unsigned long long)readings, tool_seconds() - started);
+    }
+
+    return 0;
+}
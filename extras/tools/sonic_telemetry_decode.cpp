@@ -0,0 +1,48 @@
+/*
+    Host decoder for the Unit Sonic binary telemetry (see src/Unit_Sonic_Telemetry.h).
+
+    Reads the raw byte stream from a file, a serial device or stdin and prints one CSV line per reading.
+    Frame statistics go to stderr.
+
+    Build (from the repository root, or use the CMake host project):
+        g++ -O2 -Isrc extras/tools/sonic_telemetry_decode.cpp src/Unit_Sonic_Telemetry.cpp \
+            src/Unit_Sonic_Batch.cpp -o sonic_telemetry_decode
+
+    Usage: sonic_telemetry_decode [capture.bin | /dev/ttyUSB0]      (configure a serial port first, e.g.
+           stty -F /dev/ttyUSB0 921600 raw)
+*/
+#include <stdio.h>
+#include <string.h>
+#include "Unit_Sonic_Telemetry.h"
+
+/* Prints every decoded reading as timestamp_ms,sensor,distance_um */
+static void print_reading(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms, void* context) {
+    (void)context;
+    printf("%u,%u,%u\n", timestamp_ms, sensor, distance_um);
+}
+
+int main(int argc, char** argv) {
+    FILE* in = stdin;
+
+    if((argc > 1) && strcmp(argv[1], "-")) {
+        in = fopen(argv[1], "rb");
+        if(!in) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    SONIC_TELEMETRY_DECODER decoder(print_reading);
+    uint8_t buffer[4096];
+    size_t length;
+
+    printf("timestamp_ms,sensor,distance_um\n");
+    while((length = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+        decoder.feed(buffer, (uint32_t)length);
+        fflush(stdout);
+    }
+
+    fprintf(stderr, "frames=%u errors=%u lost=%u\n", decoder.getFrames(), decoder.getErrors(), decoder.getLost());
+    if(in != stdin) {fclose(in);}
+    return 0;
+}
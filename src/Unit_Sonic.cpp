@@ -1,4 +1,10 @@
 #include "Unit_Sonic.h"
+#include "Unit_Sonic_Clock.h"
+
+#if defined(SONIC_PLATFORM_ARDUINO)
+
+static_assert(sizeof(SONIC_I2C) <= SONIC_I2C_BYTES, "SONIC_I2C outgrew its RAM budget");
+static_assert(sizeof(SONIC_IO) <= SONIC_IO_BYTES, "SONIC_IO outgrew its RAM budget");
 
 /* 
     Additions made by Ryan Klassing to convert the driver from blocking to
@@ -8,14 +14,11 @@
 
 /* Initializes the I2C bus for the sensor*/
 uint8_t SONIC_I2C::begin(TwoWire* wire, uint8_t addr, uint8_t sda, uint8_t scl, uint32_t speed) {
-    _wire  = wire;
-    _addr  = addr;
-    _sda   = sda;
-    _scl   = scl;
-    _speed = speed;
+    _wire = wire;
+    _addr = addr;
     _wire->end();   //Verify the I2C bus hasn't been initialized previously with different configs
-    _wire->begin((int)_sda, (int)_scl, (uint32_t)_speed);
-    _sensor_busy = false;
+    _wire->begin((int)sda, (int)scl, speed);
+    reset();
 
     /* Verify that a sensor was detected */
     _wire->beginTransmission(_addr);
@@ -24,123 +27,194 @@ uint8_t SONIC_I2C::begin(TwoWire* wire, uint8_t addr, uint8_t sda, uint8_t scl,
     return !_wire->endTransmission();
 }
 
+/* Changes the I2C bus speed at run time */
+uint8_t SONIC_I2C::setSpeed(uint32_t speed) {
+    _wire->setClock(speed);
+    return true;
+}
+
 /* 
     Checks whether or not new data is available - this should be polled in the user's loop.  Once the function
     returns true --> the user should get the new data by calling the respective getDistance() or getDistance_uint16()
 */
 uint8_t SONIC_I2C::readingAvailable() {
-    /* 
-        I'm not able to find a datasheet for this chip, so reverse engineering a bit from 
-        the original driver.  They send 0x01 to the chip, wait 120ms, then read 3 bytes back.
-        I would normally assume this is simply reading from 3 bytes starting at page 0x1,
-        but since they wait 120ms between the write and read, I'm guessing 0x01 triggers
-        the pulse, the chip performs the measurement, and then the chip makes the data available.
-
-        So, we'll simply treat this like an ADC that has a conversion time by keeping track of a 
-        "data ready" timer flag.  If the flag hasn't expired, we'll simply return the old measurement
-        data.  If the timer has expired, then we'll grab new data to return.  Easy peasy.
-   */
-
-    if(!_sensor_busy) {
-
-        /* Trigger a data collection */
-        _wire->beginTransmission(_addr);    // Transfer data to 0x57. 将数据传输到0x57
-        _wire->write(0x01);                 // Trigger the sensor reading
-        _wire->endTransmission();           // Stop data transmission with the Ultrasonic
-
-        /* Start the timer and flag that the sensor is busy */
-        _sensor_busy = true;
-        start_timer(&_sensor_data_timer);
-    }
-
-    /* See if the new data is available */
-    if(timer_expired(&_sensor_data_timer, SONIC_I2C_DATA_TIME)) {
-        const uint8_t bytes_to_read = 3;
-
-        /* Read the data from the sensor */
-        _wire->requestFrom(_addr, bytes_to_read);       // Request 3 bytes from Ultrasonic Unit
-
-        /* Clear the old data */
-        _sensor_data = 0;
-
-        /* Read the bytes and shift the data as needed (data is big endian) */
-        for (uint8_t i = bytes_to_read; i > 0; i--) {_sensor_data |= (_wire->read() << (8 * (i - 1)));}
-
-        /* Flag that the sensor is no longer busy and stop the timer */
-        _sensor_busy = false;
-        stop_timer(&_sensor_data_timer);
-
-        /* Flag that the sensor has data available */
-        return true;
+    SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_POLL);
+    uint64_t now = SONIC_CLOCK::millis64();
+
+    switch(poll(now)) {
+        case SONIC_ACTION_TRIGGER: {
+            /* Trigger a data collection */
+            SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_TRIGGER);
+            _wire->beginTransmission(_addr);    // Transfer data to 0x57. 将数据传输到0x57
+            _wire->write(0x01);                 // Trigger the sensor reading
+
+            /* endTransmission returns 0 on success - a NAKed trigger starts no conversion --> hold the next attempt off */
+            if(_wire->endTransmission()) {
+                trigger_failed(now);
+                break;
+            }
+            triggered(now);
+            break;
+        }
+
+        case SONIC_ACTION_READ: {
+            /* Read the data from the sensor and let the core decode it */
+            uint8_t data[3];
+            uint8_t length;
+            {
+                SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_READ);
+                length = read_data(data);
+            }
+            return received(data, length, now);
+        }
     }
 
     /* If we made it here, there isn't any new data */
     return false;
 }
 
+/* Drives the burst - returns true once it is complete and the result has been written */
+uint8_t SONIC_I2C::burstAvailable(SONIC_BURST_RESULT* result) {
+    /* The conversion time already covers the echo window, so readings can go back-to-back */
+    return readingAvailable() && collect_burst(result);
+}
+
 /* 
-    Gets the raw distance in mm of the sensor.  This will always contain the latest reading.  If the user wishes
-    to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
-    Otherwise, the user will read the same data over and over throwing off the average count.
+    Blocking routine (call it from setup()) that probes the chip with progressively shorter trigger-to-read
+    delays to find the fastest reliable conversion time for the distance band currently in front of the sensor.
 */
-float SONIC_I2C::getDistance() {
-    /* 
-        Since we now have a global data tracking the integer of the readings, 
-        simply make sure its up to date and then convert it to a floating point
-    */
+uint8_t SONIC_I2C::calibrate() {
+    uint32_t reference = 0;
+    uint32_t previous = 0;
+    uint8_t found = SONIC_I2C_DATA_TIME;
+
+    /* Make sure we don't collide with a measurement that readingAvailable() already started */
+    if(getStatus()) {
+        delay(SONIC_I2C_DATA_TIME);
+        reset();
+    }
 
-    /* Convert the distance to floating point and in mm */
-    float Distance = float(_sensor_data) / 1000.0;
+    /* Take the reference reading with the known-good conversion time */
+    if(!probe(SONIC_I2C_DATA_TIME, &reference)) {return false;}
+    previous = reference;
+
+    /* Walk the delay up from the minimum until a delay passes every check SONIC_I2C_CAL_REPEATS times in a row */
+    for(uint8_t wait = SONIC_I2C_CAL_MIN_TIME; wait < SONIC_I2C_DATA_TIME; wait += SONIC_I2C_CAL_STEP) {
+        uint8_t good = 0;
+
+        while(good < SONIC_I2C_CAL_REPEATS) {
+            uint32_t early = 0;
+            uint32_t repeat = 0;
+            uint8_t ok = probe(wait, &early);
+
+            /* 
+                The raw data is in um, so two separate conversions practically never match to the bit.  An identical
+                value means the chip handed back the previous conversion.  A repeated read that differs means the
+                result register hasn't settled yet.
+            */
+            ok = ok && (early != previous);
+            ok = ok && probe(0, &repeat) && (repeat == early);
+            ok = ok && (((early > reference) ? (early - reference) : (reference - early)) <= SONIC_I2C_CAL_TOLERANCE_UM);
+
+            if(!ok) {
+                /* Let the chip finish whatever conversion it may still be running before the next probe */
+                delay(SONIC_I2C_DATA_TIME - wait);
+                break;
+            }
+
+            previous = early;
+            good++;
+        }
+
+        if(good == SONIC_I2C_CAL_REPEATS) {
+            found = wait;
+            break;
+        }
+    }
 
-    /* Clamp the max distance */
-    return min(Distance, float(SONIC_MAX_DISTANCE));
+    /* Store the result with some margin */
+    calibrated(reference, min((uint8_t)(found + SONIC_I2C_CAL_MARGIN), (uint8_t)SONIC_I2C_DATA_TIME));
+    return true;
 }
 
 /* 
-    Gets the raw distance truncated to the nearest mm of the sensor.  This will always contain the latest reading.  
-    If the user wishes to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
-    Otherwise, the user will read the same data over and over throwing off the average count.
+    Private function to perform a single blocking trigger --> wait --> read cycle used by calibrate().
+    A wait of 0 skips the trigger and only repeats the read.
 */
-uint16_t SONIC_I2C::getDistance_uint16() {
+uint8_t SONIC_I2C::probe(uint8_t wait, uint32_t *data) {
+    uint8_t bytes[3];
 
-    /* Clamp the max distance to be returned */
-    return min((uint16_t)(_sensor_data / 1000), (uint16_t)SONIC_MAX_DISTANCE);
-}
+    if(wait) {
+        _wire->beginTransmission(_addr);
+        _wire->write(0x01);
+        if(_wire->endTransmission() != 0) {return false;}
 
-/* Allows the calling functions to check whether or not the sensor is busy */
-uint8_t SONIC_I2C::getStatus() {
-    return _sensor_busy;
-}
+        delay(wait);
+    }
+
+    if(read_data(bytes) != sizeof(bytes)) {return false;}
 
-/* Private function to start various timers */
-void SONIC_I2C::start_timer(uint32_t *timer) {*timer = millis();}
+    *data = ((uint32_t)bytes[0] << 16) | ((uint32_t)bytes[1] << 8) | bytes[2];
+    return true;
+}
 
-/* Private function to check if a timer has expired */
-uint8_t SONIC_I2C::timer_expired(uint32_t *timer, uint32_t timeout) {return (millis() - *timer > timeout && *timer != 0) ? true : false;}
+/* Private function to read the 3 data bytes - returns the number of bytes actually received */
+uint8_t SONIC_I2C::read_data(uint8_t *data) {
+    const uint8_t bytes_to_read = 3;
+
+    /* Request 3 bytes from Ultrasonic Unit (big endian) */
+    uint8_t bytes_read = _wire->requestFrom(_addr, bytes_to_read);
+    if(bytes_read > bytes_to_read) {bytes_read = bytes_to_read;}
+
+    /* Some Wire implementations report the requested length even if fewer bytes arrived - read() returns -1 for those */
+    for(uint8_t i = 0; i < bytes_read; i++) {
+        int value = _wire->read();
+        if(value < 0) {
+            bytes_read = i;
+            break;
+        }
+        data[i] = (uint8_t)value;
+    }
+    while(_wire->available()) {_wire->read();}
 
-/* Private function to stop/reset a timer */
-void SONIC_I2C::stop_timer(uint32_t *timer) {*timer = 0;}
+    return bytes_read;
+}
 
 /* Initializes the private variables for the sensor */
 void SONIC_IO::begin(uint8_t trig_pin /*=26*/, uint8_t echo_pin /*=32*/) {
     _trig_pin = trig_pin;
     _echo_pin = echo_pin;
-    _sensor_pulse_duration = 0;
-    _sensor_busy = false;
-    _sensor_data_ready = false;
+    reset();
 
     pinMode(_trig_pin, OUTPUT);
     pinMode(_echo_pin, INPUT);
 }
 
+/* Attaches the echo pin interrupt (both edges) - attachInterruptArg() hands the sensor to the shared ISR */
+void SONIC_IO::attachEcho() {
+    attachInterruptArg(digitalPinToInterrupt(_echo_pin), echo_isr, this, CHANGE);
+}
+
+/* Private function for the echo pin interrupt (both edges) */
+void SONIC_IO::echo_isr(void* arg) {
+    SONIC_IO* sensor = (SONIC_IO*)arg;
+
+    if(digitalRead(sensor->_echo_pin)) {
+        sensor->echo_isr_rising();
+    } else {
+        sensor->echo_isr_falling();
+    }
+}
+
 /* 
     This should be called by the user's ISR on the echo pin, set to RISING edge trigger.
     This will start the pulse measuring timer.
 */
 void SONIC_IO::echo_isr_rising() {
-    /* Start the pulse measurement timer */
-    _sensor_pulse_start = micros();
+    SONIC_TRACE_SCOPE(SONIC_TRACE_ECHO_RISING);
 
+    /* Start the pulse measurement timer */
+    echo_rising(micros());
 }
 
 /* 
@@ -148,12 +222,10 @@ void SONIC_IO::echo_isr_rising() {
     This will be used to calculate the duration of the echo pulse
 */
 void SONIC_IO::echo_isr_falling() {
-    /* Calculate the pulse duration */
-    _sensor_pulse_duration = micros() - _sensor_pulse_start;
-
-    /* Flag that the sensor is no longer busy */
-    _sensor_data_ready = true;
+    SONIC_TRACE_SCOPE(SONIC_TRACE_ECHO_FALLING);
 
+    /* Calculate the pulse duration and flag that the data is ready */
+    echo_falling(micros());
 }
 
 /* 
@@ -161,88 +233,33 @@ void SONIC_IO::echo_isr_falling() {
     returns true --> the user should get the new data by calling the respective getDistance() or getDistance_uint16()
 */
 uint8_t SONIC_IO::readingAvailable() {
-    /* 
-        I'm not able to find a datasheet for this chip, so reverse engineering a bit from 
-        the original driver.  They send a 10us pulse on the _trig_pin, then measure a pulse
-        of LOW-HIGH-LOW (duration of HIGH) in microseconds, to determine the amount of time
-        for sound to travel to the target and return.
-   */
-
-    if(!_sensor_busy) {
-
-        /* Trigger a data collection */
-        digitalWrite(_trig_pin, HIGH);
-        delayMicroseconds(SONIC_IO_TRIG_PULSE_US);
-        digitalWrite(_trig_pin, LOW);
-
-        /* Start the timeout timer and flag that the sensor is busy */
-        _sensor_busy = true;
-        _sensor_data_ready = false;
-        start_timer(&_sensor_timeout_timer);
-    }
-
-    /* See if there is new data available */
-    if(_sensor_data_ready) {
-        _sensor_data = U32_SONIC_PULSE_TO_UM(_sensor_pulse_duration);
-
-        data_collected();
-
-        /* Flag that the sensor has data available */
-        return true;
-    }
-
-    /* See if a timeout has occured */
-    if(timer_expired(&_sensor_timeout_timer, SONIC_IO_TIMEOUT_MS)) {
-        /* Clear all pending measurements since the object is too far away to measure */
-        _sensor_data = SONIC_MAX_DISTANCE;
-        data_collected();
-
-        /* Flag that the sensor has data available */
-        return true;
+    SONIC_TRACE_SCOPE(SONIC_TRACE_IO_POLL);
+    uint64_t now = SONIC_CLOCK::millis64();
+
+    switch(poll(now)) {
+        case SONIC_ACTION_TRIGGER: {
+            /* Trigger a data collection */
+            SONIC_TRACE_SCOPE(SONIC_TRACE_IO_TRIGGER);
+            digitalWrite(_trig_pin, HIGH);
+            delayMicroseconds(SONIC_IO_TRIG_PULSE_US);
+            digitalWrite(_trig_pin, LOW);
+            triggered(now);
+            break;
+        }
+
+        case SONIC_ACTION_READING:
+            /* Flag that the sensor has data available */
+            return true;
     }
 
     /* If we made it here, there isn't any new data */
     return false;
 }
 
-/* 
-    Gets the raw distance in mm of the sensor.  This will always contain the latest reading.  If the user wishes
-    to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
-    Otherwise, the user will read the same data over and over throwing off the average count.
-*/
-float SONIC_IO::getDistance() {
-    /* Clamp the max distance to be returned */
-    return min(F_SONIC_UM_TO_MM(_sensor_data), float(SONIC_MAX_DISTANCE));
-}
-
-/* 
-    Gets the raw distance truncated to the nearest mm of the sensor.  This will always contain the latest reading.  
-    If the user wishes to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
-    Otherwise, the user will read the same data over and over throwing off the average count.
-*/
-uint16_t SONIC_IO::getDistance_uint16() {
-
-    /* Clamp the max distance to be returned */
-    return min(U16_SONIC_UM_TO_MM(_sensor_data), (uint16_t)SONIC_MAX_DISTANCE);
-}
-
-/* Allows the calling functions to check whether or not the sensor is busy */
-uint8_t SONIC_IO::getStatus() {
-    return _sensor_busy;
+/* Drives the burst - returns true once it is complete and the result has been written */
+uint8_t SONIC_IO::burstAvailable(SONIC_BURST_RESULT* result) {
+    /* The core holds off the next ping until the echoes of the previous one died out */
+    return readingAvailable() && collect_burst(result);
 }
 
-/* Private function to start various timers */
-void SONIC_IO::start_timer(uint32_t *timer) {*timer = millis();}
-
-/* Private function to check if a timer has expired */
-uint8_t SONIC_IO::timer_expired(uint32_t *timer, uint32_t timeout) {return (millis() - *timer > timeout && *timer != 0) ? true : false;}
-
-/* Private function to stop/reset a timer */
-void SONIC_IO::stop_timer(uint32_t *timer) {*timer = 0;}
-
-/* Private function to clear variables when we've completed a new measurement */
-void SONIC_IO::data_collected() {
-    stop_timer(&_sensor_timeout_timer);
-    _sensor_data_ready = false;
-    _sensor_busy = false;
-}
\ No newline at end of file
+#endif
@@ -16,78 +16,81 @@
 #ifndef _UNIT_SONIC_H_
     #define _UNIT_SONIC_H_
 
+    #include "Unit_Sonic_Config.h"
+
+    #if defined(SONIC_PLATFORM_IDF)
+        #include "Unit_Sonic_IDF.h"
+    #elif defined(SONIC_PLATFORM_LINUX)
+        #include "Unit_Sonic_LinuxI2C.h"
+        #include "Unit_Sonic_LinuxGPIO.h"
+        #include "Unit_Sonic_LinuxReactor.h"
+    #endif
+
+    #if defined(SONIC_PLATFORM_ARDUINO)
+
     #include "Arduino.h"
     #include "Wire.h"
     #include "pins_arduino.h"
+    #include "Unit_Sonic_Core.h"
 
-    #define SONIC_MAX_DISTANCE 4500     //4500mm is the farthest distance this chip can detect
-    #define SONIC_MIN_DISTANCE 20       //20mm is the smallest we expect to be able to read
-    #define SONIC_I2C_DATA_TIME 120     //120ms needed to get data from the chip
-
-    #define SONIC_IO_TRIG_PULSE_US 10   //10us needed to start the pulse from the chip
-    #define SONIC_IO_TIMEOUT_MS 120 //((2 * SONIC_MAX_DISTANCE / 343) + 1)     //Sets a timeout for the total time needed to measure the maximum distance - accounting for out/return flight
+    /* RAM budget of one adapter (32 bit targets / 64 bit hosts), the core's budget plus the bus / pins - see SONIC_I2C_CORE_BYTES */
+    #define SONIC_I2C_BYTES ((sizeof(void*) == 4) ? 64 : 80)
+    #define SONIC_IO_BYTES ((sizeof(void*) == 4) ? 64 : 72)
 
-    #define SONIC_SOUND_US_TO_UM(x) (x * 343)                                       //Sound travels 343um in 1us
-    #define U32_SONIC_PULSE_TO_UM(x) (uint32_t)(SONIC_SOUND_US_TO_UM(x)/2)          //Pulses include time-to-target + return flight --> only need half the pulse width, measured in micrometers
-    #define U16_SONIC_UM_TO_MM(x) (uint16_t)(x/1000)                                //Convert to truncated mm
-    #define F_SONIC_UM_TO_MM(x) float(x/1000.0)                                     //Convert to mm floating point
-
-    class SONIC_I2C {
+    /* 
+        Arduino adapters - the state machines, conversions and filters live in Unit_Sonic_Core.h,
+        these only drive the Wire bus / pins and feed SONIC_CLOCK (ms) and micros() (echo edges) into the cores.
+    */
+    class SONIC_I2C : public SONIC_I2C_CORE {
         public:
             /* Initializes the I2C bus for the sensor - returns whether it was detected or not */
             uint8_t begin(TwoWire* wire = &Wire, uint8_t addr = 0x57, uint8_t sda = SDA, uint8_t scl = SCL, uint32_t speed = 200000L);
 
+            /* Changes the I2C bus speed at run time (affects every device on the bus) - returns true */
+            uint8_t setSpeed(uint32_t speed);
+
             /* 
                 Checks whether or not new data is available - this should be polled in the user's loop.  Once the function
                 returns true --> the user should get the new data by calling the respective getDistance() or getDistance_uint16()
             */
             uint8_t readingAvailable();
 
-            /* 
-                Gets the raw distance in mm of the sensor.  This will always contain the latest reading.  If the user wishes
-                to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
-                Otherwise, the user will read the same data over and over throwing off the average count.
-            */
-            float getDistance();
+            /* Drives the burst started by startBurst() - returns true once it is complete and the result has been written */
+            uint8_t burstAvailable(SONIC_BURST_RESULT* result);
 
             /* 
-                Gets the raw distance truncated to the nearest mm of the sensor.  This will always contain the latest reading.  
-                If the user wishes to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
-                Otherwise, the user will read the same data over and over throwing off the average count.
+                Blocking routine (call it from setup()) that probes the chip with progressively shorter trigger-to-read
+                delays to find the fastest reliable conversion time for the distance band currently in front of the sensor.
+                Early reads are rejected if the chip NAKs, hands back the previous conversion, changes on a repeated read,
+                or disagrees with a reference reading taken at SONIC_I2C_DATA_TIME.  Call it once per band of interest
+                (e.g. with a target near, mid and far) - nearer bands inherit a faster result automatically.
+                Returns true if a reference reading could be taken.
             */
-            uint16_t getDistance_uint16();
-
-            /* Allows the calling functions to check whether or not the sensor is busy */
-            uint8_t getStatus();
+            uint8_t calibrate();
 
         private:
-            /* Private variables to be used for setting up the I2C parameters for this sensor*/
-            uint8_t _addr;
+            /* Private variables to be used for talking to this sensor (the pins and speed only matter in begin()) */
             TwoWire* _wire;
-            uint8_t _scl;
-            uint8_t _sda;
-            uint8_t _speed;
-
-            /* Private function to start various timers */
-            void start_timer(uint32_t *timer);
-
-            /* Private function to check if a timer has expired */
-            uint8_t timer_expired(uint32_t *timer, uint32_t timeout);
+            uint8_t _addr;
 
-            /* Private function to stop/reset a timer */
-            void stop_timer(uint32_t *timer); 
+            /* Private function to perform a single blocking trigger --> wait --> read cycle used by calibrate() */
+            uint8_t probe(uint8_t wait, uint32_t *data);
 
-            /* Private variables to keep track of the measurement_ready timer */
-            uint32_t _sensor_data_timer = 0;
-            uint32_t _sensor_data = SONIC_MAX_DISTANCE;
-            uint8_t _sensor_busy = false;
+            /* Private function to read the 3 data bytes - returns the number of bytes actually received */
+            uint8_t read_data(uint8_t *data);
     };
 
-    class SONIC_IO {
+    class SONIC_IO : public SONIC_IO_CORE {
         public:
             /* Initializes the private variables for the sensor */
             void begin(uint8_t trig_pin = 26, uint8_t echo_pin = 32);
 
+            /* 
+                Attaches the echo pin interrupt (both edges) that times the echo pulse - call it after begin().  Takes the
+                place of a user ISR calling echo_isr_rising()/echo_isr_falling(), and works for any number of sensors.
+            */
+            void attachEcho();
+
             /* 
                 This should be called by the user's ISR on the echo pin, set to RISING edge trigger.
                 This will start the pulse measuring timer.
@@ -106,48 +109,18 @@
             */
             uint8_t readingAvailable();
 
-            /* 
-                Gets the raw distance in mm of the sensor.  This will always contain the latest reading.  If the user wishes
-                to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
-                Otherwise, the user will read the same data over and over throwing off the average count.
-            */
-            float getDistance();
-
-            /* 
-                Gets the raw distance truncated to the nearest mm of the sensor.  This will always contain the latest reading.  
-                If the user wishes to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
-                Otherwise, the user will read the same data over and over throwing off the average count.
-            */
-            uint16_t getDistance_uint16();
-
-            /* Allows the calling functions to check whether or not the sensor is busy */
-            uint8_t getStatus();
+            /* Drives the burst started by startBurst() - returns true once it is complete and the result has been written */
+            uint8_t burstAvailable(SONIC_BURST_RESULT* result);
 
         private:
-
-            /* Private function to start various timers */
-            void start_timer(uint32_t *timer);
-
-            /* Private function to check if a timer has expired */
-            uint8_t timer_expired(uint32_t *timer, uint32_t timeout);
-
-            /* Private function to stop/reset a timer */
-            void stop_timer(uint32_t *timer); 
-
-            /* Private function to clear variables when we've completed a new measurement */
-            void data_collected();
+            /* Private function for the echo pin interrupt (both edges) */
+            static void echo_isr(void* arg);
 
             /* Private variables to keep track of pin settings */
             uint8_t _trig_pin;
             uint8_t _echo_pin;
-
-            /* Private variables for tracking the IO pulse duration */
-            uint32_t _sensor_pulse_start = 0;
-            uint32_t _sensor_timeout_timer = 0;
-            uint32_t _sensor_pulse_duration = 0;
-            uint32_t _sensor_data = SONIC_MAX_DISTANCE;
-            uint8_t _sensor_busy = false;
-            uint8_t _sensor_data_ready = false;
     };
 
-#endif
\ No newline at end of file
+    #endif
+
+#endif
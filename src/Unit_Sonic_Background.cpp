@@ -0,0 +1,88 @@
+#include "Unit_Sonic_Background.h"
+#include <math.h>
+
+/* Sets up the model parameters and restarts learning */
+void SONIC_BACKGROUND::begin(uint16_t learn_samples, float threshold_sigma, uint16_t min_deviation_mm, uint16_t adapt_window) {
+    _learn_samples = (learn_samples > 1) ? learn_samples : 2;
+    _threshold_sigma = threshold_sigma;
+    _min_deviation = min_deviation_mm;
+    _adapt_window = (adapt_window > _learn_samples) ? adapt_window : _learn_samples;
+    relearn();
+}
+
+/* Registers the callback for foreground events */
+void SONIC_BACKGROUND::onEvent(callback_t callback, void *context) {
+    _callback = callback;
+    _context = context;
+}
+
+/* Throws away the learned scene and starts learning again */
+void SONIC_BACKGROUND::relearn() {
+    _count = 0;
+    _mean = 0;
+    _m2 = 0;
+    _foreground = false;
+}
+
+/* Feeds a reading into the model and returns its state */
+uint8_t SONIC_BACKGROUND::update(uint32_t distance_um, uint32_t timestamp_ms) {
+    float distance = distance_um / 1000.0f;
+
+    /* Everything seen while learning is treated as the empty scene */
+    if(_count < _learn_samples) {
+        learn(distance);
+        return SONIC_BG_LEARNING;
+    }
+
+    /* Compare the deviation against the learned spread, but never tighter than the minimum deviation */
+    float threshold = _threshold_sigma * getStdDev();
+    if(threshold < _min_deviation) {threshold = _min_deviation;}
+
+    if(fabsf(distance - _mean) > threshold) {
+        if(!_foreground) {
+            _foreground = true;
+            emit(SONIC_BG_EVENT_ENTER, distance_um, timestamp_ms);
+        }
+        emit(SONIC_BG_EVENT_SAMPLE, distance_um, timestamp_ms);
+        return SONIC_BG_FOREGROUND;
+    }
+
+    if(_foreground) {
+        _foreground = false;
+        emit(SONIC_BG_EVENT_LEAVE, distance_um, timestamp_ms);
+    }
+
+    /* Only background readings keep adapting the baseline (slow drift, temperature...) */
+    learn(distance);
+    return SONIC_BG_BACKGROUND;
+}
+
+/* Allows the calling functions to check the model state */
+uint8_t SONIC_BACKGROUND::isLearned() {return _count >= _learn_samples;}
+uint8_t SONIC_BACKGROUND::isForeground() {return _foreground;}
+
+/* Gets the learned baseline distance and its standard deviation in mm */
+float SONIC_BACKGROUND::getMean() {return _mean;}
+float SONIC_BACKGROUND::getStdDev() {return (_count > 1) ? sqrtf(_m2 / (_count - 1)) : 0;}
+
+/* Private function to add a reading to the baseline (Welford, capped to the adapt window) */
+void SONIC_BACKGROUND::learn(float distance) {
+    /* 
+        Once the window is full the count stops growing, so every new reading keeps a 1/window weight
+        and the old spread decays at the same rate - an exponentially forgetting Welford update.
+    */
+    if(_count < _adapt_window) {
+        _count++;
+    } else {
+        _m2 -= _m2 / _count;
+    }
+
+    float delta = distance - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (distance - _mean);
+}
+
+/* Private function to hand an event to the callback */
+void SONIC_BACKGROUND::emit(uint8_t event, uint32_t distance_um, uint32_t timestamp_ms) {
+    if(_callback) {_callback(event, distance_um, timestamp_ms, _context);}
+}
@@ -0,0 +1,88 @@
+/*
+    Static scene learning / background subtraction for the Unit Sonic drivers.
+
+    For fixed installations (doorways, conveyor lanes) the empty scene sits at a stable distance.  This
+    learns that baseline incrementally (Welford mean/variance) and only reports readings that deviate from
+    it, so downstream logic only has to look at the interesting samples.
+*/
+#ifndef _UNIT_SONIC_BACKGROUND_H_
+    #define _UNIT_SONIC_BACKGROUND_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Sink.h"
+
+    #define SONIC_BG_LEARN_SAMPLES 50       //Readings used to learn the empty scene before reporting anything
+    #define SONIC_BG_THRESHOLD_SIGMA 3.0f   //A reading further than 3 standard deviations from the baseline is foreground
+    #define SONIC_BG_MIN_DEVIATION_MM 20    //...but never closer than 20mm (the sensor varies a few mm anyway)
+    #define SONIC_BG_ADAPT_WINDOW 500       //Background readings keep adapting the baseline with a ~500 sample memory
+
+    /* States returned by update() */
+    #define SONIC_BG_LEARNING 0             //Still learning the empty scene
+    #define SONIC_BG_BACKGROUND 1           //Reading matches the learned scene
+    #define SONIC_BG_FOREGROUND 2           //Reading deviates from the learned scene
+
+    /* Events handed to the callback */
+    #define SONIC_BG_EVENT_ENTER 0          //First foreground reading after background
+    #define SONIC_BG_EVENT_SAMPLE 1         //Every foreground reading (including the first one)
+    #define SONIC_BG_EVENT_LEAVE 2          //First background reading after foreground
+
+    class SONIC_BACKGROUND : public SONIC_SINK {
+        public:
+            /* Signature of the foreground event callback */
+            typedef void (*callback_t)(uint8_t event, uint32_t distance_um, uint32_t timestamp_ms, void *context);
+
+            /* Sets up the model parameters and restarts learning */
+            void begin(uint16_t learn_samples = SONIC_BG_LEARN_SAMPLES, float threshold_sigma = SONIC_BG_THRESHOLD_SIGMA,
+                       uint16_t min_deviation_mm = SONIC_BG_MIN_DEVIATION_MM, uint16_t adapt_window = SONIC_BG_ADAPT_WINDOW);
+
+            /* Registers the callback for foreground events */
+            void onEvent(callback_t callback, void *context = nullptr);
+
+            /* Throws away the learned scene and starts learning again */
+            void relearn();
+
+            /* Feeds a reading into the model and returns its state (SONIC_BG_LEARNING/BACKGROUND/FOREGROUND) */
+            uint8_t update(uint32_t distance_um, uint32_t timestamp_ms = 0);
+
+            /* Sink interface - lets the model be attached directly to a sensor */
+            void onReading(uint32_t distance_um, uint32_t timestamp_ms) override {update(distance_um, timestamp_ms);}
+
+            /* Allows the calling functions to check the model state */
+            uint8_t isLearned();
+            uint8_t isForeground();
+
+            /* Gets the learned baseline distance and its standard deviation in mm */
+            float getMean();
+            float getStdDev();
+
+            /* Gets the model parameters set by begin() */
+            uint16_t getLearnSamples() {return _learn_samples;}
+            float getThresholdSigma() {return _threshold_sigma;}
+            uint16_t getMinDeviation() {return _min_deviation;}
+            uint16_t getAdaptWindow() {return _adapt_window;}
+
+        private:
+            /* Private function to add a reading to the baseline (Welford, capped to the adapt window) */
+            void learn(float distance);
+
+            /* Private function to hand an event to the callback */
+            void emit(uint8_t event, uint32_t distance_um, uint32_t timestamp_ms);
+
+            /* Private variables for the model parameters */
+            uint16_t _learn_samples = SONIC_BG_LEARN_SAMPLES;
+            uint16_t _min_deviation = SONIC_BG_MIN_DEVIATION_MM;
+            uint16_t _adapt_window = SONIC_BG_ADAPT_WINDOW;
+            float _threshold_sigma = SONIC_BG_THRESHOLD_SIGMA;
+
+            /* Private variables for the Welford accumulator (mm) */
+            uint32_t _count = 0;
+            float _mean = 0;
+            float _m2 = 0;
+
+            /* Private variables for the event tracking */
+            callback_t _callback = nullptr;
+            void *_context = nullptr;
+            uint8_t _foreground = false;
+    };
+
+#endif
@@ -0,0 +1,246 @@
+#include "Unit_Sonic_Batch.h"
+
+/* Payload bits of the value classes after the 0 class (10, 110, 1110 and 1111 prefixes) for timestamps and distances */
+static const uint8_t sonic_batch_widths[2][4] = {{3, 8, 14, 32}, {6, 11, 17, 32}};
+
+/* Private function to get the value class of a zigzag value - 0 for a zero value, else 1..4 */
+static inline uint8_t sonic_batch_class(const uint8_t* widths, uint32_t value) {
+    if(!value) {return 0;}
+
+    uint8_t level = 1;
+    while((level < 4) && (value >> widths[level - 1])) {level++;}
+    return level;
+}
+
+/* Private function to get the encoded bits of a value class */
+static inline uint8_t sonic_batch_class_bits(const uint8_t* widths, uint8_t level) {
+    if(!level) {return 1;}
+    return ((level < 4) ? level + 1 : 4) + widths[level - 1];
+}
+
+/* Private function to get the id following the given one among the seen sensors (round robin) */
+static inline uint8_t sonic_batch_next(uint32_t seen, uint8_t sensor) {
+    uint32_t after = (sensor < 31) ? seen & ~((2UL << sensor) - 1) : 0;
+    if(!after) {after = seen;}
+
+    uint8_t next = 0;
+    while(!(after & 1)) {
+        after >>= 1;
+        next++;
+    }
+    return next;
+}
+
+/*
+    Private function to get the interval expected for a sensor: its own once it has been measured twice in this
+    batch, else the one of the previous reading's sensor (fleets measure round robin), 0 for its first reading
+*/
+static inline int32_t sonic_batch_expected(uint32_t seen, uint32_t learned, uint8_t sensor, uint8_t previous, const int32_t* interval) {
+    if((learned >> sensor) & 1) {return interval[sensor];}
+    if(((seen >> sensor) & 1) && ((learned >> previous) & 1)) {return interval[previous];}
+    return 0;
+}
+
+/* Private structure to read the bit stream of a batch */
+struct sonic_batch_reader {
+    const uint8_t* data;
+    uint32_t position;
+    uint32_t bits;
+
+    /* Reads count (<= 32) bits - returns false if the stream ends first */
+    uint8_t get(uint8_t count, uint32_t* value) {
+        if(bits - position < count) {return false;}
+
+        uint32_t result = 0;
+        while(count) {
+            uint8_t used = position & 7;
+            uint8_t take = 8 - used;
+            if(take > count) {take = count;}
+
+            uint8_t chunk = (uint8_t)(data[position >> 3] << used) >> (8 - take);
+            result = (result << take) | chunk;
+            position += take;
+            count -= take;
+        }
+        *value = result;
+        return true;
+    }
+
+    /* Reads a zigzag value written as class prefix + payload */
+    uint8_t get_value(const uint8_t* widths, uint32_t* value) {
+        uint32_t bit;
+        uint8_t level = 0;
+
+        while(level < 4) {
+            if(!get(1, &bit)) {return false;}
+            if(!bit) {break;}
+            level++;
+        }
+
+        if(!level) {
+            *value = 0;
+            return true;
+        }
+        return get(widths[level - 1], value);
+    }
+
+    /* Checks whether only the 1 bit padding of the last byte is left */
+    uint8_t at_end() const {
+        uint32_t left = bits - position;
+        if(left >= 8) {return false;}
+        if(!left) {return true;}
+
+        uint8_t mask = (uint8_t)((1U << left) - 1);
+        return (data[(bits >> 3) - 1] & mask) == mask;
+    }
+};
+
+/* Starts an empty batch in the given buffer */
+void SONIC_BATCH::start(uint8_t* buffer, uint16_t capacity) {
+    _buffer = buffer;
+    _capacity = capacity;
+    _bits = 0;
+}
+
+/* Adds a reading - returns false if it doesn't fit anymore */
+uint8_t SONIC_BATCH::add(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms) {
+    if(sensor >= SONIC_BATCH_MAX_SENSORS) {return false;}
+
+    /* A new batch starts from the base timestamp, with no sensor seen yet */
+    uint8_t header = 0;
+    uint8_t base[SONIC_VARINT_MAX];
+    if(!_bits) {
+        header = SONIC_CODEC::putVarint(base, timestamp_ms);
+        _seen = 0;
+        _learned = 0;
+        _previous_timestamp = timestamp_ms;
+        _previous_distance = 0;
+    }
+
+    /* Deltas to the sensor's own series, or to the previous reading for its first one */
+    uint8_t known = (_seen >> sensor) & 1;
+    uint8_t implicit = _seen && (sonic_batch_next(_seen, _previous_sensor) == sensor);
+    int32_t interval = (int32_t)(timestamp_ms - (known ? _sensor_timestamp[sensor] : _previous_timestamp));
+    int32_t expected = sonic_batch_expected(_seen, _learned, sensor, _previous_sensor, _sensor_interval);
+    uint32_t timestamp_value = SONIC_CODEC::zigzag((int32_t)((uint32_t)interval - (uint32_t)expected));
+    uint32_t distance_value = SONIC_CODEC::zigzag((int32_t)(distance_um - (known ? _sensor_distance[sensor] : _previous_distance)));
+
+    uint8_t timestamp_class = sonic_batch_class(sonic_batch_widths[0], timestamp_value);
+    uint8_t distance_class = sonic_batch_class(sonic_batch_widths[1], distance_value);
+    uint32_t needed = (implicit ? 1 : 6) + sonic_batch_class_bits(sonic_batch_widths[0], timestamp_class) +
+                      sonic_batch_class_bits(sonic_batch_widths[1], distance_class);
+
+    if(_bits + header * 8 + needed > (uint32_t)_capacity * 8) {return false;}
+
+    if(header) {
+        for(uint8_t i = 0; i < header; i++) {_buffer[i] = base[i];}
+        _bits = header * 8;
+        _started = timestamp_ms;
+    }
+
+    if(implicit) {
+        put_bits(0, 1);
+    } else {
+        put_bits(0x20 | sensor, 6);
+    }
+
+    uint8_t classes[2] = {timestamp_class, distance_class};
+    uint32_t values[2] = {timestamp_value, distance_value};
+    for(uint8_t i = 0; i < 2; i++) {
+        if(!classes[i]) {
+            put_bits(0, 1);
+            continue;
+        }
+        put_bits((classes[i] < 4) ? (2UL << classes[i]) - 2 : 0xF, (classes[i] < 4) ? classes[i] + 1 : 4);
+        put_bits(values[i], sonic_batch_widths[i][classes[i] - 1]);
+    }
+
+    _sensor_timestamp[sensor] = timestamp_ms;
+    if(known) {
+        _sensor_interval[sensor] = interval;
+        _learned |= 1UL << sensor;
+    }
+    _sensor_distance[sensor] = distance_um;
+    _previous_sensor = sensor;
+    _previous_timestamp = timestamp_ms;
+    _previous_distance = distance_um;
+    _seen |= 1UL << sensor;
+
+    return true;
+}
+
+/* Decodes a batch - returns false if it is malformed */
+uint8_t SONIC_BATCH::decode(const uint8_t* data, uint16_t length, CALLBACK callback, void* context) {
+    uint32_t sensor_timestamp[SONIC_BATCH_MAX_SENSORS];
+    int32_t sensor_interval[SONIC_BATCH_MAX_SENSORS];
+    uint32_t sensor_distance[SONIC_BATCH_MAX_SENSORS];
+
+    /* First pass validates the whole batch, the second one hands out the readings */
+    for(uint8_t emit = 0; emit < 2; emit++) {
+        uint32_t timestamp;
+        uint8_t used = SONIC_CODEC::getVarint(data, data + length, &timestamp);
+        if(!used) {return false;}
+
+        sonic_batch_reader in = {data, (uint32_t)used * 8, (uint32_t)length * 8};
+        uint32_t distance = 0;
+        uint32_t seen = 0;
+        uint32_t learned = 0;
+        uint8_t sensor = 0;
+
+        while(!in.at_end()) {
+            uint32_t value;
+
+            uint8_t previous = sensor;
+
+            if(!in.get(1, &value)) {return false;}
+            if(value) {
+                if(!in.get(5, &value)) {return false;}
+                sensor = (uint8_t)value;
+            } else {
+                if(!seen) {return false;}
+                sensor = sonic_batch_next(seen, sensor);
+            }
+
+            uint8_t known = (seen >> sensor) & 1;
+            uint32_t timestamp_value, distance_value;
+            if(!in.get_value(sonic_batch_widths[0], &timestamp_value) || !in.get_value(sonic_batch_widths[1], &distance_value)) {return false;}
+
+            int32_t expected = sonic_batch_expected(seen, learned, sensor, previous, sensor_interval);
+            int32_t interval = (int32_t)((uint32_t)expected + (uint32_t)SONIC_CODEC::unzigzag(timestamp_value));
+            timestamp = (known ? sensor_timestamp[sensor] : timestamp) + (uint32_t)interval;
+            distance = (known ? sensor_distance[sensor] : distance) + (uint32_t)SONIC_CODEC::unzigzag(distance_value);
+
+            sensor_timestamp[sensor] = timestamp;
+            if(known) {
+                sensor_interval[sensor] = interval;
+                learned |= 1UL << sensor;
+            }
+            sensor_distance[sensor] = distance;
+            seen |= 1UL << sensor;
+
+            if(emit && callback) {callback(sensor, distance, timestamp, context);}
+        }
+    }
+
+    return true;
+}
+
+/* Private function to append bits (most significant first), padding the last byte with 1 bits */
+void SONIC_BATCH::put_bits(uint32_t value, uint8_t count) {
+    while(count) {
+        uint8_t used = _bits & 7;
+        uint8_t take = 8 - used;
+        if(take > count) {take = count;}
+
+        uint8_t* out = &_buffer[_bits >> 3];
+        if(!used) {*out = 0xFF;}
+
+        uint8_t shift = 8 - used - take;
+        uint8_t mask = (uint8_t)(((1U << take) - 1) << shift);
+        uint8_t chunk = (uint8_t)(value >> (count - take));
+        *out = (uint8_t)((*out & ~mask) | ((chunk << shift) & mask));
+
+        _bits += take;
+        count -= take;
+    }
+}
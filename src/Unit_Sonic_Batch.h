@@ -0,0 +1,70 @@
+/*
+    Compressed batches of readings, shared by the telemetry stream and the flash log.
+
+    Every sensor is treated as its own time series (Gorilla style): its timestamps are stored as the
+    delta-of-delta to its previous two readings and its distances as the zigzag delta to its previous reading,
+    so a sensor measuring at a steady rate in front of a still scene costs 3 bits per reading.  Until a sensor
+    has an interval of its own in the batch, the one of the previous reading's sensor is assumed (fleets are
+    measured round robin).
+
+    Layout - a batch decodes on its own:
+        varint base timestamp (ms), then a bit stream (most significant bit first) with per reading:
+        sensor    0 = next sensor id seen in this batch (round robin) | 1 + 5 bit id
+        timestamp zigzag delta-of-delta, see below (a sensor's first reading is relative to the previous reading)
+        distance  zigzag delta, see below (a sensor's first reading is relative to the previous reading, or 0)
+
+        Values:   0 --> 0 | else a class prefix 10, 110, 1110 or 1111 followed by the value in as many bits as the
+                  class holds: 3, 8, 14 or 32 bits for timestamps (jitter is a few ms) and 6, 11, 17 or 32 bits
+                  for distances (noise is a few 100um)
+
+    The last byte is padded with 1 bits, which can never form a whole reading.
+*/
+#ifndef _UNIT_SONIC_BATCH_H_
+    #define _UNIT_SONIC_BATCH_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Codec.h"
+
+    #define SONIC_BATCH_MAX_SENSORS 32                  //Sensor ids 0..31
+    #define SONIC_BATCH_RECORD_MAX 10                   //Max bytes of one reading (6 + 36 + 36 bits)
+
+    class SONIC_BATCH {
+        public:
+            typedef void (*CALLBACK)(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms, void* context);
+
+            /* Starts an empty batch in the given buffer */
+            void start(uint8_t* buffer, uint16_t capacity);
+
+            /* Adds a reading - returns false if it doesn't fit anymore (or the sensor id is invalid) */
+            uint8_t add(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms);
+
+            /* Gets the encoded size, whether it is empty and the timestamp of its first reading */
+            uint16_t getLength() const {return (uint16_t)((_bits + 7) >> 3);}
+            uint8_t empty() const {return _bits == 0;}
+            uint32_t getStarted() const {return _started;}
+
+            /* Decodes a batch - returns false (without calling the callback at all) if it is malformed */
+            static uint8_t decode(const uint8_t* data, uint16_t length, CALLBACK callback, void* context);
+
+        private:
+            /* Private function to append bits (most significant first), padding the last byte with 1 bits */
+            void put_bits(uint32_t value, uint8_t count);
+
+            /* Private variables for the output buffer */
+            uint8_t* _buffer = nullptr;
+            uint16_t _capacity = 0;
+            uint32_t _bits = 0;
+
+            /* Private variables for the delta state */
+            uint32_t _started = 0;
+            uint32_t _seen = 0;
+            uint32_t _learned = 0;
+            uint8_t _previous_sensor = 0;
+            uint32_t _previous_timestamp = 0;
+            uint32_t _previous_distance = 0;
+            uint32_t _sensor_timestamp[SONIC_BATCH_MAX_SENSORS];
+            int32_t _sensor_interval[SONIC_BATCH_MAX_SENSORS];
+            uint32_t _sensor_distance[SONIC_BATCH_MAX_SENSORS];
+    };
+
+#endif
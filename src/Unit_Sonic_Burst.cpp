@@ -0,0 +1,113 @@
+#include "Unit_Sonic_Burst.h"
+#include "Unit_Sonic_Lock.h"
+#include <math.h>
+
+/* Private variables for the buffers shared by all sensors */
+static SONIC_BURST sonic_burst_pool[SONIC_BURST_POOL];
+static SONIC_LOCK sonic_burst_lock;
+
+/* Private function to sort a (small) array in place */
+static void sonic_burst_sort(uint32_t *values, uint8_t count) {
+    for(uint8_t i = 1; i < count; i++) {
+        uint32_t value = values[i];
+        uint8_t j = i;
+        for(; (j > 0) && (values[j - 1] > value); j--) {values[j] = values[j - 1];}
+        values[j] = value;
+    }
+}
+
+/* Private function to get the median of a sorted array */
+static uint32_t sonic_burst_median(const uint32_t *sorted, uint8_t count) {
+    if(count & 1) {return sorted[count / 2];}
+    return (uint32_t)(((uint64_t)sorted[count / 2 - 1] + sorted[count / 2]) / 2);
+}
+
+/* Takes a buffer from the shared pool - returns nullptr if all of them are in use */
+SONIC_BURST *SONIC_BURST::acquire() {
+    SONIC_BURST *burst = nullptr;
+
+    sonic_burst_lock.lock();
+    for(uint8_t i = 0; i < SONIC_BURST_POOL; i++) {
+        if(!sonic_burst_pool[i]._used) {
+            burst = &sonic_burst_pool[i];
+            burst->_used = true;
+            burst->_active = false;
+            break;
+        }
+    }
+    sonic_burst_lock.unlock();
+
+    return burst;
+}
+
+/* Hands a buffer back to the shared pool */
+void SONIC_BURST::release(SONIC_BURST *burst) {
+    if(!burst) {return;}
+
+    sonic_burst_lock.lock();
+    burst->_active = false;
+    burst->_used = false;
+    sonic_burst_lock.unlock();
+}
+
+/* Starts collecting a new burst of 1 to SONIC_BURST_MAX readings */
+void SONIC_BURST::start(uint8_t samples) {
+    if(samples < 1) {samples = 1;}
+    if(samples > SONIC_BURST_MAX) {samples = SONIC_BURST_MAX;}
+
+    _target = samples;
+    _count = 0;
+    _active = true;
+}
+
+/* Adds a reading to the burst - returns true once the burst is complete */
+uint8_t SONIC_BURST::add(uint32_t distance_um) {
+    if(!_active) {return false;}
+
+    _samples[_count++] = distance_um;
+
+    if(_count < _target) {return false;}
+
+    _active = false;
+    return true;
+}
+
+/* Rejects the outliers and reduces the completed burst into the result */
+void SONIC_BURST::compute(SONIC_BURST_RESULT *result) {
+    uint32_t deviations[SONIC_BURST_MAX];
+
+    sonic_burst_sort(_samples, _count);
+    uint32_t median = sonic_burst_median(_samples, _count);
+
+    /* Median absolute deviation --> robust estimate of the spread that the outliers can't inflate */
+    for(uint8_t i = 0; i < _count; i++) {
+        deviations[i] = (_samples[i] > median) ? (_samples[i] - median) : (median - _samples[i]);
+    }
+    sonic_burst_sort(deviations, _count);
+
+    uint32_t limit = (uint32_t)(((uint64_t)sonic_burst_median(deviations, _count) * SONIC_BURST_REJECT_MAD_X1000) / 1000);
+    if(limit < SONIC_BURST_MIN_SPREAD_UM) {limit = SONIC_BURST_MIN_SPREAD_UM;}
+
+    /* The samples are sorted, so the ones we keep are a contiguous range around the median */
+    uint8_t first = 0;
+    uint8_t last = _count;
+    while((first < last) && (_samples[first] < median) && (median - _samples[first] > limit)) {first++;}
+    while((last > first) && (_samples[last - 1] > median) && (_samples[last - 1] - median > limit)) {last--;}
+
+    uint8_t kept = last - first;
+    uint64_t sum = 0;
+    for(uint8_t i = first; i < last; i++) {sum += _samples[i];}
+    uint32_t mean = (uint32_t)(sum / kept);
+
+    uint64_t squares = 0;
+    for(uint8_t i = first; i < last; i++) {
+        int64_t delta = (int64_t)_samples[i] - mean;
+        squares += (uint64_t)(delta * delta);
+    }
+
+    result->mean = mean;
+    result->median = sonic_burst_median(&_samples[first], kept);
+    result->stddev = (kept > 1) ? (uint32_t)sqrt((double)squares / (kept - 1)) : 0;
+    result->samples = _count;
+    result->rejected = _count - kept;
+}
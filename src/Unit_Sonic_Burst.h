@@ -0,0 +1,60 @@
+/*
+    Oversampling burst support for the Unit Sonic drivers.
+
+    Collects K back-to-back readings, rejects the outliers (median absolute deviation) and reduces
+    the rest to a single mean/median/stddev result.  The samples are kept in fixed buffers shared by all
+    sensors (SONIC_BURST_POOL of them), so a burst never allocates and a sensor only pays for a pointer
+    while it isn't bursting.
+*/
+#ifndef _UNIT_SONIC_BURST_H_
+    #define _UNIT_SONIC_BURST_H_
+
+    #include <stdint.h>
+
+    #define SONIC_BURST_MAX 16                  //Largest number of readings a single burst can take
+    #define SONIC_BURST_REJECT_MAD_X1000 4448   //Reject readings further than 3 sigma (3 * 1.4826 * MAD) from the median
+    #define SONIC_BURST_MIN_SPREAD_UM 5000      //...but never reject readings within 5mm of the median
+
+    #ifndef SONIC_BURST_POOL
+        #define SONIC_BURST_POOL 2              //Bursts that can run at the same time across all sensors
+    #endif
+
+    /* Result of a completed burst (all distances in um) */
+    struct SONIC_BURST_RESULT {
+        uint32_t mean;
+        uint32_t median;
+        uint32_t stddev;
+        uint8_t samples;    //Number of readings taken
+        uint8_t rejected;   //Number of readings rejected as outliers
+    };
+
+    class SONIC_BURST {
+        public:
+            /* Takes a buffer from the shared pool - returns nullptr if all of them are in use */
+            static SONIC_BURST *acquire();
+
+            /* Hands a buffer back to the shared pool */
+            static void release(SONIC_BURST *burst);
+
+            /* Starts collecting a new burst of 1 to SONIC_BURST_MAX readings */
+            void start(uint8_t samples);
+
+            /* Allows the calling functions to check whether a burst is being collected */
+            uint8_t isActive() {return _active;}
+
+            /* Adds a reading to the burst - returns true once the burst is complete */
+            uint8_t add(uint32_t distance_um);
+
+            /* Rejects the outliers and reduces the completed burst into the result */
+            void compute(SONIC_BURST_RESULT *result);
+
+        private:
+            /* Private variables for the collected samples */
+            uint32_t _samples[SONIC_BURST_MAX];
+            uint8_t _target = 0;
+            uint8_t _count = 0;
+            uint8_t _active = false;
+            uint8_t _used = false;
+    };
+
+#endif
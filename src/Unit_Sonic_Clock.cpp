@@ -0,0 +1,57 @@
+#include "Unit_Sonic_Clock.h"
+#include "Unit_Sonic_Config.h"
+
+#if defined(ESP_PLATFORM)
+
+#include "esp_timer.h"
+
+/* The esp_timer counts us since boot in 64 bits already */
+uint64_t SONIC_CLOCK::micros64() {
+    return (uint64_t)esp_timer_get_time();
+}
+
+uint64_t SONIC_CLOCK::nanos64() {
+    return (uint64_t)esp_timer_get_time() * 1000ULL;
+}
+
+#elif defined(SONIC_PLATFORM_ARDUINO)
+
+#include <Arduino.h>
+#include "Unit_Sonic_Lock.h"
+
+/* Private variables for extending micros() - the last value seen and the number of wraps since boot */
+static uint32_t sonic_clock_last = 0;
+static uint32_t sonic_clock_wraps = 0;
+static SONIC_LOCK sonic_clock_lock;
+
+/* Counts a wrap whenever micros() went backwards since the previous call */
+uint64_t SONIC_CLOCK::micros64() {
+    sonic_clock_lock.lock();
+    uint32_t now = micros();
+    if(now < sonic_clock_last) {sonic_clock_wraps++;}
+    sonic_clock_last = now;
+    uint64_t result = ((uint64_t)sonic_clock_wraps << 32) | now;
+    sonic_clock_lock.unlock();
+
+    return result;
+}
+
+uint64_t SONIC_CLOCK::nanos64() {
+    return micros64() * 1000ULL;
+}
+
+#else
+
+#include <time.h>
+
+uint64_t SONIC_CLOCK::nanos64() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+uint64_t SONIC_CLOCK::micros64() {
+    return nanos64() / 1000;
+}
+
+#endif
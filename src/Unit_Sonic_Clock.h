@@ -0,0 +1,28 @@
+/*
+    64 bit monotonic time base of the Unit Sonic adapters.
+
+    The Arduino millis()/micros() wrap every ~49.7 days / ~71.6 minutes.  Differences of 32 bit timestamps survive
+    one wrap, but a timestamp kept across a long idle period aliases (e.g. an interval hold that reappears after
+    49.7 days without a poll), so the adapters hand the cores this clock instead.  It uses esp_timer on ESP32
+    (Arduino and ESP-IDF), CLOCK_MONOTONIC on Linux and extends the 32 bit micros() on any other Arduino - that
+    needs a call at least once per micros() wrap, which polling any sensor does.
+
+    The echo edge ISRs keep timestamping with the 32 bit micros(): a pulse is far shorter than a wrap, its width is
+    the unsigned difference (exact across a wrap) and a single word store can't be torn on a 32 bit MCU.
+*/
+#ifndef _UNIT_SONIC_CLOCK_H_
+    #define _UNIT_SONIC_CLOCK_H_
+
+    #include <stdint.h>
+
+    class SONIC_CLOCK {
+        public:
+            /* Gets the time since boot - never wraps (not ISR safe on the extended micros() path) */
+            static uint64_t micros64();
+            static uint64_t millis64() {return micros64() / 1000;}
+
+            /* Gets the time since boot in ns - on Linux the CLOCK_MONOTONIC the gpio edge events are timestamped on, elsewhere us resolution */
+            static uint64_t nanos64();
+    };
+
+#endif
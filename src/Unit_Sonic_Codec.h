@@ -0,0 +1,74 @@
+/*
+    Small integer codecs shared by the Unit Sonic telemetry and logging formats.
+
+    LEB128 style varints (7 bits per byte, least significant first), zigzag mapping so small negative
+    deltas stay small, and the CRC-16/CCITT-FALSE used to protect the frames.
+*/
+#ifndef _UNIT_SONIC_CODEC_H_
+    #define _UNIT_SONIC_CODEC_H_
+
+    #include <stdint.h>
+
+    #define SONIC_VARINT_MAX 5      //Max bytes of an encoded 32 bit varint
+
+    class SONIC_CODEC {
+        public:
+            /* Maps a signed delta onto an unsigned value (0, -1, 1, -2... --> 0, 1, 2, 3...) */
+            static uint32_t zigzag(int32_t value) {return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);}
+            static int32_t unzigzag(uint32_t value) {return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);}
+
+            /* Writes a varint - returns the number of bytes written (the caller keeps SONIC_VARINT_MAX bytes free) */
+            static uint8_t putVarint(uint8_t* out, uint32_t value) {
+                uint8_t length = 0;
+                while(value >= 0x80) {
+                    out[length++] = (uint8_t)value | 0x80;
+                    value >>= 7;
+                }
+                out[length++] = (uint8_t)value;
+                return length;
+            }
+
+            /* Reads a varint from [in, end) - returns the number of bytes used, 0 if it is truncated or too long */
+            static uint8_t getVarint(const uint8_t* in, const uint8_t* end, uint32_t* value) {
+                uint32_t result = 0;
+                for(uint8_t length = 0; (length < SONIC_VARINT_MAX) && (in + length < end); length++) {
+                    result |= (uint32_t)(in[length] & 0x7F) << (7 * length);
+                    if(!(in[length] & 0x80)) {
+                        *value = result;
+                        return length + 1;
+                    }
+                }
+                return 0;
+            }
+
+            /* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) - pass the previous result to continue a CRC */
+            static uint16_t crc16(const uint8_t* data, uint32_t length, uint16_t crc = 0xFFFF) {
+                while(length--) {
+                    crc ^= (uint16_t)(*data++) << 8;
+                    for(uint8_t bit = 0; bit < 8; bit++) {crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);}
+                }
+                return crc;
+            }
+
+            /* 
+                The same CRC a byte at a time through a 512 byte table (built on first use) - for hosts that check whole
+                log images, where the bit wise loop is most of the scan time
+            */
+            static uint16_t crc16Table(const uint8_t* data, uint32_t length, uint16_t crc = 0xFFFF) {
+                static const struct table {
+                    uint16_t entry[256];
+
+                    table() {
+                        for(uint16_t byte = 0; byte < 256; byte++) {
+                            uint8_t value = (uint8_t)byte;
+                            entry[byte] = crc16(&value, 1, 0);
+                        }
+                    }
+                } lookup;
+
+                while(length--) {crc = (uint16_t)(crc << 8) ^ lookup.entry[(uint8_t)(crc >> 8) ^ *data++];}
+                return crc;
+            }
+    };
+
+#endif
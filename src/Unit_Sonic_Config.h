@@ -0,0 +1,44 @@
+/*
+    Protocol constants and conversions shared by every Unit Sonic driver.
+
+    Kept free of any framework includes so the non-Arduino backends (e.g. Linux) can use them.
+*/
+#ifndef _UNIT_SONIC_CONFIG_H_
+    #define _UNIT_SONIC_CONFIG_H_
+
+    #include <stdint.h>
+
+    /* Selects the platform adapter that gets built (Arduino, native ESP-IDF or Linux userspace) */
+    #if defined(ARDUINO)
+        #define SONIC_PLATFORM_ARDUINO 1
+    #elif defined(ESP_PLATFORM)
+        #define SONIC_PLATFORM_IDF 1
+    #elif defined(__linux__)
+        #define SONIC_PLATFORM_LINUX 1
+    #endif
+
+    #define SONIC_MAX_DISTANCE 4500     //4500mm is the farthest distance this chip can detect
+    #define SONIC_MIN_DISTANCE 20       //20mm is the smallest we expect to be able to read
+    #define SONIC_MAX_DISTANCE_UM ((uint32_t)SONIC_MAX_DISTANCE * 1000)    //The raw data is tracked in um
+    #define SONIC_I2C_DATA_TIME 120     //120ms needed to get data from the chip
+
+    #define SONIC_I2C_BANDS 3                   //Number of distance bands that keep their own conversion time
+    #define SONIC_I2C_BAND_NEAR_MM 1000         //Readings below 1000mm use the "near" conversion time
+    #define SONIC_I2C_BAND_MID_MM 2500          //Readings below 2500mm use the "mid" conversion time, everything else is "far"
+    #define SONIC_I2C_CAL_MIN_TIME 5            //Shortest trigger-to-read delay the calibration will probe (ms)
+    #define SONIC_I2C_CAL_STEP 5                //Calibration probe step size (ms)
+    #define SONIC_I2C_CAL_REPEATS 3             //Consecutive good probes required before a delay is accepted
+    #define SONIC_I2C_CAL_MARGIN 5              //Safety margin added on top of the shortest reliable delay (ms)
+    #define SONIC_I2C_CAL_TOLERANCE_UM 10000    //A probe must land within 10mm of the reference reading
+
+    #define SONIC_IO_TRIG_PULSE_US 10   //10us needed to start the pulse from the chip
+    #define SONIC_IO_TIMEOUT_MS 120 //((2 * SONIC_MAX_DISTANCE / 343) + 1)     //Sets a timeout for the total time needed to measure the maximum distance - accounting for out/return flight
+    #define SONIC_IO_BURST_GAP_MS ((2 * SONIC_MAX_DISTANCE / 343) + 1)          //During a burst, wait for echoes from the maximum distance to die out before pinging again
+
+    #define SONIC_SOUND_US_TO_UM(x) (x * 343)                                       //Sound travels 343um in 1us
+    #define U32_SONIC_PULSE_TO_UM(x) (uint32_t)(SONIC_SOUND_US_TO_UM(x)/2)          //Pulses include time-to-target + return flight --> only need half the pulse width, measured in micrometers
+    #define U32_SONIC_PULSE_NS_TO_UM(x) (uint32_t)(((uint64_t)(x) * 343) / 2000)  //Same as above for pulses measured in nanoseconds (kernel edge timestamps)
+    #define U16_SONIC_UM_TO_MM(x) (uint16_t)(x/1000)                                //Convert to truncated mm
+    #define F_SONIC_UM_TO_MM(x) float(x/1000.0)                                     //Convert to mm floating point
+
+#endif
@@ -0,0 +1,463 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Unit_Sonic_Console.h"
+
+/* Private types of the registered entries (used as masks when looking them up) */
+#define SONIC_CONSOLE_I2C 0x01
+#define SONIC_CONSOLE_IO 0x02
+#define SONIC_CONSOLE_BACKGROUND 0x04
+#define SONIC_CONSOLE_STATS 0x08
+#define SONIC_CONSOLE_HISTOGRAM 0x10
+#define SONIC_CONSOLE_SENSOR (SONIC_CONSOLE_I2C | SONIC_CONSOLE_IO)
+
+#define SONIC_CONSOLE_BAR 24    //Characters of the longest histogram bar
+
+/* Private table of the commands */
+const SONIC_CONSOLE::command SONIC_CONSOLE::_commands[] = {
+    {"help", &SONIC_CONSOLE::command_help},
+    {"list", &SONIC_CONSOLE::command_list},
+    {"range", &SONIC_CONSOLE::command_range},
+    {"interval", &SONIC_CONSOLE::command_interval},
+    {"conv", &SONIC_CONSOLE::command_conv},
+    {"speed", &SONIC_CONSOLE::command_speed},
+    {"bg", &SONIC_CONSOLE::command_bg},
+    {"counters", &SONIC_CONSOLE::command_counters},
+    {"stats", &SONIC_CONSOLE::command_stats},
+    {"hist", &SONIC_CONSOLE::command_hist},
+    {nullptr, nullptr},
+};
+
+/* Sets where the replies go and clears the line */
+void SONIC_CONSOLE::begin(output_t output, void *context) {
+    _output = output;
+    _output_context = context;
+    _queued = false;
+    _queue_head = 0;
+    _queue_length = 0;
+    _length = 0;
+    _overflow = false;
+}
+
+/* Registers a sensor or filter under a name */
+uint8_t SONIC_CONSOLE::add(const char *name, SONIC_I2C_CORE *sensor) {return add_entry(name, SONIC_CONSOLE_I2C, sensor);}
+uint8_t SONIC_CONSOLE::add(const char *name, SONIC_IO_CORE *sensor) {return add_entry(name, SONIC_CONSOLE_IO, sensor);}
+uint8_t SONIC_CONSOLE::add(const char *name, SONIC_BACKGROUND *filter) {return add_entry(name, SONIC_CONSOLE_BACKGROUND, filter);}
+uint8_t SONIC_CONSOLE::add(const char *name, SONIC_STATS *filter) {return add_entry(name, SONIC_CONSOLE_STATS, filter);}
+uint8_t SONIC_CONSOLE::add(const char *name, SONIC_HISTOGRAM *filter) {return add_entry(name, SONIC_CONSOLE_HISTOGRAM, filter);}
+
+/* Registers the callback that changes the I2C bus speed */
+void SONIC_CONSOLE::onSpeed(speed_t callback, void *context) {
+    _speed = callback;
+    _speed_context = context;
+}
+
+/* Feeds received bytes - every complete line is executed right away */
+void SONIC_CONSOLE::feed(const char *data, uint32_t length) {
+    while(length--) {
+        char c = *data++;
+
+        if((c == '\r') || (c == '\n')) {
+            /* An empty line (or the LF of a CR LF) does nothing */
+            if(_overflow) {print("error: line longer than %u characters\r\n", SONIC_CONSOLE_LINE - 1);}
+            else if(_length) {
+                _line[_length] = 0;
+                execute();
+            }
+            _length = 0;
+            _overflow = false;
+        } else if((c == '\b') || (c == 0x7F)) {
+            /* Terminals send backspace or DEL for the backspace key */
+            if(_length) {_length--;}
+        } else if(_length < SONIC_CONSOLE_LINE - 1) {
+            _line[_length++] = c;
+        } else {
+            _overflow = true;
+        }
+    }
+}
+
+/* Private function to add an entry to the table */
+uint8_t SONIC_CONSOLE::add_entry(const char *name, uint8_t type, void *object) {
+    if(!name || !object || (_count >= SONIC_CONSOLE_ENTRIES)) {return false;}
+
+    _entries[_count++] = {name, type, object};
+    return true;
+}
+
+/* Private function to find an entry by name and type mask - reports an error if there is none */
+SONIC_CONSOLE::entry *SONIC_CONSOLE::find(const char *name, uint8_t types) {
+    for(uint8_t i = 0; i < _count; i++) {
+        if((_entries[i].type & types) && !strcmp(_entries[i].name, name)) {return &_entries[i];}
+    }
+
+    print("error: no %s named '%s' (try list)\r\n", (types & SONIC_CONSOLE_SENSOR) ? "sensor" : "filter", name);
+    return nullptr;
+}
+
+/* Private function to split the line into words and run the command */
+void SONIC_CONSOLE::execute() {
+    char *args[SONIC_CONSOLE_ARGS];
+    uint8_t count = 0;
+
+    /* Split the line in place at spaces and tabs */
+    for(char *c = _line; *c; ) {
+        if((*c == ' ') || (*c == '\t')) {
+            *c++ = 0;
+            continue;
+        }
+        if(count == SONIC_CONSOLE_ARGS) {
+            print("error: more than %u words\r\n", SONIC_CONSOLE_ARGS);
+            return;
+        }
+        args[count++] = c;
+        while(*c && (*c != ' ') && (*c != '\t')) {c++;}
+    }
+    if(!count) {return;}
+
+    for(const command *entry = _commands; entry->name; entry++) {
+        if(!strcmp(args[0], entry->name)) {
+            (this->*entry->handler)(args, count);
+            return;
+        }
+    }
+    print("error: unknown command '%s' (try help)\r\n", args[0]);
+}
+
+/* help */
+void SONIC_CONSOLE::command_help(char **args, uint8_t count) {
+    (void)args;
+    (void)count;
+    print("range <sensor> [min_mm max_mm]       range gate\r\n");
+    print("interval <sensor> [ms]               min time between measurements\r\n");
+    print("conv <sensor> [band ms]              I2C conversion time per band\r\n");
+    print("speed <hz>                           I2C bus speed\r\n");
+    print("bg <filter> [relearn|learn|sigma|deviation|window <value>]\r\n");
+    print("counters [sensor] [reset]            sensor counters\r\n");
+    print("stats <filter> [reset]               statistics\r\n");
+    print("hist <filter> [reset]                histograms\r\n");
+    print("list                                 sensors and filters\r\n");
+}
+
+/* list */
+void SONIC_CONSOLE::command_list(char **args, uint8_t count) {
+    static const char *const types[] = {"I2C sensor", "IO sensor", "background", "stats", "histogram"};
+
+    (void)args;
+    (void)count;
+    for(uint8_t i = 0; i < _count; i++) {
+        uint8_t type = 0;
+        while(!(_entries[i].type & (1 << type))) {type++;}
+        print("%-12s %s\r\n", _entries[i].name, types[type]);
+    }
+}
+
+/* range <sensor> [min_mm max_mm] */
+void SONIC_CONSOLE::command_range(char **args, uint8_t count) {
+    if((count != 2) && (count != 4)) {
+        print("usage: range <sensor> [min_mm max_mm]\r\n");
+        return;
+    }
+
+    entry *sensor = find(args[1], SONIC_CONSOLE_SENSOR);
+    if(!sensor) {return;}
+
+    if(sensor->type == SONIC_CONSOLE_I2C) {sensor_range(sensor->name, (SONIC_I2C_CORE *)sensor->object, args, count);}
+    else {sensor_range(sensor->name, (SONIC_IO_CORE *)sensor->object, args, count);}
+}
+
+/* interval <sensor> [ms] */
+void SONIC_CONSOLE::command_interval(char **args, uint8_t count) {
+    if((count != 2) && (count != 3)) {
+        print("usage: interval <sensor> [ms]\r\n");
+        return;
+    }
+
+    entry *sensor = find(args[1], SONIC_CONSOLE_SENSOR);
+    if(!sensor) {return;}
+
+    if(sensor->type == SONIC_CONSOLE_I2C) {sensor_interval(sensor->name, (SONIC_I2C_CORE *)sensor->object, args, count);}
+    else {sensor_interval(sensor->name, (SONIC_IO_CORE *)sensor->object, args, count);}
+}
+
+/* conv <sensor> [band ms] */
+void SONIC_CONSOLE::command_conv(char **args, uint8_t count) {
+    uint32_t band, ms;
+
+    if((count != 2) && (count != 4)) {
+        print("usage: conv <sensor> [band ms]\r\n");
+        return;
+    }
+
+    entry *found = find(args[1], SONIC_CONSOLE_I2C);
+    if(!found) {return;}
+    SONIC_I2C_CORE *sensor = (SONIC_I2C_CORE *)found->object;
+
+    if(count == 4) {
+        if(!parse(args[2], SONIC_I2C_BANDS - 1, &band) || !parse(args[3], SONIC_I2C_DATA_TIME, &ms)) {return;}
+        sensor->setConversionTime((uint8_t)band, (uint8_t)ms);
+    }
+    print("%s conversion time: near %ums, mid %ums, far %ums\r\n", found->name, sensor->getConversionTime(0),
+          sensor->getConversionTime(1), sensor->getConversionTime(2));
+}
+
+/* speed <hz> */
+void SONIC_CONSOLE::command_speed(char **args, uint8_t count) {
+    uint32_t hz;
+
+    if(count != 2) {
+        print("usage: speed <hz>\r\n");
+        return;
+    }
+    if(!_speed) {
+        print("error: the bus speed can't be changed here\r\n");
+        return;
+    }
+    if(!parse(args[1], 1000000UL, &hz)) {return;}
+
+    if(_speed(hz, _speed_context)) {print("I2C bus speed: %luHz\r\n", (unsigned long)hz);}
+    else {print("error: the bus rejected %luHz\r\n", (unsigned long)hz);}
+}
+
+/* bg <filter> [relearn | learn|sigma|deviation|window <value>] */
+void SONIC_CONSOLE::command_bg(char **args, uint8_t count) {
+    if((count < 2) || (count > 4)) {
+        print("usage: bg <filter> [relearn | learn|sigma|deviation|window <value>]\r\n");
+        return;
+    }
+
+    entry *found = find(args[1], SONIC_CONSOLE_BACKGROUND);
+    if(!found) {return;}
+    SONIC_BACKGROUND *filter = (SONIC_BACKGROUND *)found->object;
+
+    uint16_t learn = filter->getLearnSamples();
+    float sigma = filter->getThresholdSigma();
+    uint16_t deviation = filter->getMinDeviation();
+    uint16_t window = filter->getAdaptWindow();
+
+    if((count == 3) && !strcmp(args[2], "relearn")) {
+        filter->relearn();
+    } else if(count == 4) {
+        uint32_t value;
+        char *end;
+
+        /* Any change restarts learning with the new parameters */
+        if(!strcmp(args[2], "sigma")) {
+            sigma = strtof(args[3], &end);
+            if(*end || (sigma <= 0)) {
+                print("error: '%s' is not a positive number\r\n", args[3]);
+                return;
+            }
+        } else if(!strcmp(args[2], "learn") || !strcmp(args[2], "deviation") || !strcmp(args[2], "window")) {
+            if(!parse(args[3], UINT16_MAX, &value)) {return;}
+            if(args[2][0] == 'l') {learn = (uint16_t)value;}
+            if(args[2][0] == 'd') {deviation = (uint16_t)value;}
+            if(args[2][0] == 'w') {window = (uint16_t)value;}
+        } else {
+            print("error: unknown parameter '%s'\r\n", args[2]);
+            return;
+        }
+        filter->begin(learn, sigma, deviation, window);
+    } else if(count != 2) {
+        print("usage: bg <filter> [relearn | learn|sigma|deviation|window <value>]\r\n");
+        return;
+    }
+
+    print("%s: learn %u, sigma %.2f, deviation %umm, window %u\r\n", found->name, learn, sigma, deviation, window);
+    if(filter->isLearned()) {
+        print("%s: baseline %.1fmm sd %.1fmm, %s\r\n", found->name, filter->getMean(), filter->getStdDev(),
+              filter->isForeground() ? "foreground" : "background");
+    } else {
+        print("%s: learning\r\n", found->name);
+    }
+}
+
+/* counters [sensor] [reset] */
+void SONIC_CONSOLE::command_counters(char **args, uint8_t count) {
+    uint8_t reset = (count > 1) && !strcmp(args[count - 1], "reset");
+    uint8_t named = count - reset - 1;
+
+    if(named > 1) {
+        print("usage: counters [sensor] [reset]\r\n");
+        return;
+    }
+
+    for(uint8_t i = 0; i < _count; i++) {
+        entry *sensor = &_entries[i];
+        if(!(sensor->type & SONIC_CONSOLE_SENSOR) || (named && strcmp(sensor->name, args[1]))) {continue;}
+
+        if(sensor->type == SONIC_CONSOLE_I2C) {sensor_counters(sensor->name, (SONIC_I2C_CORE *)sensor->object, reset);}
+        else {sensor_counters(sensor->name, (SONIC_IO_CORE *)sensor->object, reset);}
+        if(named) {return;}
+    }
+
+    if(named) {find(args[1], SONIC_CONSOLE_SENSOR);}
+}
+
+/* stats <filter> [reset] */
+void SONIC_CONSOLE::command_stats(char **args, uint8_t count) {
+    SONIC_STATS_SNAPSHOT snapshot;
+
+    if((count != 2) && ((count != 3) || strcmp(args[2], "reset"))) {
+        print("usage: stats <filter> [reset]\r\n");
+        return;
+    }
+
+    entry *found = find(args[1], SONIC_CONSOLE_STATS);
+    if(!found) {return;}
+
+    ((SONIC_STATS *)found->object)->snapshot(&snapshot, count == 3);
+    print("%s: %lu readings in %lums\r\n", found->name, (unsigned long)snapshot.count, (unsigned long)(snapshot.last_ms - snapshot.first_ms));
+    if(!snapshot.count) {return;}
+
+    print("%s: mean %.1fmm sd %.1fmm min %.1fmm max %.1fmm\r\n", found->name, snapshot.mean, snapshot.stddev, snapshot.min, snapshot.max);
+    print("%s: quantiles %.1fmm %.1fmm %.1fmm\r\n", found->name, snapshot.quantile[0], snapshot.quantile[1], snapshot.quantile[2]);
+}
+
+/* hist <filter> [reset] */
+void SONIC_CONSOLE::command_hist(char **args, uint8_t count) {
+    SONIC_HISTOGRAM_SNAPSHOT snapshot;
+
+    if((count != 2) && ((count != 3) || strcmp(args[2], "reset"))) {
+        print("usage: hist <filter> [reset]\r\n");
+        return;
+    }
+
+    entry *found = find(args[1], SONIC_CONSOLE_HISTOGRAM);
+    if(!found) {return;}
+
+    ((SONIC_HISTOGRAM *)found->object)->snapshot(&snapshot, count == 3);
+    print("%s distance:\r\n", found->name);
+    print_histogram(snapshot.distance, false, snapshot.bucket_mm);
+    print("%s interval:\r\n", found->name);
+    print_histogram(snapshot.interval, true, 0);
+}
+
+/* Private function to show/set the range gate of a sensor */
+template <typename CORE>
+void SONIC_CONSOLE::sensor_range(const char *name, CORE *sensor, char **args, uint8_t count) {
+    uint16_t min_mm, max_mm;
+
+    if(count == 4) {
+        uint32_t low, high;
+        if(!parse(args[2], SONIC_MAX_DISTANCE, &low) || !parse(args[3], SONIC_MAX_DISTANCE, &high)) {return;}
+        if(low > high) {
+            print("error: min is above max\r\n");
+            return;
+        }
+        sensor->setRange((uint16_t)low, (uint16_t)high);
+    }
+
+    sensor->getRange(&min_mm, &max_mm);
+    print("%s range: %u - %umm\r\n", name, min_mm, max_mm);
+}
+
+/* Private function to show/set the scheduling interval of a sensor */
+template <typename CORE>
+void SONIC_CONSOLE::sensor_interval(const char *name, CORE *sensor, char **args, uint8_t count) {
+    uint32_t ms;
+
+    if(count == 3) {
+        if(!parse(args[2], UINT16_MAX, &ms)) {return;}
+        sensor->setInterval((uint16_t)ms);
+    }
+    print("%s interval: %ums\r\n", name, sensor->getInterval());
+}
+
+/* Private function to dump (and clear) the counters of a sensor */
+template <typename CORE>
+void SONIC_CONSOLE::sensor_counters(const char *name, CORE *sensor, uint8_t reset) {
+    const SONIC_COUNTERS *counters = sensor->getCounters();
+
+    print("%s: triggers %lu, readings %lu, gated %lu, misses %lu\r\n", name, (unsigned long)counters->triggers,
+          (unsigned long)counters->readings, (unsigned long)counters->gated, (unsigned long)counters->misses);
+    if(reset) {sensor->resetCounters();}
+}
+
+/* Private function to print the non empty buckets of a histogram as bars */
+void SONIC_CONSOLE::print_histogram(const uint32_t *buckets, uint8_t intervals, uint16_t bucket_mm) {
+    char bar[SONIC_CONSOLE_BAR + 1];
+    char label[24];
+    uint32_t most = 0;
+
+    for(uint8_t i = 0; i < SONIC_HISTOGRAM_BUCKETS; i++) {
+        if(buckets[i] > most) {most = buckets[i];}
+    }
+    if(!most) {
+        print("  (empty)\r\n");
+        return;
+    }
+
+    for(uint8_t i = 0; i < SONIC_HISTOGRAM_BUCKETS; i++) {
+        if(!buckets[i]) {continue;}
+
+        uint8_t length = (uint8_t)(((uint64_t)buckets[i] * SONIC_CONSOLE_BAR + most - 1) / most);
+        memset(bar, '#', length);
+        bar[length] = 0;
+
+        /* Interval bucket i holds 2^(i-1) <= interval < 2^i, distance bucket i holds i * bucket_mm <= distance < (i + 1) * bucket_mm */
+        uint32_t low = intervals ? (i ? 1UL << (i - 1) : 0) : (uint32_t)i * bucket_mm;
+        uint32_t high = intervals ? (i ? (1UL << i) - 1 : 0) : (uint32_t)(i + 1) * bucket_mm - 1;
+        const char *unit = intervals ? "ms" : "mm";
+
+        if(i == SONIC_HISTOGRAM_BUCKETS - 1) {snprintf(label, sizeof(label), ">=%lu%s", (unsigned long)low, unit);}
+        else {snprintf(label, sizeof(label), "%lu-%lu%s", (unsigned long)low, (unsigned long)high, unit);}
+        print("  %-14s %10lu %s\r\n", label, (unsigned long)buckets[i], bar);
+    }
+}
+
+/* Private function to parse an unsigned number up to max - reports an error if it isn't one */
+uint8_t SONIC_CONSOLE::parse(const char *text, uint32_t max, uint32_t *value) {
+    char *end;
+    unsigned long number = strtoul(text, &end, 10);
+
+    if((*text < '0') || (*text > '9') || *end || (number > max)) {
+        print("error: '%s' is not a number from 0 to %lu\r\n", text, (unsigned long)max);
+        return false;
+    }
+
+    *value = (uint32_t)number;
+    return true;
+}
+
+/* Private function to format a reply line and hand it to the output (or queue it) */
+void SONIC_CONSOLE::print(const char *format, ...) {
+    char text[SONIC_CONSOLE_OUTPUT];
+    va_list args;
+
+    if(!_output && !_queued) {return;}
+
+    va_start(args, format);
+    int length = vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    if(_output) {
+        _output(text, _output_context);
+        return;
+    }
+
+    /* A truncated line keeps what fit, a line that doesn't fit the queue anymore is dropped whole */
+    if(length < 0) {return;}
+    if(length >= (int)sizeof(text)) {length = sizeof(text) - 1;}
+    if(_queue_length + length > SONIC_CONSOLE_QUEUE) {
+        _dropped++;
+        return;
+    }
+
+    for(int i = 0; i < length; i++) {_queue[(_queue_head + _queue_length++) % SONIC_CONSOLE_QUEUE] = text[i];}
+}
+
+/* Private function to get the oldest contiguous queued bytes - returns how many */
+uint16_t SONIC_CONSOLE::queued(const char **data) const {
+    *data = &_queue[_queue_head];
+    return (_queue_head + _queue_length <= SONIC_CONSOLE_QUEUE) ? _queue_length : (uint16_t)(SONIC_CONSOLE_QUEUE - _queue_head);
+}
+
+/* Private function to drop the queued bytes that were written */
+void SONIC_CONSOLE::dequeue(uint16_t length) {
+    if(length > _queue_length) {length = _queue_length;}
+
+    _queue_head = (uint16_t)((_queue_head + length) % SONIC_CONSOLE_QUEUE);
+    _queue_length -= length;
+}
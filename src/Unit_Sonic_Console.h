@@ -0,0 +1,187 @@
+/*
+    Line based command console for tuning the Unit Sonic drivers in the field.
+
+    Feed it whatever bytes arrive on a serial port (or socket, or stdin) and it parses complete lines: range
+    gates, scheduling intervals, I2C conversion times and bus speed, and the background model parameters can be
+    changed at run time, and the sensor counters, statistics and histograms dumped.  Sensors and filters are
+    registered under a short name that the commands refer to.  Replies go to an output callback, or with the
+    template begin()/service() into a queue that service() writes to an Arduino Stream only as far as
+    availableForWrite() has room, so a long dump never blocks the loop on a full TX buffer.
+
+    help                                    lists the commands
+    list                                    lists the registered sensors and filters
+    range <sensor> [min_mm max_mm]          shows/sets the range gate
+    interval <sensor> [ms]                  shows/sets the minimum time between measurements
+    conv <sensor> [band ms]                 shows/sets the I2C conversion time per distance band
+    speed <hz>                              sets the I2C bus speed (needs onSpeed())
+    bg <filter> [relearn | learn|sigma|deviation|window <value>]    shows/sets the background model
+    counters [sensor] [reset]               dumps (and clears) the sensor counters
+    stats <filter> [reset]                  dumps (and clears) the statistics
+    hist <filter> [reset]                   dumps (and clears) the histograms
+*/
+#ifndef _UNIT_SONIC_CONSOLE_H_
+    #define _UNIT_SONIC_CONSOLE_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Core.h"
+    #include "Unit_Sonic_Background.h"
+    #include "Unit_Sonic_Stats.h"
+    #include "Unit_Sonic_Histogram.h"
+
+    #ifndef SONIC_CONSOLE_LINE
+        #define SONIC_CONSOLE_LINE 64               //Longest command line (longer lines are rejected)
+    #endif
+    #ifndef SONIC_CONSOLE_ENTRIES
+        #define SONIC_CONSOLE_ENTRIES 8             //Sensors and filters that can be registered
+    #endif
+    #ifndef SONIC_CONSOLE_QUEUE
+        #define SONIC_CONSOLE_QUEUE 1024            //Reply bytes queued for a Stream (reply lines that don't fit are dropped)
+    #endif
+
+    #define SONIC_CONSOLE_ARGS 6                    //Words per command line (command included)
+    #define SONIC_CONSOLE_OUTPUT 96                 //Longest reply line
+    #define SONIC_CONSOLE_SERVICE_BYTES 32          //Bytes service() takes from the stream per call
+
+    class SONIC_CONSOLE {
+        public:
+            /* Signature of the output callback (one zero terminated piece of text per call) */
+            typedef void (*output_t)(const char *text, void *context);
+
+            /* Signature of the bus speed callback - returns false if the speed could not be set */
+            typedef uint8_t (*speed_t)(uint32_t hz, void *context);
+
+            /* Sets where the replies go (the callback must not block) and clears the line */
+            void begin(output_t output, void *context = nullptr);
+
+            /* Queues the replies for an Arduino Stream (anything with availableForWrite() and write(data, length)) - see service() */
+            template <typename STREAM>
+            void begin(STREAM *stream) {
+                (void)stream;
+                begin((output_t)nullptr);
+                _queued = true;
+            }
+
+            /* Registers a sensor or filter under a name (the name is not copied) - returns false if the table is full */
+            uint8_t add(const char *name, SONIC_I2C_CORE *sensor);
+            uint8_t add(const char *name, SONIC_IO_CORE *sensor);
+            uint8_t add(const char *name, SONIC_BACKGROUND *filter);
+            uint8_t add(const char *name, SONIC_STATS *filter);
+            uint8_t add(const char *name, SONIC_HISTOGRAM *filter);
+
+            /* Registers the callback that changes the I2C bus speed (e.g. calling SONIC_I2C::setSpeed()) */
+            void onSpeed(speed_t callback, void *context = nullptr);
+
+            /* Feeds received bytes - every complete line (CR and/or LF) is executed right away */
+            void feed(const char *data, uint32_t length);
+
+            /* 
+                Writes the queued replies as far as the Stream's TX buffer has room, then feeds what it has received (at most
+                SONIC_CONSOLE_SERVICE_BYTES per call, and only once the replies are out) - call it from the loop
+            */
+            template <typename STREAM>
+            void service(STREAM *stream) {
+                while(_queue_length) {
+                    const char *data;
+                    uint16_t length = queued(&data);
+                    int room = stream->availableForWrite();
+
+                    if(room <= 0) {return;}
+                    if(length > room) {length = (uint16_t)room;}
+
+                    length = (uint16_t)stream->write((const uint8_t *)data, length);
+                    if(!length) {return;}
+                    dequeue(length);
+                }
+
+                for(uint8_t i = 0; (i < SONIC_CONSOLE_SERVICE_BYTES) && (stream->available() > 0); i++) {
+                    char c = (char)stream->read();
+                    feed(&c, 1);
+                }
+            }
+
+            /* Gets the number of reply lines dropped because the queue was full */
+            uint32_t getDropped() const {return _dropped;}
+
+        private:
+            /* Private structure for one registered sensor or filter */
+            struct entry {
+                const char *name;
+                uint8_t type;
+                void *object;
+            };
+
+            /* Private structure for one entry of the command table */
+            struct command {
+                const char *name;
+                void (SONIC_CONSOLE::*handler)(char **args, uint8_t count);
+            };
+
+            /* Private table of the commands (ends with a null name) */
+            static const command _commands[];
+
+            /* Private function to add an entry to the table */
+            uint8_t add_entry(const char *name, uint8_t type, void *object);
+
+            /* Private function to find an entry by name and type mask - reports an error if there is none */
+            entry *find(const char *name, uint8_t types);
+
+            /* Private function to split the line into words and run the command */
+            void execute();
+
+            /* Private functions for the commands (args[0] is the command) */
+            void command_help(char **args, uint8_t count);
+            void command_list(char **args, uint8_t count);
+            void command_range(char **args, uint8_t count);
+            void command_interval(char **args, uint8_t count);
+            void command_conv(char **args, uint8_t count);
+            void command_speed(char **args, uint8_t count);
+            void command_bg(char **args, uint8_t count);
+            void command_counters(char **args, uint8_t count);
+            void command_stats(char **args, uint8_t count);
+            void command_hist(char **args, uint8_t count);
+
+            /* Private functions shared by both sensor types */
+            template <typename CORE>
+            void sensor_range(const char *name, CORE *sensor, char **args, uint8_t count);
+            template <typename CORE>
+            void sensor_interval(const char *name, CORE *sensor, char **args, uint8_t count);
+            template <typename CORE>
+            void sensor_counters(const char *name, CORE *sensor, uint8_t reset);
+
+            /* Private function to print one histogram as bars */
+            void print_histogram(const uint32_t *buckets, uint8_t intervals, uint16_t bucket_mm);
+
+            /* Private function to parse an unsigned number up to max - reports an error if it isn't one */
+            uint8_t parse(const char *text, uint32_t max, uint32_t *value);
+
+            /* Private function to format a reply line and hand it to the output (or queue it) */
+            void print(const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+            /* Private functions for the reply queue - the oldest contiguous bytes, and dropping the ones written */
+            uint16_t queued(const char **data) const;
+            void dequeue(uint16_t length);
+
+            /* Private variables for the output */
+            output_t _output = nullptr;
+            void *_output_context = nullptr;
+            speed_t _speed = nullptr;
+            void *_speed_context = nullptr;
+
+            /* Private variables for the reply queue (a ring) */
+            char _queue[SONIC_CONSOLE_QUEUE];
+            uint16_t _queue_head = 0;
+            uint16_t _queue_length = 0;
+            uint8_t _queued = false;
+            uint32_t _dropped = 0;
+
+            /* Private variables for the registered sensors and filters */
+            entry _entries[SONIC_CONSOLE_ENTRIES];
+            uint8_t _count = 0;
+
+            /* Private variables for the line being received */
+            char _line[SONIC_CONSOLE_LINE];
+            uint8_t _length = 0;
+            uint8_t _overflow = false;
+    };
+
+#endif
@@ -0,0 +1,391 @@
+#include "Unit_Sonic_Core.h"
+
+static_assert(sizeof(SONIC_I2C_CORE) <= SONIC_I2C_CORE_BYTES, "SONIC_I2C_CORE outgrew its RAM budget");
+static_assert(sizeof(SONIC_IO_CORE) <= SONIC_IO_CORE_BYTES, "SONIC_IO_CORE outgrew its RAM budget");
+
+/* 
+    Gets the raw distance in mm of the sensor.  This will always contain the latest reading.
+*/
+float SONIC_I2C_CORE::getDistance() {
+    /* Convert the distance to floating point and in mm (clamped to the max distance) */
+    return F_SONIC_UM_TO_MM(getDistance_um());
+}
+
+/* Gets the raw distance truncated to the nearest mm of the sensor */
+uint16_t SONIC_I2C_CORE::getDistance_uint16() {
+    return U16_SONIC_UM_TO_MM(getDistance_um());
+}
+
+/* Gets the distance in um as an integer (clamped to the max distance) */
+uint32_t SONIC_I2C_CORE::getDistance_um() {
+    return (_sensor_data < SONIC_MAX_DISTANCE_UM) ? _sensor_data : SONIC_MAX_DISTANCE_UM;
+}
+
+/* Gets the per-sensor linear correction applied to every new reading */
+SONIC_CORRECTION* SONIC_I2C_CORE::getCorrection() {return &_correction;}
+
+/* Attaches/detaches a sink that gets every new reading */
+void SONIC_I2C_CORE::attach(SONIC_SINK* sink) {_sinks.attach(sink);}
+void SONIC_I2C_CORE::detach(SONIC_SINK* sink) {_sinks.detach(sink);}
+
+/* Starts an oversampling burst of back-to-back readings */
+uint8_t SONIC_I2C_CORE::startBurst(uint8_t samples) {
+    if(!_burst) {_burst = SONIC_BURST::acquire();}
+    if(!_burst) {return false;}
+
+    _burst->start(samples);
+    return true;
+}
+
+/* Abandons the running burst and hands its buffer back to the pool */
+void SONIC_I2C_CORE::stopBurst() {
+    SONIC_BURST::release(_burst);
+    _burst = nullptr;
+}
+
+/* Allows the calling functions to check whether or not the sensor is busy */
+uint8_t SONIC_I2C_CORE::getStatus() {return _sensor_busy;}
+
+/* Gets/sets the trigger-to-read delay (ms) used for the given distance band */
+uint8_t SONIC_I2C_CORE::getConversionTime(uint8_t band) {
+    return (band < SONIC_I2C_BANDS) ? _sensor_data_time[band] : SONIC_I2C_DATA_TIME;
+}
+
+void SONIC_I2C_CORE::setConversionTime(uint8_t band, uint8_t ms) {
+    if(band < SONIC_I2C_BANDS) {_sensor_data_time[band] = (ms < SONIC_I2C_DATA_TIME) ? ms : SONIC_I2C_DATA_TIME;}
+}
+
+/* Gets/sets the range gate in mm */
+void SONIC_I2C_CORE::getRange(uint16_t* min_mm, uint16_t* max_mm) {
+    *min_mm = _range_min;
+    *max_mm = _range_max;
+}
+
+void SONIC_I2C_CORE::setRange(uint16_t min_mm, uint16_t max_mm) {
+    _range_min = min_mm;
+    _range_max = (max_mm < SONIC_MAX_DISTANCE) ? max_mm : SONIC_MAX_DISTANCE;
+}
+
+/* Gets/sets the minimum time between the start of two measurements */
+uint16_t SONIC_I2C_CORE::getInterval() {return _interval;}
+void SONIC_I2C_CORE::setInterval(uint16_t ms) {_interval = ms;}
+
+/* Gets/clears the instrumentation counters */
+const SONIC_COUNTERS* SONIC_I2C_CORE::getCounters() {return &_counters;}
+void SONIC_I2C_CORE::resetCounters() {_counters = {};}
+
+/* Clears any measurement in progress */
+void SONIC_I2C_CORE::reset() {
+    _sensor_busy = false;
+}
+
+/* Returns the action the adapter has to perform */
+uint8_t SONIC_I2C_CORE::poll(uint64_t now_ms) {
+    /* 
+        I'm not able to find a datasheet for this chip, so reverse engineering a bit from 
+        the original driver.  They send 0x01 to the chip, wait 120ms, then read 3 bytes back.
+        I would normally assume this is simply reading from 3 bytes starting at page 0x1,
+        but since they wait 120ms between the write and read, I'm guessing 0x01 triggers
+        the pulse, the chip performs the measurement, and then the chip makes the data available.
+
+        So, we'll simply treat this like an ADC that has a conversion time by keeping track of a 
+        "data ready" timer flag.  If the flag hasn't expired, we'll simply return the old measurement
+        data.  If the timer has expired, then we'll grab new data to return.  Easy peasy.
+   */
+    /* Hold off the next measurement for the interval (or the retry delay of a NAKed trigger) */
+    if(!_sensor_busy) {return holdoff(now_ms) ? SONIC_ACTION_NONE : SONIC_ACTION_TRIGGER;}
+
+    /* See if the new data is available */
+    if(timer_expired(now_ms, _sensor_trigger_time, _sensor_wait)) {return SONIC_ACTION_READ;}
+
+    return SONIC_ACTION_NONE;
+}
+
+/* Gets the time until the next measurement may start */
+uint32_t SONIC_I2C_CORE::holdoff(uint64_t now_ms) {
+    if(_sensor_busy) {return 0;}
+
+    /* The scheduling interval, or the retry delay of a NAKed trigger */
+    uint32_t hold = (_sensor_retry && (_interval < SONIC_I2C_DATA_TIME)) ? SONIC_I2C_DATA_TIME : _interval;
+    uint64_t elapsed = now_ms - _sensor_trigger_time;
+    return (elapsed < hold) ? (uint32_t)(hold - elapsed) : 0;
+}
+
+/* The adapter sent the trigger - starts the conversion timer */
+void SONIC_I2C_CORE::triggered(uint64_t now_ms) {
+    /* Pick the conversion time based on the band of the last reading */
+    _sensor_wait = _sensor_data_time[distance_band(_sensor_data)];
+
+    /* Start the timer and flag that the sensor is busy */
+    _sensor_busy = true;
+    _sensor_retry = false;
+    _sensor_trigger_time = now_ms;
+    _counters.triggers++;
+}
+
+/* The chip NAKed the trigger - retry once a full conversion time has passed */
+void SONIC_I2C_CORE::trigger_failed(uint64_t now_ms) {
+    _sensor_retry = true;
+    _sensor_trigger_time = now_ms;
+    _counters.misses++;
+}
+
+/* The adapter read the data - returns true if a new reading was collected */
+uint8_t SONIC_I2C_CORE::received(const uint8_t* data, uint8_t length, uint64_t now_ms) {
+    SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_CONVERT);
+    const uint8_t bytes_to_read = 3;
+    uint32_t reading;
+
+    if(length != bytes_to_read) {
+        _counters.misses++;
+
+        /* 
+            If a calibrated (shortened) conversion time was used and the chip NAKed, the target most likely
+            moved into a farther band --> fall back to the full conversion time for this measurement.
+        */
+        if(_sensor_wait < SONIC_I2C_DATA_TIME) {
+            _sensor_wait = SONIC_I2C_DATA_TIME;
+            return false;
+        }
+
+        /* Nothing came back at all --> the measurement is lost, there is no distance to report */
+        _sensor_busy = false;
+        return false;
+    }
+
+    /* Data is big endian, in um - apply the per-sensor correction */
+    reading = _correction.apply(((uint32_t)data[0] << 16) | ((uint32_t)data[1] << 8) | data[2]);
+
+    /* Flag that the sensor is no longer busy */
+    _sensor_busy = false;
+
+    /* Readings outside of the range gate are dropped */
+    if(!in_range(reading)) {
+        _counters.gated++;
+        return false;
+    }
+    _sensor_data = reading;
+    _counters.readings++;
+
+    /* Hand the new reading to the attached sinks */
+    _sinks.publish(_sensor_data, (uint32_t)now_ms);     //The sinks keep 32 bit timestamps, their deltas survive a wrap
+
+    return true;
+}
+
+/* Gets the conversion time the current measurement waits for */
+uint8_t SONIC_I2C_CORE::getWait() {return _sensor_wait;}
+
+/* Stores a calibrated conversion time for the band of the reference reading */
+void SONIC_I2C_CORE::calibrated(uint32_t reference, uint8_t data_time) {
+    uint8_t band = distance_band(reference);
+
+    /* Nearer bands can never need longer than this band */
+    setConversionTime(band, data_time);
+    for(uint8_t i = 0; i < band; i++) {
+        if(_sensor_data_time[i] > _sensor_data_time[band]) {_sensor_data_time[i] = _sensor_data_time[band];}
+    }
+
+    _sensor_data = reference;
+}
+
+/* Adds the latest reading to the running burst */
+uint8_t SONIC_I2C_CORE::collect_burst(SONIC_BURST_RESULT* result) {
+    if(!_burst || !_burst->add(_sensor_data)) {return false;}
+
+    /* Hand the buffer back to the pool as soon as the result is out */
+    _burst->compute(result);
+    stopBurst();
+    return true;
+}
+
+/* Private function to check if a timer has expired (only called while busy, so the timer is always running) */
+uint8_t SONIC_I2C_CORE::timer_expired(uint64_t now_ms, uint64_t timer, uint32_t timeout) {
+    return (now_ms - timer > timeout) ? true : false;
+}
+
+/* Private function to map a reading onto its conversion time band */
+uint8_t SONIC_I2C_CORE::distance_band(uint32_t data) {
+    uint32_t mm = data / 1000;
+
+    if(mm < SONIC_I2C_BAND_NEAR_MM) {return 0;}
+    if(mm < SONIC_I2C_BAND_MID_MM) {return 1;}
+    return 2;
+}
+
+/* Private function to check a reading against the range gate (clamped to the max distance like getDistance_um()) */
+uint8_t SONIC_I2C_CORE::in_range(uint32_t data) {
+    if(data > SONIC_MAX_DISTANCE_UM) {data = SONIC_MAX_DISTANCE_UM;}
+    return (data >= (uint32_t)_range_min * 1000) && (data <= (uint32_t)_range_max * 1000);
+}
+
+/* Gets the distance in mm / truncated mm / um */
+float SONIC_IO_CORE::getDistance() {return F_SONIC_UM_TO_MM(getDistance_um());}
+uint16_t SONIC_IO_CORE::getDistance_uint16() {return U16_SONIC_UM_TO_MM(getDistance_um());}
+uint32_t SONIC_IO_CORE::getDistance_um() {return (_sensor_data < SONIC_MAX_DISTANCE_UM) ? _sensor_data : SONIC_MAX_DISTANCE_UM;}
+
+/* Gets the per-sensor linear correction applied to every new reading */
+SONIC_CORRECTION* SONIC_IO_CORE::getCorrection() {return &_correction;}
+
+/* Attaches/detaches a sink that gets every new reading */
+void SONIC_IO_CORE::attach(SONIC_SINK* sink) {_sinks.attach(sink);}
+void SONIC_IO_CORE::detach(SONIC_SINK* sink) {_sinks.detach(sink);}
+
+/* Starts an oversampling burst of back-to-back readings */
+uint8_t SONIC_IO_CORE::startBurst(uint8_t samples) {
+    if(!_burst) {_burst = SONIC_BURST::acquire();}
+    if(!_burst) {return false;}
+
+    _burst->start(samples);
+    return true;
+}
+
+/* Abandons the running burst and hands its buffer back to the pool */
+void SONIC_IO_CORE::stopBurst() {
+    SONIC_BURST::release(_burst);
+    _burst = nullptr;
+}
+
+/* Allows the calling functions to check whether or not the sensor is busy */
+uint8_t SONIC_IO_CORE::getStatus() {return _sensor_busy;}
+
+/* Gets/sets the range gate in mm */
+void SONIC_IO_CORE::getRange(uint16_t* min_mm, uint16_t* max_mm) {
+    *min_mm = _range_min;
+    *max_mm = _range_max;
+}
+
+void SONIC_IO_CORE::setRange(uint16_t min_mm, uint16_t max_mm) {
+    _range_min = min_mm;
+    _range_max = (max_mm < SONIC_MAX_DISTANCE) ? max_mm : SONIC_MAX_DISTANCE;
+}
+
+/* Gets/sets the minimum time between the start of two measurements */
+uint16_t SONIC_IO_CORE::getInterval() {return _interval;}
+void SONIC_IO_CORE::setInterval(uint16_t ms) {_interval = ms;}
+
+/* Gets/clears the instrumentation counters */
+const SONIC_COUNTERS* SONIC_IO_CORE::getCounters() {return &_counters;}
+void SONIC_IO_CORE::resetCounters() {_counters = {};}
+
+/* Clears any measurement in progress */
+void SONIC_IO_CORE::reset() {
+    _sensor_pulse_duration = 0;
+    _sensor_busy = false;
+    _sensor_echo = SONIC_ECHO_WAIT;
+}
+
+/* Returns the action the adapter has to perform */
+uint8_t SONIC_IO_CORE::poll(uint64_t now_ms) {
+    /* 
+        I'm not able to find a datasheet for this chip, so reverse engineering a bit from 
+        the original driver.  They send a 10us pulse on the _trig_pin, then measure a pulse
+        of LOW-HIGH-LOW (duration of HIGH) in microseconds, to determine the amount of time
+        for sound to travel to the target and return.
+   */
+    /* Hold off the next ping for the interval (or the burst gap) */
+    if(!_sensor_busy) {return holdoff(now_ms) ? SONIC_ACTION_NONE : SONIC_ACTION_TRIGGER;}
+
+    /* See if there is new data available */
+    if(_sensor_echo == SONIC_ECHO_DONE) {
+        SONIC_TRACE_SCOPE(SONIC_TRACE_IO_CONVERT);
+        return data_collected(_correction.apply(U32_SONIC_PULSE_NS_TO_UM(_sensor_pulse_duration)), now_ms) ? SONIC_ACTION_READING : SONIC_ACTION_NONE;
+    }
+
+    /* See if a timeout has occured */
+    if(timer_expired(now_ms, _sensor_ping_time, SONIC_IO_TIMEOUT_MS)) {
+        _counters.misses++;
+        return data_collected(SONIC_MAX_DISTANCE_UM, now_ms) ? SONIC_ACTION_READING : SONIC_ACTION_NONE;
+    }
+
+    return SONIC_ACTION_NONE;
+}
+
+/* Gets the time until the next ping may start */
+uint32_t SONIC_IO_CORE::holdoff(uint64_t now_ms) {
+    if(_sensor_busy) {return 0;}
+
+    /* The scheduling interval - during a burst, also until echoes of the previous ping can no longer come back */
+    uint32_t hold = (_burst && _burst->isActive()) ? SONIC_IO_BURST_GAP_MS + 1 : 0;
+    if(_interval > hold) {hold = _interval;}
+
+    uint64_t elapsed = now_ms - _sensor_ping_time;
+    return (elapsed < hold) ? (uint32_t)(hold - elapsed) : 0;
+}
+
+/* The adapter sent the trigger pulse - starts the timeout timer */
+void SONIC_IO_CORE::triggered(uint64_t now_ms) {
+    _sensor_busy = true;
+    _sensor_echo = SONIC_ECHO_WAIT;
+    _sensor_ping_time = now_ms;
+    _counters.triggers++;
+}
+
+/* ISR safe edge handler - starts the pulse measurement */
+void SONIC_IO_CORE::echo_rising(uint32_t now_us) {
+    if(_sensor_echo == SONIC_ECHO_DONE) {return;}
+
+    _sensor_pulse_start = now_us;
+    _sensor_echo = SONIC_ECHO_HIGH;
+}
+
+/* ISR safe edge handler - calculates the pulse duration (kept in ns, saturated instead of wrapping) */
+void SONIC_IO_CORE::echo_falling(uint32_t now_us, uint32_t tick_ns) {
+    /* A falling edge without a rising edge (e.g. a missed interrupt) would measure from a stale start */
+    if(_sensor_echo != SONIC_ECHO_HIGH) {return;}
+
+    uint32_t width = now_us - _sensor_pulse_start;
+    _sensor_pulse_duration = (width < UINT32_MAX / tick_ns) ? width * tick_ns : UINT32_MAX;
+    _sensor_echo = SONIC_ECHO_DONE;
+}
+
+/* For adapters that measure the echo pulse width directly */
+void SONIC_IO_CORE::echo_pulse(uint32_t width_ns) {
+    _sensor_pulse_duration = width_ns;
+    _sensor_echo = SONIC_ECHO_DONE;
+}
+
+/* Forces the timeout path - the object is too far away to measure */
+uint8_t SONIC_IO_CORE::expire(uint64_t now_ms) {
+    _counters.misses++;
+    return data_collected(SONIC_MAX_DISTANCE_UM, now_ms);
+}
+
+/* Adds the latest reading to the running burst */
+uint8_t SONIC_IO_CORE::collect_burst(SONIC_BURST_RESULT* result) {
+    if(!_burst || !_burst->add(_sensor_data)) {return false;}
+
+    /* Hand the buffer back to the pool as soon as the result is out */
+    _burst->compute(result);
+    stopBurst();
+    return true;
+}
+
+/* Private function to check if a timer has expired (only called while busy, so the timer is always running) */
+uint8_t SONIC_IO_CORE::timer_expired(uint64_t now_ms, uint64_t timer, uint32_t timeout) {
+    return (now_ms - timer > timeout) ? true : false;
+}
+
+/* Private function to finish the measurement and publish the reading - returns false if it was gated */
+uint8_t SONIC_IO_CORE::data_collected(uint32_t data, uint64_t now_ms) {
+    _sensor_echo = SONIC_ECHO_WAIT;
+    _sensor_busy = false;
+
+    /* Readings outside of the range gate are dropped */
+    if(!in_range(data)) {
+        _counters.gated++;
+        return false;
+    }
+    _sensor_data = data;
+    _counters.readings++;
+
+    /* Hand the new reading to the attached sinks */
+    _sinks.publish(_sensor_data, (uint32_t)now_ms);
+    return true;
+}
+
+/* Private function to check a reading against the range gate (clamped to the max distance like getDistance_um()) */
+uint8_t SONIC_IO_CORE::in_range(uint32_t data) {
+    if(data > SONIC_MAX_DISTANCE_UM) {data = SONIC_MAX_DISTANCE_UM;}
+    return (data >= (uint32_t)_range_min * 1000) && (data <= (uint32_t)_range_max * 1000);
+}
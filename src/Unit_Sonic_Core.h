@@ -0,0 +1,286 @@
+/*
+    Platform independent core of the Unit Sonic drivers.
+
+    The state machines, conversions and filters for both sensors live here without any framework
+    includes.  The cores never touch a bus, a pin or a clock themselves - a thin platform adapter
+    (Arduino, ESP-IDF, Linux, simulator) derives from them, performs the action the core asks for and
+    passes the current time in (ms on a clock that doesn't wrap, e.g. SONIC_CLOCK).  The user facing getters are public, the adapter interface is protected.
+*/
+#ifndef _UNIT_SONIC_CORE_H_
+    #define _UNIT_SONIC_CORE_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Config.h"
+    #include "Unit_Sonic_Correction.h"
+    #include "Unit_Sonic_Sink.h"
+    #include "Unit_Sonic_Burst.h"
+
+    /* Actions the cores ask their adapter to perform */
+    #define SONIC_ACTION_NONE 0         //Nothing to do right now
+    #define SONIC_ACTION_TRIGGER 1      //Start a measurement, then call triggered()
+    #define SONIC_ACTION_READ 2         //(I2C) Read the 3 data bytes, then call received()
+    #define SONIC_ACTION_READING 3      //(IO) A new reading was collected
+
+    /* Echo pulse states of the IO core (written from the ISR) */
+    #define SONIC_ECHO_WAIT 0           //Waiting for the rising edge
+    #define SONIC_ECHO_HIGH 1           //Rising edge seen, waiting for the falling edge
+    #define SONIC_ECHO_DONE 2           //Pulse measured
+
+    /* 
+        RAM budget of one sensor core (32 bit targets / 64 bit hosts), checked at compile time so a new member can't
+        quietly grow every sensor of a large fleet.  The burst buffers are not part of it, see SONIC_BURST_POOL.
+    */
+    #define SONIC_I2C_CORE_BYTES ((sizeof(void*) == 4) ? 56 : 64)
+    #define SONIC_IO_CORE_BYTES ((sizeof(void*) == 4) ? 64 : 72)
+
+    /* Instrumentation counters kept by both cores (since begin or the last resetCounters()) */
+    struct SONIC_COUNTERS {
+        uint32_t triggers;      //Measurements started
+        uint32_t readings;      //Readings handed to the user and the sinks
+        uint32_t gated;         //Readings dropped by the range gate
+        uint32_t misses;        //(I2C) Triggers/reads the chip NAKed, (IO) echoes that timed out
+    };
+
+    class SONIC_I2C_CORE {
+        public:
+            SONIC_I2C_CORE() = default;
+
+            /* Hands a burst buffer that is still held back to the pool */
+            ~SONIC_I2C_CORE() {stopBurst();}
+
+            /* A copy would hand the same burst buffer back to the pool twice (and share the ISR's state) */
+            SONIC_I2C_CORE(const SONIC_I2C_CORE&) = delete;
+            SONIC_I2C_CORE& operator=(const SONIC_I2C_CORE&) = delete;
+
+            /* 
+                Gets the raw distance in mm of the sensor.  This will always contain the latest reading.  If the user wishes
+                to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
+                Otherwise, the user will read the same data over and over throwing off the average count.
+            */
+            float getDistance();
+
+            /* 
+                Gets the raw distance truncated to the nearest mm of the sensor.  This will always contain the latest reading.  
+                If the user wishes to implement any averaging, it is necessary to only call this function once readingAvailable() returns true.
+                Otherwise, the user will read the same data over and over throwing off the average count.
+            */
+            uint16_t getDistance_uint16();
+
+            /* 
+                Gets the distance in um as an integer, with the same caveats as getDistance().  This is the value the
+                correction is applied to, so reset the correction before using it to take calibration readings.
+            */
+            uint32_t getDistance_um();
+
+            /* 
+                Gets the per-sensor linear correction applied to every new reading.  To calibrate: reset() it, take a
+                reading with a target at two known distances, then pass both raw/actual pairs to calibrate().
+            */
+            SONIC_CORRECTION* getCorrection();
+
+            /* 
+                Attaches/detaches a sink (e.g. SONIC_BACKGROUND) that gets every new reading as soon as
+                readingAvailable() collects it.  A sink can only be attached to one sensor at a time.
+            */
+            void attach(SONIC_SINK* sink);
+            void detach(SONIC_SINK* sink);
+
+            /* 
+                Starts an oversampling burst of 1 to SONIC_BURST_MAX back-to-back readings.  While the burst is running,
+                poll burstAvailable() instead of readingAvailable() - it returns true once the burst is complete and the
+                outlier-rejected mean/median/stddev have been written into the result.  The sample buffer is taken from a
+                pool shared by all sensors (SONIC_BURST_POOL) - returns false if all of them are in use right now.
+            */
+            uint8_t startBurst(uint8_t samples);
+
+            /* Abandons the running burst and hands its buffer back to the pool */
+            void stopBurst();
+
+            /* Allows the calling functions to check whether or not the sensor is busy */
+            uint8_t getStatus();
+
+            /* 
+                Gets/sets the range gate in mm (inclusive).  Readings outside of it are counted and dropped: readingAvailable()
+                doesn't return true for them, the sinks don't see them and getDistance() keeps the last reading inside the gate.
+            */
+            void getRange(uint16_t* min_mm, uint16_t* max_mm);
+            void setRange(uint16_t min_mm, uint16_t max_mm);
+
+            /* Gets/sets the minimum time between the start of two measurements in ms (0 = back to back) */
+            uint16_t getInterval();
+            void setInterval(uint16_t ms);
+
+            /* Gets/clears the instrumentation counters */
+            const SONIC_COUNTERS* getCounters();
+            void resetCounters();
+
+            /* Gets/sets the trigger-to-read delay (ms) used for the given distance band */
+            uint8_t getConversionTime(uint8_t band);
+            void setConversionTime(uint8_t band, uint8_t ms);
+
+        protected:
+            /* Clears any measurement in progress */
+            void reset();
+
+            /* Returns the action the adapter has to perform (SONIC_ACTION_NONE/TRIGGER/READ) */
+            uint8_t poll(uint64_t now_ms);
+
+            /* 
+                Gets the time (ms) until poll() asks for the next trigger - 0 while busy or once it does.  Event driven
+                adapters arm a timer for it instead of polling.
+            */
+            uint32_t holdoff(uint64_t now_ms);
+
+            /* The adapter sent the trigger - starts the conversion timer */
+            void triggered(uint64_t now_ms);
+
+            /* The chip NAKed the trigger - counts a miss and holds the next attempt off for the full conversion time */
+            void trigger_failed(uint64_t now_ms);
+
+            /* 
+                The adapter read the data (length = bytes actually received) - returns true if a new reading was collected.
+                Returns false and stays busy if a shortened conversion time was NAKed, see getWait().  Returns false (not busy)
+                if the read failed at the full conversion time (counted as a miss) or the reading was dropped by the range gate.
+            */
+            uint8_t received(const uint8_t* data, uint8_t length, uint64_t now_ms);
+
+            /* Gets the conversion time (ms since triggered()) the current measurement waits for */
+            uint8_t getWait();
+
+            /* Stores a calibrated conversion time for the band of the reference reading (and caps the nearer bands) */
+            void calibrated(uint32_t reference, uint8_t data_time);
+
+            /* Adds the latest reading to the running burst - returns true once the result has been written */
+            uint8_t collect_burst(SONIC_BURST_RESULT* result);
+
+        private:
+            /* Private function to check if a timer has expired */
+            uint8_t timer_expired(uint64_t now_ms, uint64_t timer, uint32_t timeout);
+
+            /* Private function to map a reading onto its conversion time band */
+            uint8_t distance_band(uint32_t data);
+
+            /* Private function to check a reading against the range gate */
+            uint8_t in_range(uint32_t data);
+
+            /* 
+                Private variables, widest first so nothing is padded.  The trigger time (ms on the adapter's 64 bit
+                clock, so it can't alias after a long idle period) doubles as the conversion timer (while busy) and the
+                interval reference (while idle).
+            */
+            uint64_t _sensor_trigger_time = 0;
+            SONIC_SINK_LIST _sinks;
+            SONIC_BURST* _burst = nullptr;
+            uint32_t _sensor_data = SONIC_MAX_DISTANCE_UM;
+            SONIC_CORRECTION _correction;
+            SONIC_COUNTERS _counters = {};
+            uint16_t _range_min = 0;
+            uint16_t _range_max = SONIC_MAX_DISTANCE;
+            uint16_t _interval = 0;
+            uint8_t _sensor_data_time[SONIC_I2C_BANDS] = {SONIC_I2C_DATA_TIME, SONIC_I2C_DATA_TIME, SONIC_I2C_DATA_TIME};
+            uint8_t _sensor_wait = SONIC_I2C_DATA_TIME;
+            uint8_t _sensor_busy = false;
+            uint8_t _sensor_retry = false;
+    };
+
+    class SONIC_IO_CORE {
+        public:
+            SONIC_IO_CORE() = default;
+
+            /* Hands a burst buffer that is still held back to the pool */
+            ~SONIC_IO_CORE() {stopBurst();}
+
+            /* A copy would hand the same burst buffer back to the pool twice (and share the ISR's state) */
+            SONIC_IO_CORE(const SONIC_IO_CORE&) = delete;
+            SONIC_IO_CORE& operator=(const SONIC_IO_CORE&) = delete;
+
+            /* Gets the distance in mm / truncated mm / um - see SONIC_I2C_CORE */
+            float getDistance();
+            uint16_t getDistance_uint16();
+            uint32_t getDistance_um();
+
+            /* Gets the per-sensor linear correction applied to every new reading */
+            SONIC_CORRECTION* getCorrection();
+
+            /* Attaches/detaches a sink that gets every new reading */
+            void attach(SONIC_SINK* sink);
+            void detach(SONIC_SINK* sink);
+
+            /* Starts/abandons an oversampling burst - poll burstAvailable() until it completes */
+            uint8_t startBurst(uint8_t samples);
+            void stopBurst();
+
+            /* Allows the calling functions to check whether or not the sensor is busy */
+            uint8_t getStatus();
+
+            /* Gets/sets the range gate in mm and the minimum time between measurements - see SONIC_I2C_CORE */
+            void getRange(uint16_t* min_mm, uint16_t* max_mm);
+            void setRange(uint16_t min_mm, uint16_t max_mm);
+            uint16_t getInterval();
+            void setInterval(uint16_t ms);
+
+            /* Gets/clears the instrumentation counters */
+            const SONIC_COUNTERS* getCounters();
+            void resetCounters();
+
+        protected:
+            /* Clears any measurement in progress */
+            void reset();
+
+            /* Returns the action the adapter has to perform (SONIC_ACTION_NONE/TRIGGER/READING) */
+            uint8_t poll(uint64_t now_ms);
+
+            /* Gets the time (ms) until poll() asks for the next ping - see SONIC_I2C_CORE */
+            uint32_t holdoff(uint64_t now_ms);
+
+            /* The adapter sent the trigger pulse - starts the timeout timer */
+            void triggered(uint64_t now_ms);
+
+            /* 
+                ISR safe edge handlers for adapters that timestamp the echo themselves (us, or a free running count of
+                tick_ns ticks).  A falling edge only counts after a rising edge of the current measurement, a repeated rising
+                edge restarts the pulse and edges after a completed echo are ignored until the next trigger.
+            */
+            void echo_rising(uint32_t now_us);
+            void echo_falling(uint32_t now_us, uint32_t tick_ns = 1000);
+
+            /* For adapters that measure the echo pulse width directly (e.g. kernel edge timestamps) */
+            void echo_pulse(uint32_t width_ns);
+
+            /* Forces the timeout path (for adapters with their own timeout timer) - returns false if the reading was gated */
+            uint8_t expire(uint64_t now_ms);
+
+            /* Adds the latest reading to the running burst - returns true once the result has been written */
+            uint8_t collect_burst(SONIC_BURST_RESULT* result);
+
+        private:
+            /* Private function to check if a timer has expired */
+            uint8_t timer_expired(uint64_t now_ms, uint64_t timer, uint32_t timeout);
+
+            /* Private function to finish the measurement and publish the reading - returns false if it was gated */
+            uint8_t data_collected(uint32_t data, uint64_t now_ms);
+
+            /* Private function to check a reading against the range gate */
+            uint8_t in_range(uint32_t data);
+
+            /* 
+                Private variables, widest first so nothing is padded.  The 64 bit ping time doubles as the echo timeout
+                timer (while busy) and the interval reference (while idle).  The ISR written ones stay whole words/bytes so
+                the loop never does a read-modify-write on them.
+            */
+            uint64_t _sensor_ping_time = 0;
+            SONIC_SINK_LIST _sinks;
+            SONIC_BURST* _burst = nullptr;
+            volatile uint32_t _sensor_pulse_start = 0;
+            volatile uint32_t _sensor_pulse_duration = 0;
+            uint32_t _sensor_data = SONIC_MAX_DISTANCE_UM;
+            SONIC_CORRECTION _correction;
+            SONIC_COUNTERS _counters = {};
+            uint16_t _range_min = 0;
+            uint16_t _range_max = SONIC_MAX_DISTANCE;
+            uint16_t _interval = 0;
+            volatile uint8_t _sensor_echo = SONIC_ECHO_WAIT;
+            uint8_t _sensor_busy = false;
+    };
+
+#endif
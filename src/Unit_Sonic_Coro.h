@@ -0,0 +1,213 @@
+/*
+    C++20 coroutine front end for the Unit Sonic sensors.
+
+    SONIC_EXECUTOR is a tiny single threaded executor: every coroutine suspended on a measurement (or a
+    sleep) sits in an intrusive queue and run_once(), called from the user's loop, drives the sensor's
+    readingAvailable() exactly like a hand written poll loop would, resuming the coroutine once the
+    reading is there.  Nothing is allocated apart from the coroutine frames themselves.
+
+        SONIC_TASK ranging(SONIC_EXECUTOR& executor, SONIC_I2C& sonic) {
+            for(;;) {
+                uint32_t distance_um = co_await executor.measure(sonic);
+                ...
+            }
+        }
+
+    Only one coroutine may wait on a given sensor at a time - the first one to poll it consumes the reading.
+    A task may be destroyed while it is suspended (its measurement/sleep leaves the queue with it), but the
+    executor must outlive every task that waits on it.
+    Only available when the compiler has coroutine support (C++20, e.g. -std=gnu++20).
+*/
+#ifndef _UNIT_SONIC_CORO_H_
+    #define _UNIT_SONIC_CORO_H_
+
+    #include <stdint.h>
+
+    #if defined(__cpp_impl_coroutine) && defined(__has_include)
+        #if __has_include(<coroutine>)
+            #define SONIC_HAVE_COROUTINES 1
+        #endif
+    #endif
+
+    #if defined(SONIC_HAVE_COROUTINES)
+
+        #include <coroutine>
+        #include <exception>
+        #include "Unit_Sonic_Request.h"
+
+        /* Coroutine return type - starts running immediately, the frame is freed when the task is destroyed */
+        class SONIC_TASK {
+            public:
+                struct promise_type {
+                    SONIC_TASK get_return_object() {return SONIC_TASK(std::coroutine_handle<promise_type>::from_promise(*this));}
+                    std::suspend_never initial_suspend() noexcept {return {};}
+                    std::suspend_always final_suspend() noexcept {return {};}
+                    void return_void() {}
+                    void unhandled_exception() {std::terminate();}
+                };
+
+                SONIC_TASK(SONIC_TASK&& other) : _handle(other._handle) {other._handle = nullptr;}
+                SONIC_TASK(const SONIC_TASK&) = delete;
+                SONIC_TASK& operator=(const SONIC_TASK&) = delete;
+                ~SONIC_TASK() {if(_handle) {_handle.destroy();}}
+
+                /* Checks whether the coroutine has run to completion */
+                uint8_t done() const {return !_handle || _handle.done();}
+
+            private:
+                explicit SONIC_TASK(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+
+                /* Private variable for the coroutine owned by this task */
+                std::coroutine_handle<promise_type> _handle;
+        };
+
+        class SONIC_EXECUTOR;
+
+        /*
+            Awaitable returned by SONIC_EXECUTOR::measure()/sleep() - checked once when awaited, then queued on the
+            executor until its poll function reports it ready.  It lives in the awaiting coroutine's frame, so it
+            takes itself off the queue when that frame is destroyed before it was resumed.
+        */
+        class SONIC_AWAITER {
+            public:
+                typedef uint8_t (*POLL)(void* context, uint32_t* value);
+
+                SONIC_AWAITER(SONIC_EXECUTOR* executor, void* context, POLL poll, uint32_t value) :
+                    _executor(executor), _context(context), _poll(poll), _value(value) {}
+                SONIC_AWAITER(const SONIC_AWAITER&) = delete;
+                SONIC_AWAITER& operator=(const SONIC_AWAITER&) = delete;
+                ~SONIC_AWAITER();
+
+                uint8_t await_ready() {return _poll(_context, &_value);}
+                void await_suspend(std::coroutine_handle<> handle);
+                uint32_t await_resume() const {return _value;}
+
+            private:
+                friend class SONIC_EXECUTOR;
+
+                /* Private variables for what is being waited on */
+                SONIC_EXECUTOR* _executor;
+                void* _context;
+                POLL _poll;
+                uint32_t _value;
+
+                /* Private variables for the queue of the executor */
+                std::coroutine_handle<> _handle;
+                SONIC_AWAITER* _next = nullptr;
+                uint8_t _queued = false;
+        };
+
+        class SONIC_EXECUTOR {
+            public:
+                /* The clock (ms) is only needed by sleep() - pass the same time base the sensors run on (e.g. millis) */
+                explicit SONIC_EXECUTOR(uint32_t (*clock_ms)() = nullptr) : _clock_ms(clock_ms) {}
+
+                /* Waits for the next reading of a sensor - co_await yields the distance in um */
+                template <typename SENSOR>
+                SONIC_AWAITER measure(SENSOR& sensor) {return SONIC_AWAITER(this, &sensor, &SONIC_REQUEST::poll_sensor<SENSOR>, 0);}
+
+                /* Waits for a number of ms on the executor's clock - co_await yields the time it woke up */
+                SONIC_AWAITER sleep(uint32_t ms) {return SONIC_AWAITER(this, this, &poll_sleep, now() + ms);}
+
+                /*
+                    Polls every waiting measurement/sleep once and resumes the coroutines that are ready - call it from
+                    the user's loop.  Returns the number of coroutines resumed.
+                */
+                uint16_t run_once() {
+                    uint16_t resumed = 0;
+
+                    /*
+                        Coroutines resumed below may queue new awaiters, they are only polled on the next pass.  The ones
+                        not polled yet stay in _polling, where a task destroyed by a resumed coroutine can unlink its own.
+                    */
+                    _polling = _head;
+                    _head = nullptr;
+                    _tail = nullptr;
+
+                    while(_polling) {
+                        SONIC_AWAITER* awaiter = _polling;
+                        _polling = awaiter->_next;
+                        awaiter->_next = nullptr;
+                        awaiter->_queued = false;
+
+                        if(awaiter->_poll(awaiter->_context, &awaiter->_value)) {
+                            awaiter->_handle.resume();
+                            resumed++;
+                        } else {
+                            enqueue(awaiter);
+                        }
+                    }
+
+                    return resumed;
+                }
+
+                /* Checks whether any coroutine is still waiting on this executor */
+                uint8_t pending() const {return _head != nullptr;}
+
+            private:
+                friend class SONIC_AWAITER;
+
+                /* Private function to queue a suspended awaiter at the end of the queue */
+                void enqueue(SONIC_AWAITER* awaiter) {
+                    awaiter->_queued = true;
+                    if(_tail) {
+                        _tail->_next = awaiter;
+                    } else {
+                        _head = awaiter;
+                    }
+                    _tail = awaiter;
+                }
+
+                /* Private function to unlink an awaiter whose coroutine was destroyed while it was queued */
+                void remove(SONIC_AWAITER* awaiter) {
+                    for(SONIC_AWAITER** link = &_polling; *link; link = &(*link)->_next) {
+                        if(*link == awaiter) {
+                            *link = awaiter->_next;
+                            return;
+                        }
+                    }
+
+                    SONIC_AWAITER* previous = nullptr;
+                    for(SONIC_AWAITER* item = _head; item; previous = item, item = item->_next) {
+                        if(item != awaiter) {continue;}
+
+                        if(previous) {
+                            previous->_next = item->_next;
+                        } else {
+                            _head = item->_next;
+                        }
+                        if(_tail == item) {_tail = previous;}
+                        return;
+                    }
+                }
+
+                /* Private function to read the executor's clock */
+                uint32_t now() const {return _clock_ms ? _clock_ms() : 0;}
+
+                /* Private function to poll a sleep (measurements share the poll function of SONIC_REQUEST) */
+                static uint8_t poll_sleep(void* context, uint32_t* value) {
+                    uint32_t now = ((SONIC_EXECUTOR*)context)->now();
+                    if((int32_t)(now - *value) < 0) {return false;}
+                    *value = now;
+                    return true;
+                }
+
+                /* Private variables for the queue of suspended awaiters */
+                SONIC_AWAITER* _head = nullptr;
+                SONIC_AWAITER* _tail = nullptr;
+                SONIC_AWAITER* _polling = nullptr;
+                uint32_t (*_clock_ms)();
+        };
+
+        inline void SONIC_AWAITER::await_suspend(std::coroutine_handle<> handle) {
+            _handle = handle;
+            _executor->enqueue(this);
+        }
+
+        inline SONIC_AWAITER::~SONIC_AWAITER() {
+            if(_queued) {_executor->remove(this);}
+        }
+
+    #endif
+
+#endif
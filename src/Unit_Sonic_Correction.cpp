@@ -0,0 +1,105 @@
+#include "Unit_Sonic_Correction.h"
+
+#if defined(ESP_PLATFORM)
+    #include "nvs.h"
+#else
+    #include <stdio.h>
+#endif
+
+/* Layout of the persisted coefficients */
+struct sonic_correction_record {
+    uint32_t magic;
+    int32_t scale;
+    int32_t offset;
+};
+
+/* "SCAL" - lets load() reject blobs/files that don't hold a correction */
+static const uint32_t SONIC_CORRECTION_MAGIC = 0x5343414CUL;
+
+/* Restores the identity correction (corrected reading == raw reading) */
+void SONIC_CORRECTION::reset() {
+    _scale = SONIC_CORRECTION_ONE;
+    _offset = 0;
+}
+
+/* Solves the scale/offset from two raw readings (um) taken with a target at two known distances (um) */
+uint8_t SONIC_CORRECTION::calibrate(uint32_t raw_a, uint32_t actual_a, uint32_t raw_b, uint32_t actual_b) {
+    if(raw_a == raw_b) {return false;}
+
+    /* actual = raw * scale + offset --> scale = d(actual) / d(raw) */
+    int64_t scale = (((int64_t)actual_b - (int64_t)actual_a) * SONIC_CORRECTION_ONE) / ((int64_t)raw_b - (int64_t)raw_a);
+
+    if((scale < SONIC_CORRECTION_MIN_SCALE) || (scale > SONIC_CORRECTION_MAX_SCALE)) {return false;}
+
+    _scale = (int32_t)scale;
+    _offset = (int32_t)((int64_t)actual_a - (((int64_t)raw_a * scale) >> 16));
+
+    return true;
+}
+
+#if defined(ESP_PLATFORM)
+
+/* Persists the coefficients to NVS */
+uint8_t SONIC_CORRECTION::save(const char *name) const {
+    sonic_correction_record record = {SONIC_CORRECTION_MAGIC, _scale, _offset};
+    nvs_handle_t handle;
+
+    if(nvs_open(SONIC_CORRECTION_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) {return false;}
+
+    uint8_t ok = (nvs_set_blob(handle, name, &record, sizeof(record)) == ESP_OK) && (nvs_commit(handle) == ESP_OK);
+    nvs_close(handle);
+
+    return ok;
+}
+
+/* Restores the coefficients from NVS */
+uint8_t SONIC_CORRECTION::load(const char *name) {
+    sonic_correction_record record;
+    size_t length = sizeof(record);
+    nvs_handle_t handle;
+
+    if(nvs_open(SONIC_CORRECTION_NVS_NAMESPACE, NVS_READONLY, &handle) != ESP_OK) {return false;}
+
+    uint8_t ok = (nvs_get_blob(handle, name, &record, &length) == ESP_OK) && (length == sizeof(record));
+    nvs_close(handle);
+
+    if(!ok || (record.magic != SONIC_CORRECTION_MAGIC)) {return false;}
+
+    _scale = record.scale;
+    _offset = record.offset;
+    return true;
+}
+
+#else
+
+/* Persists the coefficients to a file */
+uint8_t SONIC_CORRECTION::save(const char *name) const {
+    sonic_correction_record record = {SONIC_CORRECTION_MAGIC, _scale, _offset};
+    FILE *file = fopen(name, "wb");
+
+    if(!file) {return false;}
+
+    uint8_t ok = (fwrite(&record, sizeof(record), 1, file) == 1);
+    ok = (fclose(file) == 0) && ok;
+
+    return ok;
+}
+
+/* Restores the coefficients from a file */
+uint8_t SONIC_CORRECTION::load(const char *name) {
+    sonic_correction_record record;
+    FILE *file = fopen(name, "rb");
+
+    if(!file) {return false;}
+
+    uint8_t ok = (fread(&record, sizeof(record), 1, file) == 1);
+    fclose(file);
+
+    if(!ok || (record.magic != SONIC_CORRECTION_MAGIC)) {return false;}
+
+    _scale = record.scale;
+    _offset = record.offset;
+    return true;
+}
+
+#endif
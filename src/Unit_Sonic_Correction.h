@@ -0,0 +1,53 @@
+/*
+    Per-sensor linear distance correction for the Unit Sonic drivers.
+
+    Each unit reads a few mm off, so this keeps a fixed point (Q16) scale and a um offset
+    that is applied once per reading in integer math.  The coefficients are solved from a
+    two-point calibration and can be persisted to NVS (ESP32) or to a file (host builds).
+*/
+#ifndef _UNIT_SONIC_CORRECTION_H_
+    #define _UNIT_SONIC_CORRECTION_H_
+
+    #include <stdint.h>
+
+    #define SONIC_CORRECTION_ONE 65536                  //Q16 representation of a scale of 1.0
+    #define SONIC_CORRECTION_MIN_SCALE 32768            //Reject calibrations that would scale the reading below 0.5x
+    #define SONIC_CORRECTION_MAX_SCALE 131072           //Reject calibrations that would scale the reading above 2.0x
+    #define SONIC_CORRECTION_NVS_NAMESPACE "sonic_cal"  //NVS namespace used to persist the coefficients on target
+
+    class SONIC_CORRECTION {
+        public:
+            /* Restores the identity correction (corrected reading == raw reading) */
+            void reset();
+
+            /* 
+                Solves the scale/offset from two raw readings (um) taken with a target at two known distances (um).
+                The points should be as far apart as practical.  Returns false (and leaves the correction untouched)
+                if the points are degenerate or would result in an unreasonable scale.
+            */
+            uint8_t calibrate(uint32_t raw_a, uint32_t actual_a, uint32_t raw_b, uint32_t actual_b);
+
+            /* Applies the correction to a raw reading in um */
+            uint32_t apply(uint32_t raw) const {
+                int64_t corrected = (((int64_t)raw * _scale) >> 16) + _offset;
+                return (corrected > 0) ? (uint32_t)corrected : 0;
+            }
+
+            /* 
+                Persists / restores the coefficients.  On target the name is the NVS key (max 15 characters), on
+                host builds it is the path of the file to use.  Both return true on success.
+            */
+            uint8_t save(const char *name) const;
+            uint8_t load(const char *name);
+
+            /* Gets the current coefficients */
+            int32_t getScale() const {return _scale;}
+            int32_t getOffset() const {return _offset;}
+
+        private:
+            /* Private variables for the Q16 scale and the um offset */
+            int32_t _scale = SONIC_CORRECTION_ONE;
+            int32_t _offset = 0;
+    };
+
+#endif
@@ -0,0 +1,205 @@
+/*
+    Compile time fleet of Unit Sonic sensors for fixed configurations (robots, fixtures).
+
+    The sensor types, pins and I2C addresses are template parameters, so the whole fleet is one statically
+    allocated object (nothing touches the heap), pin conflicts are rejected by the compiler, and service()
+    polls every sensor in a loop the compiler unrolls - no virtual calls, no pointer chasing:
+
+        SONIC_FLEET<SONIC_FLEET_I2C<21, 22>, SONIC_FLEET_IO<26, 32>, SONIC_FLEET_IO<25, 33>> fleet;
+
+        fleet.begin(&Wire);                                 //(ESP-IDF: the i2c_master bus handle)
+        uint32_t ready = fleet.service();                   //Bit i is set if sensor i has a new reading
+        if(ready & 0x02) {fleet.get<1>().getDistance();}
+
+    Every I2C sensor of a fleet sits on the same bus (one TwoWire / i2c_master bus), so they need distinct
+    addresses.  The IO sensors hook their own echo interrupt.  Arduino and ESP-IDF only, and only available
+    when the compiler supports C++17.
+*/
+#ifndef _UNIT_SONIC_FLEET_H_
+    #define _UNIT_SONIC_FLEET_H_
+
+    #include "Unit_Sonic.h"
+
+    #if (__cplusplus >= 201703L) && (defined(SONIC_PLATFORM_ARDUINO) || defined(SONIC_PLATFORM_IDF))
+        #define SONIC_HAVE_FLEET 1
+    #endif
+
+    #if defined(SONIC_HAVE_FLEET)
+
+        #include <array>
+        #include <tuple>
+        #include <utility>
+
+        #define SONIC_FLEET_MAX 32          //Sensors per fleet (one bit each in the service() mask)
+
+        /* Sensor types of a fleet entry */
+        #define SONIC_FLEET_TYPE_I2C 0
+        #define SONIC_FLEET_TYPE_IO 1
+
+        /* The bus handed to SONIC_FLEET::begin() */
+        #if defined(SONIC_PLATFORM_ARDUINO)
+            typedef TwoWire* SONIC_FLEET_BUS;
+        #else
+            typedef i2c_master_bus_handle_t SONIC_FLEET_BUS;
+        #endif
+
+        /* Fleet entry for an I2C sensor (the pins are only used for the conflict checks on ESP-IDF) */
+        template <uint8_t SDA_PIN, uint8_t SCL_PIN, uint8_t ADDR = 0x57>
+        struct SONIC_FLEET_I2C {
+            typedef SONIC_I2C sensor_t;
+
+            static constexpr uint8_t type = SONIC_FLEET_TYPE_I2C;
+            static constexpr uint8_t pin_a = SDA_PIN;
+            static constexpr uint8_t pin_b = SCL_PIN;
+            static constexpr uint8_t addr = ADDR;
+
+            /* Starts the sensor - returns whether it was detected or not */
+            static uint8_t begin(sensor_t& sensor, SONIC_FLEET_BUS bus, uint32_t speed) {
+                #if defined(SONIC_PLATFORM_ARDUINO)
+                    return sensor.begin(bus, ADDR, SDA_PIN, SCL_PIN, speed);
+                #else
+                    return sensor.begin(bus, ADDR, speed);
+                #endif
+            }
+        };
+
+        /* Fleet entry for an IO sensor - hooks its own echo interrupt */
+        template <uint8_t TRIG_PIN, uint8_t ECHO_PIN>
+        struct SONIC_FLEET_IO {
+            typedef SONIC_IO sensor_t;
+
+            static constexpr uint8_t type = SONIC_FLEET_TYPE_IO;
+            static constexpr uint8_t pin_a = TRIG_PIN;
+            static constexpr uint8_t pin_b = ECHO_PIN;
+            static constexpr uint8_t addr = 0;
+
+            /* Starts the sensor - returns false if the pins couldn't be set up */
+            static uint8_t begin(sensor_t& sensor, SONIC_FLEET_BUS bus, uint32_t speed) {
+                (void)bus;
+                (void)speed;
+
+                #if defined(SONIC_PLATFORM_ARDUINO)
+                    sensor.begin(TRIG_PIN, ECHO_PIN);
+                    sensor.attachEcho();
+                    return true;
+                #else
+                    return sensor.begin((gpio_num_t)TRIG_PIN, (gpio_num_t)ECHO_PIN);
+                #endif
+            }
+        };
+
+        /* Compile time checks of a fleet configuration */
+        template <typename... SENSORS>
+        struct SONIC_FLEET_CHECK {
+            static constexpr uint8_t count = sizeof...(SENSORS);
+            static constexpr uint8_t type[] = {SENSORS::type...};
+            static constexpr uint8_t pin_a[] = {SENSORS::pin_a...};
+            static constexpr uint8_t pin_b[] = {SENSORS::pin_b...};
+            static constexpr uint8_t addr[] = {SENSORS::addr...};
+
+            /* No pin is used twice (the I2C sensors may only share their bus pins) */
+            static constexpr bool pins_unique() {
+                for(uint8_t i = 0; i < count; i++) {
+                    if(pin_a[i] == pin_b[i]) {return false;}
+
+                    for(uint8_t j = i + 1; j < count; j++) {
+                        if((type[i] == SONIC_FLEET_TYPE_I2C) && (type[j] == SONIC_FLEET_TYPE_I2C)) {continue;}
+                        if((pin_a[i] == pin_a[j]) || (pin_a[i] == pin_b[j]) || (pin_b[i] == pin_a[j]) || (pin_b[i] == pin_b[j])) {return false;}
+                    }
+                }
+                return true;
+            }
+
+            /* Every I2C sensor sits on the same SDA/SCL pins */
+            static constexpr bool single_bus() {
+                for(uint8_t i = 0; i < count; i++) {
+                    for(uint8_t j = i + 1; j < count; j++) {
+                        if((type[i] != SONIC_FLEET_TYPE_I2C) || (type[j] != SONIC_FLEET_TYPE_I2C)) {continue;}
+                        if((pin_a[i] != pin_a[j]) || (pin_b[i] != pin_b[j])) {return false;}
+                    }
+                }
+                return true;
+            }
+
+            /* No I2C address is used twice */
+            static constexpr bool addresses_unique() {
+                for(uint8_t i = 0; i < count; i++) {
+                    for(uint8_t j = i + 1; j < count; j++) {
+                        if((type[i] == SONIC_FLEET_TYPE_I2C) && (type[j] == SONIC_FLEET_TYPE_I2C) && (addr[i] == addr[j])) {return false;}
+                    }
+                }
+                return true;
+            }
+        };
+
+        template <typename... SENSORS>
+        class SONIC_FLEET {
+            typedef SONIC_FLEET_CHECK<SENSORS...> check;
+
+            static_assert((sizeof...(SENSORS) > 0) && (sizeof...(SENSORS) <= SONIC_FLEET_MAX), "SONIC_FLEET takes 1 to SONIC_FLEET_MAX sensors");
+            static_assert(check::pins_unique(), "SONIC_FLEET: a pin is used by two sensors (or a sensor uses the same pin twice)");
+            static_assert(check::single_bus(), "SONIC_FLEET: every I2C sensor of a fleet has to sit on the same SDA/SCL pins");
+            static_assert(check::addresses_unique(), "SONIC_FLEET: two I2C sensors share an address");
+
+            public:
+                /* Number of sensors in the fleet */
+                static constexpr uint8_t COUNT = sizeof...(SENSORS);
+
+                /* Starts every sensor - returns true if all of them were detected/set up */
+                uint8_t begin(SONIC_FLEET_BUS bus, uint32_t speed = 200000L) {
+                    return begin(bus, speed, std::index_sequence_for<SENSORS...>{});
+                }
+
+                /* Polls every sensor once - bit i of the result is set if sensor i has a new reading */
+                uint32_t service() {
+                    return service(std::index_sequence_for<SENSORS...>{});
+                }
+
+                /* Gets sensor I (SONIC_I2C / SONIC_IO) */
+                template <uint8_t I>
+                auto& get() {return std::get<I>(_sensors);}
+
+                /* Gets the latest distance of every sensor in um */
+                void getDistances_um(std::array<uint32_t, COUNT>& distances) {
+                    getDistances_um(distances, std::index_sequence_for<SENSORS...>{});
+                }
+
+                /* Calls function(sensor, index) for every sensor */
+                template <typename FUNCTION>
+                void forEach(FUNCTION function) {
+                    forEach(function, std::index_sequence_for<SENSORS...>{});
+                }
+
+            private:
+                /* Private functions to unroll the calls over every sensor */
+                template <size_t... I>
+                uint8_t begin(SONIC_FLEET_BUS bus, uint32_t speed, std::index_sequence<I...>) {
+                    uint8_t ok = true;
+                    ((ok &= (SENSORS::begin(std::get<I>(_sensors), bus, speed) ? 1 : 0)), ...);
+                    return ok;
+                }
+
+                template <size_t... I>
+                uint32_t service(std::index_sequence<I...>) {
+                    uint32_t ready = 0;
+                    ((ready |= (std::get<I>(_sensors).readingAvailable() ? 1UL : 0UL) << I), ...);
+                    return ready;
+                }
+
+                template <size_t... I>
+                void getDistances_um(std::array<uint32_t, COUNT>& distances, std::index_sequence<I...>) {
+                    ((distances[I] = std::get<I>(_sensors).getDistance_um()), ...);
+                }
+
+                template <typename FUNCTION, size_t... I>
+                void forEach(FUNCTION& function, std::index_sequence<I...>) {
+                    (function(std::get<I>(_sensors), (uint8_t)I), ...);
+                }
+
+                /* Private variable for the sensors themselves */
+                std::tuple<typename SENSORS::sensor_t...> _sensors;
+        };
+
+    #endif
+
+#endif
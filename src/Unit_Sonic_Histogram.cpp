@@ -0,0 +1,54 @@
+#include <string.h>
+#include "Unit_Sonic_Histogram.h"
+
+/* Sets the width of the distance buckets and clears the histograms */
+void SONIC_HISTOGRAM::begin(uint16_t bucket_mm) {
+    _lock.lock();
+    _bucket_um = (uint32_t)(bucket_mm ? bucket_mm : 1) * 1000;
+    clear();
+    _started = false;
+    _lock.unlock();
+}
+
+/* Counts a reading */
+void SONIC_HISTOGRAM::update(uint32_t distance_um, uint32_t timestamp_ms) {
+    uint32_t distance = distance_um / _bucket_um;
+    if(distance >= SONIC_HISTOGRAM_BUCKETS) {distance = SONIC_HISTOGRAM_BUCKETS - 1;}
+
+    _lock.lock();
+    _distance[distance]++;
+
+    /* The interval bucket is the bit length of the interval */
+    if(_started) {
+        uint32_t elapsed = timestamp_ms - _last_ms;
+        uint32_t interval = elapsed ? 32 - __builtin_clz(elapsed) : 0;
+        if(interval >= SONIC_HISTOGRAM_BUCKETS) {interval = SONIC_HISTOGRAM_BUCKETS - 1;}
+        _interval[interval]++;
+    }
+    _last_ms = timestamp_ms;
+    _started = true;
+    _lock.unlock();
+}
+
+/* Copies the histograms, optionally clearing them in the same critical section */
+void SONIC_HISTOGRAM::snapshot(SONIC_HISTOGRAM_SNAPSHOT *snapshot, uint8_t reset) {
+    _lock.lock();
+    snapshot->bucket_mm = (uint16_t)(_bucket_um / 1000);
+    memcpy(snapshot->distance, _distance, sizeof(_distance));
+    memcpy(snapshot->interval, _interval, sizeof(_interval));
+    if(reset) {clear();}
+    _lock.unlock();
+}
+
+/* Clears the histograms (the next reading still gets its interval) */
+void SONIC_HISTOGRAM::reset() {
+    _lock.lock();
+    clear();
+    _lock.unlock();
+}
+
+/* Private function to clear the histograms without taking the lock */
+void SONIC_HISTOGRAM::clear() {
+    memset(_distance, 0, sizeof(_distance));
+    memset(_interval, 0, sizeof(_interval));
+}
@@ -0,0 +1,59 @@
+/*
+    Distance and reading interval histograms for the Unit Sonic drivers.
+
+    Counts every reading into fixed width distance buckets and the time since the previous reading into
+    power of two interval buckets, so the spread of a scene and the jitter of the acquisition loop can be
+    checked in the field (e.g. from SONIC_CONSOLE) without logging raw readings.
+*/
+#ifndef _UNIT_SONIC_HISTOGRAM_H_
+    #define _UNIT_SONIC_HISTOGRAM_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Sink.h"
+    #include "Unit_Sonic_Lock.h"
+
+    #define SONIC_HISTOGRAM_BUCKETS 16          //Buckets of each histogram
+    #define SONIC_HISTOGRAM_BUCKET_MM 300       //Default width of the distance buckets (16 x 300mm covers the sensor range)
+
+    /* Copy of the histograms at one point in time */
+    struct SONIC_HISTOGRAM_SNAPSHOT {
+        uint16_t bucket_mm;                             //Width of the distance buckets
+        uint32_t distance[SONIC_HISTOGRAM_BUCKETS];     //[i] counts i * bucket_mm <= distance < (i + 1) * bucket_mm, the last bucket everything farther
+        uint32_t interval[SONIC_HISTOGRAM_BUCKETS];     //[0] counts 0ms, [i] counts 2^(i-1) <= interval < 2^i ms, the last bucket everything slower
+    };
+
+    class SONIC_HISTOGRAM : public SONIC_SINK {
+        public:
+            /* Sets the width of the distance buckets and clears the histograms */
+            void begin(uint16_t bucket_mm = SONIC_HISTOGRAM_BUCKET_MM);
+
+            /* Counts a reading (um) */
+            void update(uint32_t distance_um, uint32_t timestamp_ms);
+
+            /* Sink interface - lets the histograms be attached directly to a sensor */
+            void onReading(uint32_t distance_um, uint32_t timestamp_ms) override {update(distance_um, timestamp_ms);}
+
+            /* Copies the histograms, optionally clearing them in the same critical section */
+            void snapshot(SONIC_HISTOGRAM_SNAPSHOT *snapshot, uint8_t reset = false);
+
+            /* Clears the histograms */
+            void reset();
+
+        private:
+            /* Private function to clear the histograms without taking the lock */
+            void clear();
+
+            /* Private variable to protect the histograms against concurrent snapshots */
+            SONIC_LOCK _lock;
+
+            /* Private variables for the histograms */
+            uint32_t _bucket_um = (uint32_t)SONIC_HISTOGRAM_BUCKET_MM * 1000;
+            uint32_t _distance[SONIC_HISTOGRAM_BUCKETS] = {};
+            uint32_t _interval[SONIC_HISTOGRAM_BUCKETS] = {};
+
+            /* Private variables for the interval of the next reading (the first reading has none) */
+            uint32_t _last_ms = 0;
+            uint8_t _started = false;
+    };
+
+#endif
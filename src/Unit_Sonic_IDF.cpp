@@ -0,0 +1,189 @@
+#include "Unit_Sonic_IDF.h"
+
+#if defined(SONIC_PLATFORM_IDF)
+
+#include "esp_rom_sys.h"
+#include "Unit_Sonic_Clock.h"
+
+static_assert(sizeof(SONIC_I2C) <= SONIC_I2C_BYTES, "SONIC_I2C outgrew its RAM budget");
+static_assert(sizeof(SONIC_IO) <= SONIC_IO_BYTES, "SONIC_IO outgrew its RAM budget");
+
+/* Adds the sensor to an already created i2c_master bus - returns whether it was detected or not */
+uint8_t SONIC_I2C::begin(i2c_master_bus_handle_t bus, uint8_t addr, uint32_t speed) {
+    end();
+    _bus = bus;
+    _addr = addr;
+
+    i2c_device_config_t config = {};
+    config.dev_addr_length = I2C_ADDR_BIT_LEN_7;
+    config.device_address = addr;
+    config.scl_speed_hz = speed;
+
+    if(i2c_master_bus_add_device(bus, &config, &_dev) != ESP_OK) {
+        _dev = nullptr;
+        return false;
+    }
+
+    /* Verify that a sensor was detected */
+    return i2c_master_probe(bus, addr, SONIC_IDF_I2C_TIMEOUT_MS) == ESP_OK;
+}
+
+/* Changes the SCL speed of this device at run time (the i2c_master driver only takes it when adding the device) */
+uint8_t SONIC_I2C::setSpeed(uint32_t speed) {
+    if(!_bus) {return false;}
+    return begin(_bus, _addr, speed);
+}
+
+/* Removes the sensor from the bus */
+void SONIC_I2C::end() {
+    if(_dev) {i2c_master_bus_rm_device(_dev);}
+    _dev = nullptr;
+    reset();
+}
+
+/* Checks whether or not new data is available */
+uint8_t SONIC_I2C::readingAvailable() {
+    SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_POLL);
+    uint64_t now = SONIC_CLOCK::millis64();
+
+    switch(poll(now)) {
+        case SONIC_ACTION_TRIGGER: {
+            /* Trigger a data collection */
+            SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_TRIGGER);
+            const uint8_t command = 0x01;
+
+            /* A NAKed trigger starts no conversion --> hold the next attempt off instead of reading it */
+            if(i2c_master_transmit(_dev, &command, 1, SONIC_IDF_I2C_TIMEOUT_MS) != ESP_OK) {
+                trigger_failed(now);
+                break;
+            }
+            triggered(now);
+            break;
+        }
+
+        case SONIC_ACTION_READ: {
+            /* Read the data from the sensor and let the core decode it */
+            uint8_t data[3];
+            uint8_t length;
+            {
+                SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_READ);
+                length = (i2c_master_receive(_dev, data, sizeof(data), SONIC_IDF_I2C_TIMEOUT_MS) == ESP_OK) ? sizeof(data) : 0;
+            }
+            return received(data, length, now);
+        }
+    }
+
+    /* If we made it here, there isn't any new data */
+    return false;
+}
+
+/* Drives the burst - returns true once it is complete and the result has been written */
+uint8_t SONIC_I2C::burstAvailable(SONIC_BURST_RESULT* result) {
+    return readingAvailable() && collect_burst(result);
+}
+
+gptimer_handle_t SONIC_IO::_timer = nullptr;
+
+/* Configures the pins and hooks the echo interrupt */
+uint8_t SONIC_IO::begin(gpio_num_t trig_pin, gpio_num_t echo_pin) {
+    end();
+
+    _trig_pin = trig_pin;
+    _echo_pin = echo_pin;
+
+    /* One free running timer serves every sensor */
+    if(!_timer) {
+        gptimer_config_t timer_config = {};
+        timer_config.clk_src = GPTIMER_CLK_SRC_DEFAULT;
+        timer_config.direction = GPTIMER_COUNT_UP;
+        timer_config.resolution_hz = SONIC_IDF_TIMER_HZ;
+
+        if(gptimer_new_timer(&timer_config, &_timer) != ESP_OK) {
+            _timer = nullptr;
+            return false;
+        }
+        gptimer_enable(_timer);
+        gptimer_start(_timer);
+    }
+
+    gpio_config_t trig = {};
+    trig.pin_bit_mask = 1ULL << _trig_pin;
+    trig.mode = GPIO_MODE_OUTPUT;
+    trig.intr_type = GPIO_INTR_DISABLE;
+
+    gpio_config_t echo = {};
+    echo.pin_bit_mask = 1ULL << _echo_pin;
+    echo.mode = GPIO_MODE_INPUT;
+    echo.intr_type = GPIO_INTR_ANYEDGE;
+
+    if((gpio_config(&trig) != ESP_OK) || (gpio_config(&echo) != ESP_OK)) {return false;}
+    gpio_set_level(_trig_pin, 0);
+
+    /* The ISR service may already be installed by another driver (or another sensor) */
+    esp_err_t installed = gpio_install_isr_service(0);
+    if((installed != ESP_OK) && (installed != ESP_ERR_INVALID_STATE)) {return false;}
+
+    return gpio_isr_handler_add(_echo_pin, echo_isr, this) == ESP_OK;
+}
+
+/* Unhooks the echo interrupt */
+void SONIC_IO::end() {
+    if(_echo_pin != GPIO_NUM_NC) {gpio_isr_handler_remove(_echo_pin);}
+    _echo_pin = GPIO_NUM_NC;
+    reset();
+}
+
+/* Checks whether or not new data is available */
+uint8_t SONIC_IO::readingAvailable() {
+    SONIC_TRACE_SCOPE(SONIC_TRACE_IO_POLL);
+    uint64_t now = SONIC_CLOCK::millis64();
+
+    switch(poll(now)) {
+        case SONIC_ACTION_TRIGGER: {
+            /* Trigger a data collection */
+            SONIC_TRACE_SCOPE(SONIC_TRACE_IO_TRIGGER);
+            gpio_set_level(_trig_pin, 1);
+            esp_rom_delay_us(SONIC_IO_TRIG_PULSE_US);
+            gpio_set_level(_trig_pin, 0);
+            triggered(now);
+            break;
+        }
+
+        case SONIC_ACTION_READING:
+            /* Flag that the sensor has data available */
+            return true;
+    }
+
+    /* If we made it here, there isn't any new data */
+    return false;
+}
+
+/* Drives the burst - returns true once it is complete and the result has been written */
+uint8_t SONIC_IO::burstAvailable(SONIC_BURST_RESULT* result) {
+    return readingAvailable() && collect_burst(result);
+}
+
+/* 
+    Private function for the echo pin interrupt (both edges) - the edges go through the core's echo state machine like
+    on the Arduino adapter, timestamped with the low 32 bits of the timer count (the unsigned difference is exact across
+    a wrap, 429s at 10MHz).  Deliberately not IRAM_ATTR: gptimer_get_raw_count(), gpio_get_level() and the core's edge
+    handlers live in flash (unless CONFIG_GPTIMER_CTRL_FUNC_IN_IRAM and
+    CONFIG_GPIO_CTRL_FUNC_IN_IRAM are set, and the core still would), and the handler is registered without
+    ESP_INTR_FLAG_IRAM, so it is simply held off while the flash cache is disabled.
+*/
+void SONIC_IO::echo_isr(void* arg) {
+    SONIC_IO* sensor = (SONIC_IO*)arg;
+    uint64_t count = 0;
+
+    gptimer_get_raw_count(_timer, &count);
+
+    if(gpio_get_level(sensor->_echo_pin)) {
+        SONIC_TRACE_SCOPE(SONIC_TRACE_ECHO_RISING);
+        sensor->echo_rising((uint32_t)count);
+    } else {
+        SONIC_TRACE_SCOPE(SONIC_TRACE_ECHO_FALLING);
+        sensor->echo_falling((uint32_t)count, 1000000000UL / SONIC_IDF_TIMER_HZ);
+    }
+}
+
+#endif
@@ -0,0 +1,85 @@
+/*
+    Native ESP-IDF adapters for the Unit Sonic I2C and IO (no Arduino layer).
+
+    SONIC_I2C talks to the RCWL-9620 through the i2c_master driver.  SONIC_IO installs its own GPIO
+    interrupt on the echo pin and timestamps both edges with a shared 10MHz gptimer, so the pulse is
+    measured to 0.1us instead of the 1us of micros() and no user ISR is needed.
+*/
+#ifndef _UNIT_SONIC_IDF_H_
+    #define _UNIT_SONIC_IDF_H_
+
+    #include "Unit_Sonic_Config.h"
+
+    #if defined(SONIC_PLATFORM_IDF)
+
+        #include "driver/i2c_master.h"
+        #include "driver/gpio.h"
+        #include "driver/gptimer.h"
+        #include "Unit_Sonic_Core.h"
+
+        #define SONIC_IDF_I2C_TIMEOUT_MS 10             //Timeout for a single I2C transaction
+        #define SONIC_IDF_TIMER_HZ 10000000UL           //Resolution of the echo pulse timer (0.1us)
+
+        /* RAM budget of one adapter (32 bit targets / 64 bit hosts), the core's budget plus the device / pins - see SONIC_I2C_CORE_BYTES */
+        #define SONIC_I2C_BYTES ((sizeof(void*) == 4) ? 72 : 88)
+        #define SONIC_IO_BYTES ((sizeof(void*) == 4) ? 72 : 80)
+
+        class SONIC_I2C : public SONIC_I2C_CORE {
+            public:
+                /* Adds the sensor to an already created i2c_master bus - returns whether it was detected or not */
+                uint8_t begin(i2c_master_bus_handle_t bus, uint8_t addr = 0x57, uint32_t speed = 200000L);
+
+                /* Removes the sensor from the bus */
+                void end();
+
+                /* Changes the SCL speed of this device at run time (re-adds it to the bus) - returns whether it was detected */
+                uint8_t setSpeed(uint32_t speed);
+
+                /* 
+                    Checks whether or not new data is available - this should be polled in the user's loop.  Once the function
+                    returns true --> the user should get the new data by calling the respective getDistance() or getDistance_uint16()
+                */
+                uint8_t readingAvailable();
+
+                /* Drives the burst started by startBurst() - returns true once it is complete and the result has been written */
+                uint8_t burstAvailable(SONIC_BURST_RESULT* result);
+
+            private:
+                /* Private variable for the i2c_master device of this sensor */
+                i2c_master_dev_handle_t _dev = nullptr;
+                i2c_master_bus_handle_t _bus = nullptr;
+                uint8_t _addr = 0x57;
+        };
+
+        class SONIC_IO : public SONIC_IO_CORE {
+            public:
+                /* Configures the pins and hooks the echo interrupt - returns false if a driver call failed */
+                uint8_t begin(gpio_num_t trig_pin = GPIO_NUM_26, gpio_num_t echo_pin = GPIO_NUM_32);
+
+                /* Unhooks the echo interrupt */
+                void end();
+
+                /* 
+                    Checks whether or not new data is available - this should be polled in the user's loop.  Once the function
+                    returns true --> the user should get the new data by calling the respective getDistance() or getDistance_uint16()
+                */
+                uint8_t readingAvailable();
+
+                /* Drives the burst started by startBurst() - returns true once it is complete and the result has been written */
+                uint8_t burstAvailable(SONIC_BURST_RESULT* result);
+
+            private:
+                /* Private function for the echo pin interrupt (both edges) */
+                static void echo_isr(void* arg);
+
+                /* Private variable for the free running timer shared by every SONIC_IO */
+                static gptimer_handle_t _timer;
+
+                /* Private variables to keep track of pin settings */
+                gpio_num_t _trig_pin = GPIO_NUM_NC;
+                gpio_num_t _echo_pin = GPIO_NUM_NC;
+        };
+
+    #endif
+
+#endif
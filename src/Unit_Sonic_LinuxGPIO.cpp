@@ -0,0 +1,196 @@
+#include "Unit_Sonic_LinuxGPIO.h"
+
+#if defined(SONIC_PLATFORM_LINUX) && defined(SONIC_HAVE_GPIOD)
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include <gpiod.h>
+#include "Unit_Sonic_Clock.h"
+
+SONIC_IO_LINUX::~SONIC_IO_LINUX() {
+    end();
+}
+
+/* Requests the trigger (output) and echo (input, both edges) lines */
+uint8_t SONIC_IO_LINUX::begin(const char* chip, unsigned int trig_offset, unsigned int echo_offset) {
+    end();
+
+    _trig_offset = trig_offset;
+    _echo_offset = echo_offset;
+
+    _chip = gpiod_chip_open(chip);
+    _timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    _events = gpiod_edge_event_buffer_new(SONIC_IO_LINUX_EVENT_BUFFER);
+    if(!_chip || (_timer_fd < 0) || !_events) {
+        end();
+        return false;
+    }
+
+    struct gpiod_line_settings* trig = gpiod_line_settings_new();
+    struct gpiod_line_settings* echo = gpiod_line_settings_new();
+    struct gpiod_line_config* lines = gpiod_line_config_new();
+    struct gpiod_request_config* config = gpiod_request_config_new();
+
+    if(trig && echo && lines && config) {
+        gpiod_line_settings_set_direction(trig, GPIOD_LINE_DIRECTION_OUTPUT);
+        gpiod_line_settings_set_output_value(trig, GPIOD_LINE_VALUE_INACTIVE);
+
+        /* Timestamp the edges on CLOCK_MONOTONIC so they can be compared against the trigger time */
+        gpiod_line_settings_set_direction(echo, GPIOD_LINE_DIRECTION_INPUT);
+        gpiod_line_settings_set_edge_detection(echo, GPIOD_LINE_EDGE_BOTH);
+        gpiod_line_settings_set_event_clock(echo, GPIOD_LINE_CLOCK_MONOTONIC);
+
+        gpiod_line_config_add_line_settings(lines, &_trig_offset, 1, trig);
+        gpiod_line_config_add_line_settings(lines, &_echo_offset, 1, echo);
+        gpiod_request_config_set_consumer(config, "unit-sonic");
+
+        _request = gpiod_chip_request_lines(_chip, config, lines);
+    }
+
+    if(config) {gpiod_request_config_free(config);}
+    if(lines) {gpiod_line_config_free(lines);}
+    if(echo) {gpiod_line_settings_free(echo);}
+    if(trig) {gpiod_line_settings_free(trig);}
+
+    if(!_request) {
+        end();
+        return false;
+    }
+
+    return true;
+}
+
+/* Releases the lines and the timeout timer */
+void SONIC_IO_LINUX::end() {
+    if(_request) {gpiod_line_request_release(_request);}
+    if(_events) {gpiod_edge_event_buffer_free(_events);}
+    if(_chip) {gpiod_chip_close(_chip);}
+    if(_timer_fd >= 0) {close(_timer_fd);}
+
+    _request = nullptr;
+    _events = nullptr;
+    _chip = nullptr;
+    _timer_fd = -1;
+    reset();
+}
+
+/* Checks whether or not new data is available - polled equivalent of trigger()/serviceEdges()/serviceTimeout() */
+uint8_t SONIC_IO_LINUX::readingAvailable() {
+    if(!getStatus()) {
+        /* The core decides when the next ping is allowed (burst gap) */
+        if(poll(SONIC_CLOCK::millis64()) == SONIC_ACTION_TRIGGER) {trigger();}
+        return false;
+    }
+
+    /* Only read the edge events if there are any, the read would block otherwise */
+    struct pollfd pending = {getEventFd(), POLLIN, 0};
+    if((::poll(&pending, 1, 0) > 0) && serviceEdges()) {return true;}
+
+    return serviceTimeout();
+}
+
+/* Drives the burst - returns true once it is complete and the result has been written */
+uint8_t SONIC_IO_LINUX::burstAvailable(SONIC_BURST_RESULT* result) {
+    return readingAvailable() && collect_burst(result);
+}
+
+/* Sends the trigger pulse and arms the timeout timer */
+uint8_t SONIC_IO_LINUX::trigger() {
+    if(!_request) {return false;}
+
+    /* Edges from before this point belong to an older ping */
+    _sensor_trigger_ns = SONIC_CLOCK::nanos64();
+    _sensor_pulse_start = 0;
+
+    /* The pulse is too short to sleep for --> spin on the monotonic clock */
+    gpiod_line_request_set_value(_request, _trig_offset, GPIOD_LINE_VALUE_ACTIVE);
+    while(SONIC_CLOCK::nanos64() - _sensor_trigger_ns < SONIC_IO_TRIG_PULSE_US * 1000ULL) {}
+    gpiod_line_request_set_value(_request, _trig_offset, GPIOD_LINE_VALUE_INACTIVE);
+
+    arm_timer(SONIC_IO_TIMEOUT_MS);
+    triggered(_sensor_trigger_ns / 1000000ULL);
+    return true;
+}
+
+/* Starts the next measurement, or arms the timer for the rest of the hold-off */
+uint8_t SONIC_IO_LINUX::schedule() {
+    if(getStatus()) {return true;}
+    if((poll(SONIC_CLOCK::millis64()) == SONIC_ACTION_TRIGGER) && trigger()) {return true;}
+
+    arm_timer(holdoff(SONIC_CLOCK::millis64()));
+    return false;
+}
+
+/* Reads the pending edge events - returns true if the echo pulse completed a new reading */
+uint8_t SONIC_IO_LINUX::serviceEdges() {
+    int count = gpiod_line_request_read_edge_events(_request, _events, SONIC_IO_LINUX_EVENT_BUFFER);
+    uint8_t reading = false;
+
+    for(int i = 0; i < count; i++) {
+        struct gpiod_edge_event* event = gpiod_edge_event_buffer_get_event(_events, i);
+
+        if(gpiod_edge_event_get_line_offset(event) != _echo_offset) {continue;}
+
+        uint8_t rising = gpiod_edge_event_get_event_type(event) == GPIOD_EDGE_EVENT_RISING_EDGE;
+        reading = edge(rising, gpiod_edge_event_get_timestamp_ns(event)) || reading;
+    }
+
+    return reading;
+}
+
+/* Call when the timeout timer is readable - returns true if the measurement timed out */
+uint8_t SONIC_IO_LINUX::serviceTimeout() {
+    uint64_t expirations;
+
+    if(!getStatus() || (read(_timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))) {return false;}
+
+    /* The object is too far away to measure - unless the range gate drops that reading */
+    _sensor_pulse_start = 0;
+    return expire(SONIC_CLOCK::millis64());
+}
+
+/* Handles one echo edge - returns true if it completed a reading */
+uint8_t SONIC_IO_LINUX::edge(uint8_t rising, uint64_t timestamp_ns) {
+    if(!getStatus() || (timestamp_ns < _sensor_trigger_ns)) {return false;}
+
+    if(rising) {
+        _sensor_pulse_start = timestamp_ns;
+        return false;
+    }
+
+    /* A falling edge without a rising edge of this ping is ignored */
+    if(!_sensor_pulse_start) {return false;}
+
+    /* Hand the kernel measured pulse width to the core and let it collect the reading */
+    echo_pulse((uint32_t)(timestamp_ns - _sensor_pulse_start));
+    _sensor_pulse_start = 0;
+    disarm_timer();
+
+    return poll(SONIC_CLOCK::millis64()) == SONIC_ACTION_READING;
+}
+
+/* Private function to arm the timer (one-shot) */
+void SONIC_IO_LINUX::arm_timer(uint32_t ms) {
+    struct itimerspec timeout = {};
+
+    /* A zero it_value would disarm the timer */
+    if(!ms) {ms = 1;}
+
+    timeout.it_value.tv_sec = ms / 1000;
+    timeout.it_value.tv_nsec = (long)(ms % 1000) * 1000000L;
+    timerfd_settime(_timer_fd, 0, &timeout, nullptr);
+}
+
+/* Private function to disarm the timeout timer once the measurement is over */
+void SONIC_IO_LINUX::disarm_timer() {
+    struct itimerspec disarm = {};
+    timerfd_settime(_timer_fd, 0, &disarm, nullptr);
+}
+
+/* Gets the file descriptors for epoll/poll */
+int SONIC_IO_LINUX::getEventFd() {return _request ? gpiod_line_request_get_fd(_request) : -1;}
+int SONIC_IO_LINUX::getTimerFd() {return _timer_fd;}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+    Linux GPIO character device (libgpiod v2) backend for the Unit Sonic IO.
+
+    The echo pulse is measured from the kernel's edge event timestamps instead of micros() in an ISR,
+    which takes the scheduling jitter of userspace out of the reading.  The edge events and the timeout
+    each have a file descriptor that can be added to an epoll set, so one thread can service many
+    sensors: call trigger() to start a measurement, serviceEdges() when getEventFd() is readable and
+    serviceTimeout() when getTimerFd() is readable.
+
+    Requires libgpiod v2 - define SONIC_HAVE_GPIOD and link against libgpiod to build it.
+*/
+#ifndef _UNIT_SONIC_LINUX_GPIO_H_
+    #define _UNIT_SONIC_LINUX_GPIO_H_
+
+    #include "Unit_Sonic_Config.h"
+
+    #if defined(SONIC_PLATFORM_LINUX) && defined(SONIC_HAVE_GPIOD)
+
+        #include "Unit_Sonic_Core.h"
+
+        #define SONIC_IO_LINUX_EVENT_BUFFER 8   //Edge events read from the kernel per call
+
+        struct gpiod_chip;
+        struct gpiod_line_request;
+        struct gpiod_edge_event_buffer;
+
+        class SONIC_IO_LINUX : public SONIC_IO_CORE {
+            public:
+                virtual ~SONIC_IO_LINUX();
+
+                /* Requests the trigger (output) and echo (input, both edges) lines - returns false on failure */
+                uint8_t begin(const char* chip, unsigned int trig_offset, unsigned int echo_offset);
+
+                /* Releases the lines and the timeout timer */
+                void end();
+
+                /* 
+                    Checks whether or not new data is available - this can be polled in the user's loop exactly like
+                    SONIC_IO::readingAvailable().  Event driven users call trigger()/serviceEdges()/serviceTimeout().
+                */
+                uint8_t readingAvailable();
+
+                /* Drives the burst started by startBurst() - returns true once it is complete and the result has been written */
+                uint8_t burstAvailable(SONIC_BURST_RESULT* result);
+
+                /* Sends the trigger pulse and arms the timeout timer */
+                uint8_t trigger();
+
+                /* 
+                    Starts the next measurement once the core allows it (interval, burst gap) - otherwise arms the timer for
+                    the rest of the hold-off, so getTimerFd() becomes readable when it is time to call this again.  Returns
+                    true if a measurement is running.
+                */
+                uint8_t schedule();
+
+                /* Call when getEventFd() is readable - returns true if the echo pulse completed a new reading */
+                uint8_t serviceEdges();
+
+                /* 
+                    Call when getTimerFd() is readable - returns true if the measurement timed out and the max distance
+                    reading passed the range gate
+                */
+                uint8_t serviceTimeout();
+
+                /* Gets the file descriptors for epoll/poll */
+                int getEventFd();
+                int getTimerFd();
+
+            protected:
+                /* 
+                    Handles one echo edge (CLOCK_MONOTONIC timestamp in ns) - returns true if it completed a reading.
+                    serviceEdges() feeds the kernel events through here, fakes can call it directly.
+                */
+                uint8_t edge(uint8_t rising, uint64_t timestamp_ns);
+
+            private:
+                /* Private functions to arm (one-shot) / disarm the timer */
+                void arm_timer(uint32_t ms);
+                void disarm_timer();
+
+                /* Private variables for the GPIO lines and the timeout timer */
+                struct gpiod_chip* _chip = nullptr;
+                struct gpiod_line_request* _request = nullptr;
+                struct gpiod_edge_event_buffer* _events = nullptr;
+                unsigned int _trig_offset = 0;
+                unsigned int _echo_offset = 0;
+                int _timer_fd = -1;
+
+                /* Private variables for tracking the echo pulse */
+                uint64_t _sensor_trigger_ns = 0;
+                uint64_t _sensor_pulse_start = 0;
+        };
+
+    #endif
+
+#endif
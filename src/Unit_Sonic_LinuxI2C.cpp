@@ -0,0 +1,140 @@
+#include "Unit_Sonic_LinuxI2C.h"
+
+#if defined(SONIC_PLATFORM_LINUX)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <linux/i2c-dev.h>
+#include "Unit_Sonic_Clock.h"
+
+SONIC_I2C_LINUX::~SONIC_I2C_LINUX() {
+    end();
+}
+
+/* Opens the i2c-dev bus and the conversion timer - returns whether the sensor was detected or not */
+uint8_t SONIC_I2C_LINUX::begin(const char* device, uint8_t addr) {
+    end();
+
+    _addr = addr;
+
+    if(device) {
+        _fd = open(device, O_RDWR | O_CLOEXEC);
+        if(_fd < 0) {return false;}
+    }
+
+    _timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if(_timer_fd < 0) {
+        end();
+        return false;
+    }
+
+    /* Verify that a sensor was detected (zero length write --> ACK/NAK of the address) */
+    struct i2c_msg probe = {_addr, 0, 0, nullptr};
+    return transfer(&probe, 1) == 1;
+}
+
+/* Closes the bus and the conversion timer */
+void SONIC_I2C_LINUX::end() {
+    if(_fd >= 0) {close(_fd);}
+    if(_timer_fd >= 0) {close(_timer_fd);}
+    _fd = -1;
+    _timer_fd = -1;
+    reset();
+}
+
+/* Checks whether or not new data is available - polled equivalent of trigger()/service() */
+uint8_t SONIC_I2C_LINUX::readingAvailable() {
+    if(!getStatus()) {
+        /* The core holds the trigger off for the interval, or after a NAKed trigger */
+        if(poll(SONIC_CLOCK::millis64()) == SONIC_ACTION_TRIGGER) {trigger();}
+        return false;
+    }
+
+    return service();
+}
+
+/* Drives the burst - returns true once it is complete and the result has been written */
+uint8_t SONIC_I2C_LINUX::burstAvailable(SONIC_BURST_RESULT* result) {
+    return readingAvailable() && collect_burst(result);
+}
+
+/* Sends the trigger to the chip and arms the conversion timer */
+uint8_t SONIC_I2C_LINUX::trigger() {
+    uint8_t command = 0x01;
+    struct i2c_msg msg = {_addr, 0, 1, &command};
+
+    if(transfer(&msg, 1) != 1) {
+        trigger_failed(SONIC_CLOCK::millis64());
+        return false;
+    }
+
+    /* The core picks the conversion time for the band of the last reading */
+    triggered(SONIC_CLOCK::millis64());
+    arm_timer(getWait());
+
+    return true;
+}
+
+/* Starts the next measurement, or arms the timer for the rest of the hold-off */
+uint8_t SONIC_I2C_LINUX::schedule() {
+    if(getStatus()) {return true;}
+    if((poll(SONIC_CLOCK::millis64()) == SONIC_ACTION_TRIGGER) && trigger()) {return true;}
+
+    arm_timer(holdoff(SONIC_CLOCK::millis64()));
+    return false;
+}
+
+/* Reads the conversion result once the conversion timer has expired */
+uint8_t SONIC_I2C_LINUX::service() {
+    uint64_t expirations;
+
+    /* Non-blocking read --> EAGAIN until the conversion time has passed */
+    if(!getStatus() || (read(_timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))) {return false;}
+
+    uint8_t data[3];
+    struct i2c_msg msg = {_addr, I2C_M_RD, sizeof(data), data};
+    uint8_t waited = getWait();
+    uint8_t length = (transfer(&msg, 1) == 1) ? sizeof(data) : 0;
+
+    if(received(data, length, SONIC_CLOCK::millis64())) {return true;}
+
+    /* The core fell back to the full conversion time --> wait for the rest of it */
+    if(getStatus()) {arm_timer(getWait() - waited);}
+
+    return false;
+}
+
+/* Gets the timerfd that becomes readable once the conversion is complete */
+int SONIC_I2C_LINUX::getTimerFd() {return _timer_fd;}
+
+/* Performs an I2C_RDWR combined transaction */
+int SONIC_I2C_LINUX::transfer(struct i2c_msg* msgs, uint32_t count) {
+    struct i2c_rdwr_ioctl_data transaction = {msgs, count};
+
+    if(_fd < 0) {return -1;}
+
+    int result;
+    do {
+        result = ioctl(_fd, I2C_RDWR, &transaction);
+    } while((result < 0) && (errno == EINTR));
+
+    return result;
+}
+
+/* Private function to arm the conversion timer (one-shot) */
+void SONIC_I2C_LINUX::arm_timer(uint32_t ms) {
+    struct itimerspec timeout = {};
+
+    /* A zero it_value would disarm the timer */
+    if(!ms) {ms = 1;}
+
+    timeout.it_value.tv_sec = ms / 1000;
+    timeout.it_value.tv_nsec = (long)(ms % 1000) * 1000000L;
+    timerfd_settime(_timer_fd, 0, &timeout, nullptr);
+}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+    Linux i2c-dev backend for the Unit Sonic I2C (RCWL-9620).
+
+    Implements the same trigger --> wait --> read protocol as SONIC_I2C::readingAvailable(), but talks to
+    /dev/i2c-N through I2C_RDWR ioctls and waits for the conversion on a timerfd instead of polling
+    millis().  The timerfd can be added to an epoll set, so one thread can service many sensors:
+    call trigger() to start a measurement and service() whenever getTimerFd() becomes readable.
+*/
+#ifndef _UNIT_SONIC_LINUX_I2C_H_
+    #define _UNIT_SONIC_LINUX_I2C_H_
+
+    #include "Unit_Sonic_Config.h"
+
+    #if defined(SONIC_PLATFORM_LINUX)
+
+        #include <linux/i2c.h>
+        #include "Unit_Sonic_Core.h"
+
+        class SONIC_I2C_LINUX : public SONIC_I2C_CORE {
+            public:
+                SONIC_I2C_LINUX() = default;
+                virtual ~SONIC_I2C_LINUX();
+
+                /* Owns the bus and timer fds - a copy would close them under the original */
+                SONIC_I2C_LINUX(const SONIC_I2C_LINUX&) = delete;
+                SONIC_I2C_LINUX& operator=(const SONIC_I2C_LINUX&) = delete;
+
+                /* 
+                    Opens the i2c-dev bus and the conversion timer - returns whether the sensor was detected or not.
+                    Passing a nullptr device skips opening the bus, for subclasses that override transfer().
+                */
+                uint8_t begin(const char* device = "/dev/i2c-1", uint8_t addr = 0x57);
+
+                /* Closes the bus and the conversion timer */
+                void end();
+
+                /* 
+                    Checks whether or not new data is available - this can be polled in the user's loop exactly like
+                    SONIC_I2C::readingAvailable().  Event driven users call trigger()/service() instead.
+                */
+                uint8_t readingAvailable();
+
+                /* Drives the burst started by startBurst() - returns true once it is complete and the result has been written */
+                uint8_t burstAvailable(SONIC_BURST_RESULT* result);
+
+                /* 
+                    Sends the trigger to the chip and arms the conversion timer - returns false if the chip NAKed (counted as
+                    a miss, readingAvailable() then retries after the full conversion time)
+                */
+                uint8_t trigger();
+
+                /* 
+                    Starts the next measurement once the core allows it (interval, NAK retry delay) - otherwise arms the
+                    timer for the rest of the hold-off, so getTimerFd() becomes readable when it is time to call this again.
+                    Returns true if a measurement is running.
+                */
+                uint8_t schedule();
+
+                /* 
+                    Call when getTimerFd() is readable - reads the conversion result and returns true if a new reading
+                    is available.  Returns false if the timer hasn't expired yet or the chip didn't answer (a NAK after a
+                    calibrated conversion time re-arms the timer for the rest of the full conversion time).
+                */
+                uint8_t service();
+
+                /* Gets the timerfd that becomes readable once the conversion is complete (for epoll/poll) */
+                int getTimerFd();
+
+            protected:
+                /* 
+                    Performs an I2C_RDWR combined transaction - returns the number of messages transferred or -1.
+                    Override this to run the driver against a fake i2c device.
+                */
+                virtual int transfer(struct i2c_msg* msgs, uint32_t count);
+
+                /* Private variable for the I2C address of this sensor */
+                uint8_t _addr = 0x57;
+
+            private:
+                /* Private variables for the bus and the conversion timer */
+                int _fd = -1;
+                int _timer_fd = -1;
+
+                /* Private function to arm the conversion timer */
+                void arm_timer(uint32_t ms);
+        };
+
+    #endif
+
+#endif
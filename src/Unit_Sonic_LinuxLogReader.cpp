@@ -0,0 +1,249 @@
+#include "Unit_Sonic_LinuxLogReader.h"
+
+#if defined(SONIC_PLATFORM_LINUX)
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+/* Private function to add a reading to a summary */
+static inline void sonic_log_aggregate_add(SONIC_LOG_AGGREGATE *aggregate, uint32_t distance_um) {
+    aggregate->count++;
+    aggregate->sum += distance_um;
+    if(distance_um < aggregate->min) {aggregate->min = distance_um;}
+    if(distance_um > aggregate->max) {aggregate->max = distance_um;}
+}
+
+/* Private function to merge two summaries */
+static inline void sonic_log_aggregate_merge(SONIC_LOG_AGGREGATE *into, const SONIC_LOG_AGGREGATE &from) {
+    into->count += from.count;
+    into->sum += from.sum;
+    if(from.min < into->min) {into->min = from.min;}
+    if(from.max > into->max) {into->max = from.max;}
+}
+
+static const SONIC_LOG_AGGREGATE sonic_log_aggregate_empty = {0, 0, UINT32_MAX, 0};
+
+SONIC_LOG_READER::~SONIC_LOG_READER() {close();}
+
+/* Maps a log image and builds the sector index */
+uint8_t SONIC_LOG_READER::open(const char *path) {
+    struct stat info;
+
+    close();
+
+    _fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if((_fd < 0) || fstat(_fd, &info) || (info.st_size < SONIC_LOG_SECTOR)) {
+        close();
+        return false;
+    }
+
+    _size = (size_t)info.st_size;
+    void *data = mmap(nullptr, _size, PROT_READ, MAP_SHARED, _fd, 0);
+    if(data == MAP_FAILED) {
+        close();
+        return false;
+    }
+    _data = (uint8_t *)data;
+    madvise(_data, _size, MADV_SEQUENTIAL);
+
+    /* One index entry per sector with a valid header */
+    for(size_t offset = 0; offset + SONIC_LOG_SECTOR <= _size; offset += SONIC_LOG_SECTOR) {
+        SONIC_LOG_HEADER header;
+        memcpy(&header, &_data[offset], sizeof(header));
+
+        if((header.magic != SONIC_LOG_MAGIC) || (header.crc != SONIC_CODEC::crc16((const uint8_t *)&header, 12))) {continue;}
+        _index.push_back({&_data[offset], header.sequence, header.first_timestamp, 0});
+    }
+
+    if(_index.empty()) {
+        close();
+        return false;
+    }
+
+    /* Put the ring in write order and unwrap the timestamps (sectors only ever move forward in time) */
+    std::sort(_index.begin(), _index.end(), [](const sector_entry &a, const sector_entry &b) {return a.sequence < b.sequence;});
+
+    _index[0].first = _index[0].first_raw;
+    for(size_t i = 1; i < _index.size(); i++) {
+        _index[i].first = _index[i - 1].first + (uint32_t)(_index[i].first_raw - _index[i - 1].first_raw);
+    }
+
+    /* The end of the log is the newest reading of the newest sector */
+    _start = _index[0].first;
+    _end = _index.back().first;
+
+    auto newest = [this](uint8_t sensor, uint32_t distance_um, uint64_t timestamp_ms) {
+        (void)sensor;
+        (void)distance_um;
+        if(timestamp_ms > _end) {_end = timestamp_ms;}
+    };
+    scan_sectors(_index.size() - 1, _index.size(), newest);
+
+    return true;
+}
+
+/* Unmaps the image */
+void SONIC_LOG_READER::close() {
+    if(_data) {munmap(_data, _size);}
+    if(_fd >= 0) {::close(_fd);}
+
+    _data = nullptr;
+    _size = 0;
+    _fd = -1;
+    _index.clear();
+    _start = 0;
+    _end = 0;
+}
+
+/* Calls the callback for every reading within the range */
+uint64_t SONIC_LOG_READER::scan(uint64_t from_ms, uint64_t to_ms, callback_t callback, void *context) const {
+    size_t first, last;
+    uint64_t found = 0;
+
+    find(from_ms, to_ms, &first, &last);
+
+    auto filter = [&](uint8_t sensor, uint32_t distance_um, uint64_t timestamp_ms) {
+        if((timestamp_ms < from_ms) || (timestamp_ms > to_ms)) {return;}
+        found++;
+        if(callback) {callback(sensor, distance_um, timestamp_ms, context);}
+    };
+    scan_sectors(first, last, filter);
+
+    return found;
+}
+
+/* Summarises the readings within the range per sensor and window */
+uint64_t SONIC_LOG_READER::aggregate(uint64_t from_ms, uint64_t to_ms, uint64_t window_ms, unsigned threads, std::vector<SONIC_LOG_AGGREGATE> *result) const {
+    /* Private structure for the share of the sectors summarised by one thread */
+    struct worker {
+        size_t first;
+        size_t last;
+        uint64_t window_first;
+        std::vector<SONIC_LOG_AGGREGATE> windows;
+        std::vector<std::pair<uint64_t, uint32_t>> outside;
+        uint64_t count;
+    };
+
+    result->clear();
+    if((from_ms > to_ms) || _index.empty()) {return 0;}
+    if(!window_ms) {window_ms = (to_ms - from_ms < UINT64_MAX) ? to_ms - from_ms + 1 : UINT64_MAX;}
+
+    /* The result holds every window of the range, so a tiny window over a long range is refused instead of allocated */
+    uint64_t windows = (to_ms - from_ms) / window_ms + 1;
+    if(windows > SONIC_LOG_READER_MAX_WINDOWS) {return 0;}
+    result->assign(windows * SONIC_BATCH_MAX_SENSORS, sonic_log_aggregate_empty);
+
+    size_t first, last;
+    find(from_ms, to_ms, &first, &last);
+    if(first >= last) {return 0;}
+
+    if(!threads) {threads = std::max(1u, std::thread::hardware_concurrency());}
+    if(threads > last - first) {threads = (unsigned)(last - first);}
+
+    /* Every thread takes a contiguous run of sectors and only keeps the windows that run can reach */
+    std::vector<worker> workers(threads);
+    for(unsigned t = 0; t < threads; t++) {
+        worker &share = workers[t];
+        share.first = first + (last - first) * t / threads;
+        share.last = first + (last - first) * (t + 1) / threads;
+        share.count = 0;
+
+        uint64_t begin = std::max(_index[share.first].first, from_ms);
+        uint64_t end = std::min((share.last < _index.size()) ? _index[share.last].first : _end, to_ms);
+        if(end < begin) {end = begin;}
+
+        share.window_first = (begin - from_ms) / window_ms;
+        share.windows.assign(((end - from_ms) / window_ms - share.window_first + 1) * SONIC_BATCH_MAX_SENSORS, sonic_log_aggregate_empty);
+    }
+
+    std::vector<std::thread> pool;
+    for(unsigned t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+            worker &share = workers[t];
+            uint64_t local_windows = share.windows.size() / SONIC_BATCH_MAX_SENSORS;
+
+            auto add = [&](uint8_t sensor, uint32_t distance_um, uint64_t timestamp_ms) {
+                if((timestamp_ms < from_ms) || (timestamp_ms > to_ms)) {return;}
+
+                uint64_t window = (timestamp_ms - from_ms) / window_ms;
+                share.count++;
+
+                /* Readings slightly out of the expected windows (out of order sensors) are merged at the end */
+                if((window < share.window_first) || (window - share.window_first >= local_windows)) {
+                    share.outside.push_back(std::make_pair(window * SONIC_BATCH_MAX_SENSORS + sensor, distance_um));
+                    return;
+                }
+                sonic_log_aggregate_add(&share.windows[(window - share.window_first) * SONIC_BATCH_MAX_SENSORS + sensor], distance_um);
+            };
+            scan_sectors(share.first, share.last, add);
+        });
+    }
+
+    uint64_t count = 0;
+    for(unsigned t = 0; t < threads; t++) {
+        worker &share = workers[t];
+        pool[t].join();
+
+        size_t offset = share.window_first * SONIC_BATCH_MAX_SENSORS;
+        for(size_t i = 0; i < share.windows.size(); i++) {
+            if(share.windows[i].count) {sonic_log_aggregate_merge(&(*result)[offset + i], share.windows[i]);}
+        }
+        for(const auto &reading : share.outside) {sonic_log_aggregate_add(&(*result)[reading.first], reading.second);}
+        count += share.count;
+    }
+
+    return count;
+}
+
+/* Private function to find the index positions [first, last) that can hold readings of the range */
+void SONIC_LOG_READER::find(uint64_t from_ms, uint64_t to_ms, size_t *first, size_t *last) const {
+    auto starts_after = [](uint64_t timestamp, const sector_entry &entry) {return timestamp < entry.first;};
+
+    /* The last sector starting at or before the range (one more in front for readings logged out of order) */
+    size_t start = std::upper_bound(_index.begin(), _index.end(), from_ms, starts_after) - _index.begin();
+    *first = (start > 1) ? start - 2 : 0;
+    *last = std::upper_bound(_index.begin(), _index.end(), to_ms, starts_after) - _index.begin();
+}
+
+/* Private function to decode every valid record of the sectors [first, last) */
+template <typename FN>
+void SONIC_LOG_READER::scan_sectors(size_t first, size_t last, FN &fn) const {
+    /* Private structure to unwrap the timestamps of one sector on the way out of SONIC_BATCH::decode() */
+    struct unwrap {
+        FN *fn;
+        uint64_t first;
+        uint32_t first_raw;
+
+        static void call(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms, void *context) {
+            unwrap *self = (unwrap *)context;
+            (*self->fn)(sensor, distance_um, self->first + (int64_t)(int32_t)(timestamp_ms - self->first_raw));
+        }
+    };
+
+    for(size_t i = first; i < last; i++) {
+        const uint8_t *sector = _index[i].data;
+        unwrap context = {&fn, _index[i].first, _index[i].first_raw};
+
+        for(uint32_t offset = SONIC_LOG_SECTOR_HEADER; offset + SONIC_LOG_RECORD_HEADER <= SONIC_LOG_SECTOR; ) {
+            const uint8_t *record = &sector[offset];
+            uint16_t length = record[0] | ((uint16_t)record[1] << 8);
+            uint16_t crc = record[2] | ((uint16_t)record[3] << 8);
+
+            /* Erased flash ends the sector, anything that doesn't fit is garbage */
+            if(!length || (length == 0xFFFF) || (offset + SONIC_LOG_RECORD_HEADER + length > SONIC_LOG_SECTOR)) {break;}
+
+            if(SONIC_CODEC::crc16Table(&record[SONIC_LOG_RECORD_HEADER], length) == crc) {
+                SONIC_BATCH::decode(&record[SONIC_LOG_RECORD_HEADER], length, &unwrap::call, &context);
+            }
+            offset += SONIC_LOG_RECORD_HEADER + length;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,96 @@
+/*
+    Memory mapped reader for SONIC_LOG images on a Linux host (a partition dump or a host build log file).
+
+    open() maps the file read only and builds a sparse time index with one entry per sector (taken from the
+    sector headers, so only 16 bytes per 4KB are touched).  Sectors are put in sequence order and their
+    32 bit ms timestamps are unwrapped onto a 64 bit time line starting at the first logged timestamp, so a
+    log spanning several millis() wraps still queries correctly.  aggregate() splits the sectors of the
+    requested range across threads and summarises every sensor per time window.
+*/
+#ifndef _UNIT_SONIC_LINUX_LOG_READER_H_
+    #define _UNIT_SONIC_LINUX_LOG_READER_H_
+
+    #include "Unit_Sonic_Config.h"
+
+    #if defined(SONIC_PLATFORM_LINUX)
+
+        #include <stddef.h>
+        #include <vector>
+        #include "Unit_Sonic_Log.h"
+
+        #define SONIC_LOG_READER_MAX_WINDOWS 65536      //Windows aggregate() summarises at once (~48MB of results)
+
+        /* Summary of one sensor in one time window */
+        struct SONIC_LOG_AGGREGATE {
+            uint64_t count;
+            uint64_t sum;
+            uint32_t min;
+            uint32_t max;
+
+            double mean() const {return count ? (double)sum / count : 0.0;}
+        };
+
+        class SONIC_LOG_READER {
+            public:
+                /* Signature of the scan callback (timestamp on the unwrapped 64 bit time line) */
+                typedef void (*callback_t)(uint8_t sensor, uint32_t distance_um, uint64_t timestamp_ms, void *context);
+
+                SONIC_LOG_READER() = default;
+                ~SONIC_LOG_READER();
+
+                /* Owns the mapping and the fd - a copy would unmap and close them under the original */
+                SONIC_LOG_READER(const SONIC_LOG_READER&) = delete;
+                SONIC_LOG_READER& operator=(const SONIC_LOG_READER&) = delete;
+
+                /* Maps a log image and builds the sector index - returns false if it can't be read or holds no data */
+                uint8_t open(const char *path);
+
+                /* Unmaps the image */
+                void close();
+
+                /* Gets the time range covered by the log (unwrapped ms) and the number of sectors holding data */
+                uint64_t getStart() const {return _start;}
+                uint64_t getEnd() const {return _end;}
+                uint32_t getSectors() const {return (uint32_t)_index.size();}
+
+                /* Calls the callback for every reading with from_ms <= timestamp <= to_ms, in log order - returns how many */
+                uint64_t scan(uint64_t from_ms, uint64_t to_ms, callback_t callback, void *context = nullptr) const;
+
+                /*
+                    Summarises the readings with from_ms <= timestamp <= to_ms per sensor and per window_ms window, using up
+                    to threads threads (0 = one per core).  The result holds one entry per window and sensor, at
+                    [window * SONIC_BATCH_MAX_SENSORS + sensor] (window 0 starts at from_ms).  Returns the readings summarised,
+                    or 0 with an empty result if the range holds more than SONIC_LOG_READER_MAX_WINDOWS windows.
+                */
+                uint64_t aggregate(uint64_t from_ms, uint64_t to_ms, uint64_t window_ms, unsigned threads, std::vector<SONIC_LOG_AGGREGATE> *result) const;
+
+            private:
+                /* Private structure for one entry of the sparse time index */
+                struct sector_entry {
+                    const uint8_t *data;
+                    uint32_t sequence;
+                    uint32_t first_raw;
+                    uint64_t first;
+                };
+
+                /* Private function to find the index positions [first, last) that can hold readings of the range */
+                void find(uint64_t from_ms, uint64_t to_ms, size_t *first, size_t *last) const;
+
+                /* Private function to decode every valid record of the sectors [first, last) - fn(sensor, distance_um, timestamp_ms) */
+                template <typename FN>
+                void scan_sectors(size_t first, size_t last, FN &fn) const;
+
+                /* Private variables for the mapping */
+                int _fd = -1;
+                uint8_t *_data = nullptr;
+                size_t _size = 0;
+
+                /* Private variables for the index */
+                std::vector<sector_entry> _index;
+                uint64_t _start = 0;
+                uint64_t _end = 0;
+        };
+
+    #endif
+
+#endif
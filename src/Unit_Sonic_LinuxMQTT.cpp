@@ -0,0 +1,208 @@
+#include "Unit_Sonic_LinuxMQTT.h"
+
+#if defined(SONIC_PLATFORM_LINUX)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "Unit_Sonic_Clock.h"
+
+#define SONIC_MQTT_CONNECT 0x10
+#define SONIC_MQTT_CONNACK 0x20
+#define SONIC_MQTT_PUBLISH 0x30
+#define SONIC_MQTT_PINGREQ 0xC0
+#define SONIC_MQTT_DISCONNECT 0xE0
+
+/* Private function to append a length prefixed MQTT string - returns the bytes written */
+static uint32_t sonic_mqtt_string(uint8_t* out, const char* text) {
+    uint32_t length = (uint32_t)strlen(text);
+    out[0] = (uint8_t)(length >> 8);
+    out[1] = (uint8_t)length;
+    memcpy(&out[2], text, length);
+    return length + 2;
+}
+
+SONIC_MQTT_LINUX::~SONIC_MQTT_LINUX() {
+    end();
+}
+
+/* Connects to the broker and waits for its CONNACK */
+uint8_t SONIC_MQTT_LINUX::begin(const char* host, uint16_t port, const char* client_id, uint16_t keepalive_s,
+                                const char* user, const char* password, uint32_t timeout_ms) {
+    struct addrinfo hints;
+    struct addrinfo* found = nullptr;
+    char port_text[8];
+
+    end();
+
+    if((strlen(client_id) > 256) || (user && (strlen(user) > 256)) || (password && (strlen(password) > 256))) {return false;}
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port_text, sizeof(port_text), "%u", port);
+    if(getaddrinfo(host, port_text, &hints, &found)) {return false;}
+
+    for(struct addrinfo* address = found; address && (_fd < 0); address = address->ai_next) {
+        _fd = socket(address->ai_family, address->ai_socktype | SOCK_CLOEXEC, address->ai_protocol);
+        if(_fd < 0) {continue;}
+
+        if(connect(_fd, address->ai_addr, address->ai_addrlen)) {
+            close(_fd);
+            _fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    if(_fd < 0) {return false;}
+
+    int one = 1;
+    setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL) | O_NONBLOCK);
+
+    /* CONNECT: protocol "MQTT" level 4, clean session, keep alive, client id [, user [, password]] */
+    uint8_t header[10 + 3 * (2 + 256)];
+    uint32_t length = sonic_mqtt_string(header, "MQTT");
+    header[length++] = 4;
+    header[length++] = 0x02 | (user ? 0x80 : 0) | ((user && password) ? 0x40 : 0);
+    header[length++] = (uint8_t)(keepalive_s >> 8);
+    header[length++] = (uint8_t)keepalive_s;
+    length += sonic_mqtt_string(&header[length], client_id);
+    if(user) {length += sonic_mqtt_string(&header[length], user);}
+    if(user && password) {length += sonic_mqtt_string(&header[length], password);}
+
+    _keepalive = keepalive_s;
+    _sent_ms = SONIC_CLOCK::millis64();
+    _queued = 0;
+    if(!queue(SONIC_MQTT_CONNECT, header, length, nullptr, 0)) {
+        end();
+        return false;
+    }
+
+    /* Wait for the CONNACK (fixed header + flags + return code 0) */
+    uint8_t ack[4];
+    uint32_t received = 0;
+    uint64_t started = SONIC_CLOCK::millis64();
+
+    while(received < sizeof(ack)) {
+        uint32_t elapsed = (uint32_t)(SONIC_CLOCK::millis64() - started);
+        struct pollfd wait = {_fd, (short)(POLLIN | (_queued ? POLLOUT : 0)), 0};
+
+        if((elapsed >= timeout_ms) || (poll(&wait, 1, (int)(timeout_ms - elapsed)) < 0)) {break;}
+        if(_queued && !flush()) {break;}
+
+        ssize_t got = recv(_fd, &ack[received], sizeof(ack) - received, MSG_DONTWAIT);
+        if(got == 0) {break;}
+        if(got > 0) {received += (uint32_t)got;}
+        if((got < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {break;}
+    }
+
+    if((received < sizeof(ack)) || (ack[0] != SONIC_MQTT_CONNACK) || (ack[1] != 2) || ack[3]) {
+        end();
+        return false;
+    }
+
+    return true;
+}
+
+/* Sends a DISCONNECT (if possible) and closes the socket */
+void SONIC_MQTT_LINUX::end() {
+    if(_fd < 0) {return;}
+
+    if(queue(SONIC_MQTT_DISCONNECT, nullptr, 0, nullptr, 0)) {flush();}
+    close(_fd);
+    _fd = -1;
+    _queued = 0;
+}
+
+/* Queues a QoS 0 message */
+uint8_t SONIC_MQTT_LINUX::publish(const char* topic, const uint8_t* payload, unsigned int length) {
+    uint8_t name[2 + 256];
+
+    if((_fd < 0) || (strlen(topic) > 256)) {return false;}
+
+    uint32_t name_length = sonic_mqtt_string(name, topic);
+    uint8_t ok = queue(SONIC_MQTT_PUBLISH, name, name_length, payload, length);
+
+    /* Push it out right away (and keep the connection alive while it's at it) */
+    return service() && ok;
+}
+
+/* Writes queued packets, reads incoming ones and keeps the connection alive */
+uint8_t SONIC_MQTT_LINUX::service() {
+    if(_fd < 0) {return false;}
+
+    /* Incoming packets carry nothing a QoS 0 publisher needs */
+    uint8_t drop[256];
+    for(;;) {
+        ssize_t got = recv(_fd, drop, sizeof(drop), MSG_DONTWAIT);
+        if(got > 0) {continue;}
+        if((got == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+            close(_fd);
+            _fd = -1;
+            _queued = 0;
+            return false;
+        }
+        break;
+    }
+
+    /* Keep alive - a PINGREQ once half the interval passed without sending anything */
+    if(_keepalive && !_queued && ((SONIC_CLOCK::millis64() - _sent_ms) >= (uint64_t)_keepalive * 500)) {queue(SONIC_MQTT_PINGREQ, nullptr, 0, nullptr, 0);}
+
+    return flush();
+}
+
+/* Private function to write as much of the queued packets as the socket takes */
+uint8_t SONIC_MQTT_LINUX::flush() {
+    while(_queued) {
+        ssize_t sent = send(_fd, _buffer, _queued, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if(sent < 0) {
+            if((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) {break;}
+            close(_fd);
+            _fd = -1;
+            _queued = 0;
+            return false;
+        }
+
+        _queued -= (uint32_t)sent;
+        memmove(_buffer, &_buffer[sent], _queued);
+        _sent_ms = SONIC_CLOCK::millis64();
+    }
+
+    return true;
+}
+
+/* Private function to queue a packet */
+uint8_t SONIC_MQTT_LINUX::queue(uint8_t type, const uint8_t* first, uint32_t first_length, const uint8_t* second, uint32_t second_length) {
+    uint32_t remaining = first_length + second_length;
+    uint8_t header[5] = {type};
+    uint32_t header_length = 1;
+
+    /* Remaining length, 7 bits per byte */
+    do {
+        header[header_length] = (uint8_t)(remaining & 0x7F);
+        remaining >>= 7;
+        if(remaining) {header[header_length] |= 0x80;}
+        header_length++;
+    } while(remaining && (header_length < sizeof(header)));
+
+    if(_queued + header_length + first_length + second_length > sizeof(_buffer)) {return false;}
+
+    memcpy(&_buffer[_queued], header, header_length);
+    _queued += header_length;
+    if(first_length) {memcpy(&_buffer[_queued], first, first_length);}
+    _queued += first_length;
+    if(second_length) {memcpy(&_buffer[_queued], second, second_length);}
+    _queued += second_length;
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+    Minimal non-blocking MQTT 3.1.1 client for Linux gateways, as a transport for SONIC_PUBLISHER.
+
+    Only what a sensor gateway needs: connect (clean session, optional user/password), QoS 0 publish,
+    keep alive and disconnect.  Messages are queued in a fixed TX buffer and written whenever the socket
+    takes them; publish() refuses a message that doesn't fit, which is the backpressure SONIC_PUBLISHER
+    reacts to.  Incoming packets (CONNACK, PINGRESP) are read and dropped.  The socket can be added to an
+    epoll set (see SONIC_LINUX_REACTOR) - call service() when it is readable or writable, or just every loop.
+*/
+#ifndef _UNIT_SONIC_LINUX_MQTT_H_
+    #define _UNIT_SONIC_LINUX_MQTT_H_
+
+    #include "Unit_Sonic_Config.h"
+
+    #if defined(SONIC_PLATFORM_LINUX)
+
+        #include <stdint.h>
+
+        #ifndef SONIC_MQTT_LINUX_BUFFER
+            #define SONIC_MQTT_LINUX_BUFFER 8192        //Bytes of queued packets
+        #endif
+
+        class SONIC_MQTT_LINUX {
+            public:
+                SONIC_MQTT_LINUX() = default;
+                ~SONIC_MQTT_LINUX();
+
+                /* Owns the socket and the TX queue - a copy would close the socket under the original */
+                SONIC_MQTT_LINUX(const SONIC_MQTT_LINUX&) = delete;
+                SONIC_MQTT_LINUX& operator=(const SONIC_MQTT_LINUX&) = delete;
+
+                /*
+                    Connects to the broker and waits up to timeout_ms for its CONNACK - returns false if the broker can't
+                    be reached or refuses the connection (or a string is longer than 256 bytes).  The socket is
+                    non-blocking afterwards.
+                */
+                uint8_t begin(const char* host, uint16_t port = 1883, const char* client_id = "unit-sonic", uint16_t keepalive_s = 30,
+                              const char* user = nullptr, const char* password = nullptr, uint32_t timeout_ms = 3000);
+
+                /* Sends a DISCONNECT (if possible) and closes the socket */
+                void end();
+
+                /* Queues a QoS 0 message - returns false if it doesn't fit into the TX buffer or the connection is lost */
+                uint8_t publish(const char* topic, const uint8_t* payload, unsigned int length);
+
+                /* Writes queued packets, reads incoming ones and keeps the connection alive - returns false once it is lost */
+                uint8_t service();
+
+                /* Gets whether the connection is up, the socket (for epoll/poll) and the bytes still queued */
+                uint8_t connected() const {return _fd >= 0;}
+                int getFd() const {return _fd;}
+                uint32_t getQueued() const {return _queued;}
+
+            private:
+                /* Private function to write as much of the queued packets as the socket takes - returns false once the connection is lost */
+                uint8_t flush();
+
+                /* Private function to queue a packet (fixed header type, variable header + payload in two parts) */
+                uint8_t queue(uint8_t type, const uint8_t* first, uint32_t first_length, const uint8_t* second, uint32_t second_length);
+
+                /* Private variables for the connection */
+                int _fd = -1;
+                uint16_t _keepalive = 0;
+                uint64_t _sent_ms = 0;
+
+                /* Private variables for the TX queue */
+                uint8_t _buffer[SONIC_MQTT_LINUX_BUFFER];
+                uint32_t _queued = 0;
+        };
+
+    #endif
+
+#endif
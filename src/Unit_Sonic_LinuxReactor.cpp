@@ -0,0 +1,135 @@
+#include "Unit_Sonic_LinuxReactor.h"
+
+#if defined(SONIC_PLATFORM_LINUX)
+
+#include <unistd.h>
+#include <sys/epoll.h>
+
+/* The epoll data carries the sensor id and which of its fds fired */
+#define SONIC_REACTOR_TAG(id, edges) (((uint64_t)(id) << 1) | ((edges) ? 1 : 0))
+#define SONIC_REACTOR_ID(tag) ((int)((tag) >> 1))
+#define SONIC_REACTOR_EDGES(tag) ((tag) & 1)
+
+SONIC_LINUX_REACTOR::~SONIC_LINUX_REACTOR() {
+    end();
+}
+
+/* Creates the epoll set */
+uint8_t SONIC_LINUX_REACTOR::begin() {
+    end();
+    _epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return _epoll_fd >= 0;
+}
+
+/* Closes the epoll set */
+void SONIC_LINUX_REACTOR::end() {
+    if(_epoll_fd >= 0) {close(_epoll_fd);}
+    _epoll_fd = -1;
+    _sources.clear();
+}
+
+/* Registers an I2C sensor and starts its first measurement */
+int SONIC_LINUX_REACTOR::add(SONIC_I2C_LINUX *sensor) {
+    source entry = {};
+    entry.i2c = sensor;
+
+    int id = (int)_sources.size();
+    if(!watch(sensor->getTimerFd(), id, false)) {return -1;}
+
+    _sources.push_back(entry);
+    schedule(id);
+    return id;
+}
+
+#if defined(SONIC_HAVE_GPIOD)
+/* Registers an IO sensor and starts its first measurement */
+int SONIC_LINUX_REACTOR::add(SONIC_IO_LINUX *sensor) {
+    source entry = {};
+    entry.io = sensor;
+
+    int id = (int)_sources.size();
+    if(!watch(sensor->getTimerFd(), id, false)) {return -1;}
+    if(!watch(sensor->getEventFd(), id, true)) {
+        epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, sensor->getTimerFd(), nullptr);
+        return -1;
+    }
+
+    _sources.push_back(entry);
+    schedule(id);
+    return id;
+}
+#endif
+
+/* Registers the callback that gets every new reading */
+void SONIC_LINUX_REACTOR::onReading(callback_t callback, void *context) {
+    _callback = callback;
+    _context = context;
+}
+
+/* Waits for ready sensors and services them */
+int SONIC_LINUX_REACTOR::run(int timeout_ms) {
+    struct epoll_event events[SONIC_LINUX_REACTOR_EVENTS];
+    int delivered_count = 0;
+
+    int count = epoll_wait(_epoll_fd, events, SONIC_LINUX_REACTOR_EVENTS, timeout_ms);
+    if(count < 0) {return -1;}
+
+    for(int i = 0; i < count; i++) {
+        int id = SONIC_REACTOR_ID(events[i].data.u64);
+        source &entry = _sources[id];
+
+        if(entry.i2c) {
+            if(entry.i2c->service()) {
+                delivered(id, entry.i2c->getDistance_um());
+                delivered_count++;
+            } else if(!entry.i2c->getStatus()) {
+                /* Gated or unanswered reading, or the hold-off timer fired - start over */
+                schedule(id);
+            }
+        }
+        #if defined(SONIC_HAVE_GPIOD)
+        else if(entry.io) {
+            uint8_t reading = SONIC_REACTOR_EDGES(events[i].data.u64) ? entry.io->serviceEdges() : entry.io->serviceTimeout();
+            if(reading) {
+                delivered(id, entry.io->getDistance_um());
+                delivered_count++;
+            } else if(!entry.io->getStatus()) {
+                /* Gated reading, stray edge or the hold-off timer fired - start over */
+                schedule(id);
+            }
+        }
+        #endif
+    }
+
+    return delivered_count;
+}
+
+/* Gets the number of registered sensors */
+uint32_t SONIC_LINUX_REACTOR::size() {return _sources.size();}
+
+/* Private function to add one fd of a sensor to the epoll set */
+uint8_t SONIC_LINUX_REACTOR::watch(int fd, int id, uint8_t edges) {
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = SONIC_REACTOR_TAG(id, edges);
+
+    return (fd >= 0) && (epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0);
+}
+
+/* Private function to start the next measurement, or arm the sensor's timer for its hold-off (the core decides) */
+void SONIC_LINUX_REACTOR::schedule(int id) {
+    source &entry = _sources[id];
+
+    if(entry.i2c) {entry.i2c->schedule();}
+    #if defined(SONIC_HAVE_GPIOD)
+    else if(entry.io) {entry.io->schedule();}
+    #endif
+}
+
+/* Private function to deliver a reading and start the next measurement */
+void SONIC_LINUX_REACTOR::delivered(int id, uint32_t distance_um) {
+    if(_callback) {_callback(id, distance_um, _context);}
+    schedule(id);
+}
+
+#endif
@@ -0,0 +1,88 @@
+/*
+    Single thread epoll reactor for driving many Unit Sonic sensors on a Linux gateway.
+
+    Every sensor's conversion timer (timerfd) and edge event fd goes into one epoll set.  The reactor
+    services whichever fds are ready, hands each new reading to the callback and starts the next
+    measurement on that sensor as soon as its core allows it (setInterval(), the IO burst gap, the retry
+    delay of a NAKed trigger) - the sensor's timer is armed for the hold-off, so nothing is polled and one
+    thread keeps hundreds of sensors running back-to-back.
+*/
+#ifndef _UNIT_SONIC_LINUX_REACTOR_H_
+    #define _UNIT_SONIC_LINUX_REACTOR_H_
+
+    #include "Unit_Sonic_Config.h"
+
+    #if defined(SONIC_PLATFORM_LINUX)
+
+        #include <vector>
+        #include "Unit_Sonic_LinuxI2C.h"
+        #include "Unit_Sonic_LinuxGPIO.h"
+
+        #define SONIC_LINUX_REACTOR_EVENTS 64       //epoll events handled per epoll_wait() call
+
+        class SONIC_LINUX_REACTOR {
+            public:
+                /* Signature of the reading callback (id as returned by add()) */
+                typedef void (*callback_t)(int id, uint32_t distance_um, void *context);
+
+                SONIC_LINUX_REACTOR() = default;
+                ~SONIC_LINUX_REACTOR();
+
+                /* Owns the epoll fd - a copy would close it under the original */
+                SONIC_LINUX_REACTOR(const SONIC_LINUX_REACTOR&) = delete;
+                SONIC_LINUX_REACTOR& operator=(const SONIC_LINUX_REACTOR&) = delete;
+
+                /* Creates the epoll set - returns false on failure */
+                uint8_t begin();
+
+                /* Closes the epoll set (the sensors themselves are left open) */
+                void end();
+
+                /* Registers a sensor and starts its first measurement - returns its id or -1 on failure */
+                int add(SONIC_I2C_LINUX *sensor);
+                #if defined(SONIC_HAVE_GPIOD)
+                int add(SONIC_IO_LINUX *sensor);
+                #endif
+
+                /* Registers the callback that gets every new reading */
+                void onReading(callback_t callback, void *context = nullptr);
+
+                /* 
+                    Waits up to timeout_ms (-1 = forever) for ready sensors and services them.  Returns the number of
+                    readings delivered, or -1 if epoll_wait() failed.
+                */
+                int run(int timeout_ms);
+
+                /* Gets the number of registered sensors */
+                uint32_t size();
+
+            private:
+                /* Private structure for one registered sensor */
+                struct source {
+                    SONIC_I2C_LINUX *i2c;
+                    #if defined(SONIC_HAVE_GPIOD)
+                    SONIC_IO_LINUX *io;
+                    #endif
+                };
+
+                /* Private function to add one fd of a sensor to the epoll set (tagged with its id) */
+                uint8_t watch(int fd, int id, uint8_t edges);
+
+                /* Private function to start the next measurement, or arm the sensor's timer for its hold-off */
+                void schedule(int id);
+
+                /* Private function to deliver a reading and start the next measurement */
+                void delivered(int id, uint32_t distance_um);
+
+                /* Private variables for the epoll set and the sensors */
+                int _epoll_fd = -1;
+                std::vector<source> _sources;
+
+                /* Private variables for the reading callback */
+                callback_t _callback = nullptr;
+                void *_context = nullptr;
+        };
+
+    #endif
+
+#endif
@@ -0,0 +1,33 @@
+/*
+    Minimal critical section used by the Unit Sonic helpers that can be read from another task
+    (or ISR) than the one feeding them.  Uses the FreeRTOS spinlock on ESP32 and a plain atomic
+    spinlock elsewhere.
+*/
+#ifndef _UNIT_SONIC_LOCK_H_
+    #define _UNIT_SONIC_LOCK_H_
+
+    #if defined(ESP_PLATFORM)
+        #include "freertos/FreeRTOS.h"
+
+        class SONIC_LOCK {
+            public:
+                void lock() {portENTER_CRITICAL(&_mux);}
+                void unlock() {portEXIT_CRITICAL(&_mux);}
+
+            private:
+                portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+        };
+    #else
+        #include <atomic>
+
+        class SONIC_LOCK {
+            public:
+                void lock() {while(_flag.test_and_set(std::memory_order_acquire)) {}}
+                void unlock() {_flag.clear(std::memory_order_release);}
+
+            private:
+                std::atomic_flag _flag = ATOMIC_FLAG_INIT;
+        };
+    #endif
+
+#endif
@@ -0,0 +1,333 @@
+#include <string.h>
+#include "Unit_Sonic_Log.h"
+
+#if defined(ESP_PLATFORM)
+
+SONIC_LOG_FLASH::~SONIC_LOG_FLASH() {}
+
+/* Opens the data partition with the given label */
+uint8_t SONIC_LOG_FLASH::begin(const char* name, uint32_t size) {
+    _partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+    if(!_partition) {return false;}
+
+    _size = (size && (size < _partition->size)) ? size : _partition->size;
+    return true;
+}
+
+uint8_t SONIC_LOG_FLASH::read(uint32_t offset, void* data, uint32_t length) {
+    return _partition && (esp_partition_read(_partition, offset, data, length) == ESP_OK);
+}
+
+uint8_t SONIC_LOG_FLASH::write(uint32_t offset, const void* data, uint32_t length) {
+    return _partition && (esp_partition_write(_partition, offset, data, length) == ESP_OK);
+}
+
+uint8_t SONIC_LOG_FLASH::erase(uint32_t offset) {
+    return _partition && (esp_partition_erase_range(_partition, offset, SONIC_LOG_SECTOR) == ESP_OK);
+}
+
+#else
+
+SONIC_LOG_FLASH::~SONIC_LOG_FLASH() {
+    if(_file) {fclose(_file);}
+}
+
+/* Opens (or creates erased) the file emulating a partition */
+uint8_t SONIC_LOG_FLASH::begin(const char* name, uint32_t size) {
+    if(_file) {fclose(_file);}
+
+    _size = size - (size % SONIC_LOG_SECTOR);
+    _file = fopen(name, "r+b");
+
+    if(!_file) {
+        _file = fopen(name, "w+b");
+        if(!_file) {return false;}
+    }
+
+    /* Grow the file to the requested size with erased sectors */
+    fseek(_file, 0, SEEK_END);
+    long length = ftell(_file);
+    for(uint32_t offset = (uint32_t)((length < 0) ? 0 : length) / SONIC_LOG_SECTOR * SONIC_LOG_SECTOR; offset < _size; offset += SONIC_LOG_SECTOR) {
+        if(!erase(offset)) {return false;}
+    }
+
+    return _size != 0;
+}
+
+uint8_t SONIC_LOG_FLASH::read(uint32_t offset, void* data, uint32_t length) {
+    if(!_file || (offset + length > _size)) {return false;}
+    return !fseek(_file, offset, SEEK_SET) && (fread(data, 1, length, _file) == length);
+}
+
+/* Like NOR flash, a write can only clear bits */
+uint8_t SONIC_LOG_FLASH::write(uint32_t offset, const void* data, uint32_t length) {
+    const uint8_t* in = (const uint8_t*)data;
+    uint8_t chunk[64];
+
+    while(length) {
+        uint32_t size = (length < sizeof(chunk)) ? length : sizeof(chunk);
+
+        if(!read(offset, chunk, size)) {return false;}
+        for(uint32_t i = 0; i < size; i++) {chunk[i] &= in[i];}
+        if(fseek(_file, offset, SEEK_SET) || (fwrite(chunk, 1, size, _file) != size)) {return false;}
+
+        offset += size;
+        in += size;
+        length -= size;
+    }
+    return fflush(_file) == 0;
+}
+
+uint8_t SONIC_LOG_FLASH::erase(uint32_t offset) {
+    uint8_t erased[256];
+
+    if(!_file || (offset % SONIC_LOG_SECTOR) || (offset + SONIC_LOG_SECTOR > _size)) {return false;}
+
+    memset(erased, 0xFF, sizeof(erased));
+    if(fseek(_file, offset, SEEK_SET)) {return false;}
+    for(uint32_t i = 0; i < SONIC_LOG_SECTOR; i += sizeof(erased)) {
+        if(fwrite(erased, 1, sizeof(erased), _file) != sizeof(erased)) {return false;}
+    }
+    return fflush(_file) == 0;
+}
+
+#endif
+
+/* Context handed through SONIC_BATCH::decode() by query() */
+struct sonic_log_query {
+    uint32_t from;
+    uint32_t to;
+    uint32_t base;
+    SONIC_BATCH::CALLBACK callback;
+    void* context;
+    uint32_t found;
+};
+
+/* Private function to pass on the readings of a batch that are within the queried range */
+static void sonic_log_filter(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms, void* context) {
+    sonic_log_query* query = (sonic_log_query*)context;
+    uint32_t timestamp = timestamp_ms - query->base;
+
+    if((timestamp < query->from) || (timestamp > query->to)) {return;}
+
+    query->found++;
+    if(query->callback) {query->callback(sensor, distance_um, timestamp_ms, query->context);}
+}
+
+/* Mounts the log on a storage - finds the ring and the append position */
+uint8_t SONIC_LOG::begin(SONIC_LOG_STORAGE* storage) {
+    _storage = storage;
+    _count = storage ? storage->getSize() / SONIC_LOG_SECTOR : 0;
+    _oldest = 0;
+    _used = 0;
+    _sequence = 0;
+    _offset = SONIC_LOG_SECTOR;
+    _erases = 0;
+    _written = 0;
+    _batch.start(&_buffer[SONIC_LOG_RECORD_HEADER], SONIC_LOG_BATCH_SIZE);
+
+    if(_count < 2) {
+        _storage = nullptr;
+        return false;
+    }
+
+    /* The oldest and newest sectors are the ones with the lowest and highest sequence */
+    SONIC_LOG_HEADER header;
+    uint32_t oldest_sequence = 0;
+    uint32_t newest = 0;
+
+    for(uint32_t sector = 0; sector < _count; sector++) {
+        if(!read_header(sector, &header)) {continue;}
+
+        if(!_used || (header.sequence < oldest_sequence)) {
+            oldest_sequence = header.sequence;
+            _oldest = sector;
+        }
+        if(!_used || (header.sequence > _sequence)) {
+            _sequence = header.sequence;
+            newest = sector;
+        }
+        _used = 1;
+    }
+
+    if(!_used) {return true;}
+    _used = (newest + _count - _oldest) % _count + 1;
+
+    /* Find the end of the records in the newest sector */
+    uint32_t offset = SONIC_LOG_SECTOR_HEADER;
+    while(offset + SONIC_LOG_RECORD_HEADER <= SONIC_LOG_SECTOR) {
+        uint8_t record[SONIC_LOG_RECORD_HEADER];
+        if(!_storage->read(newest * SONIC_LOG_SECTOR + offset, record, sizeof(record))) {return false;}
+
+        uint16_t length = record[0] | ((uint16_t)record[1] << 8);
+        if((length == 0xFFFF) && (record[2] == 0xFF) && (record[3] == 0xFF)) {break;}
+
+        /* Garbage (e.g. power lost while writing) --> close the sector, the next record opens a new one */
+        if(!length || (length > SONIC_LOG_BATCH_SIZE) || (offset + SONIC_LOG_RECORD_HEADER + length > SONIC_LOG_SECTOR)) {
+            offset = SONIC_LOG_SECTOR;
+            break;
+        }
+        offset += SONIC_LOG_RECORD_HEADER + length;
+    }
+    _offset = offset;
+
+    return true;
+}
+
+/* Adds a reading - returns false if a batch could not be written */
+uint8_t SONIC_LOG::add(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms) {
+    uint8_t ok = true;
+
+    if(!_storage) {return false;}
+
+    /* Write the batch first once it is old */
+    if(!_batch.empty() && ((timestamp_ms - _batch.getStarted()) >= SONIC_LOG_MAX_AGE_MS)) {ok = commit();}
+
+    if(_batch.add(sensor, distance_um, timestamp_ms)) {return ok;}
+
+    /* The batch is full --> write it and start the next one with this reading */
+    ok = commit() && ok;
+    return _batch.add(sensor, distance_um, timestamp_ms) && ok;
+}
+
+/* Writes the batch being collected right away */
+uint8_t SONIC_LOG::flush() {
+    return _storage && commit();
+}
+
+/* Calls the callback for every stored reading within the range */
+uint32_t SONIC_LOG::query(uint32_t from_ms, uint32_t to_ms, SONIC_BATCH::CALLBACK callback, void* context) {
+    SONIC_LOG_HEADER header;
+    sonic_log_query query = {0, 0, 0, callback, context, 0};
+
+    if(!_storage) {return 0;}
+
+    /* Compare the timestamps relative to the oldest data, so a millis() wrap inside the history is handled */
+    if(_used && read_header(_oldest, &header)) {
+        query.base = header.first_timestamp;
+    } else {
+        query.base = _batch.getStarted();
+    }
+    query.from = from_ms - query.base;
+    query.to = to_ms - query.base;
+
+    /* A range starting before the oldest data (e.g. query(0, millis())) starts at the oldest data */
+    if(query.from > query.to) {query.from = 0;}
+
+    /* Binary search for the last sector starting at or before the range */
+    uint32_t first = 0;
+    uint32_t low = 0;
+    uint32_t high = _used;
+    while(low < high) {
+        uint32_t middle = low + (high - low) / 2;
+
+        if(read_header(sector_at(middle), &header) && ((header.first_timestamp - query.base) <= query.from)) {
+            first = middle;
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    /* Walk the records from there until a sector starts after the range */
+    for(uint32_t position = first; position < _used; position++) {
+        uint32_t sector = sector_at(position);
+        uint32_t end = (position == _used - 1) ? _offset : SONIC_LOG_SECTOR;
+
+        if(!read_header(sector, &header)) {continue;}
+        if((header.first_timestamp - query.base) > query.to) {break;}
+
+        for(uint32_t offset = SONIC_LOG_SECTOR_HEADER; offset + SONIC_LOG_RECORD_HEADER <= end; ) {
+            uint8_t record[SONIC_LOG_RECORD_HEADER + SONIC_LOG_BATCH_SIZE];
+
+            if(!_storage->read(sector * SONIC_LOG_SECTOR + offset, record, SONIC_LOG_RECORD_HEADER)) {break;}
+
+            uint16_t length = record[0] | ((uint16_t)record[1] << 8);
+            uint16_t crc = record[2] | ((uint16_t)record[3] << 8);
+
+            if(!length || (length > SONIC_LOG_BATCH_SIZE) || (offset + SONIC_LOG_RECORD_HEADER + length > SONIC_LOG_SECTOR)) {break;}
+
+            /* A record torn by a power loss fails its CRC and is skipped */
+            if(_storage->read(sector * SONIC_LOG_SECTOR + offset + SONIC_LOG_RECORD_HEADER, &record[SONIC_LOG_RECORD_HEADER], length) &&
+               (SONIC_CODEC::crc16(&record[SONIC_LOG_RECORD_HEADER], length) == crc)) {
+                SONIC_BATCH::decode(&record[SONIC_LOG_RECORD_HEADER], length, sonic_log_filter, &query);
+            }
+            offset += SONIC_LOG_RECORD_HEADER + length;
+        }
+    }
+
+    /* The batch still in RAM is the newest data */
+    if(!_batch.empty()) {SONIC_BATCH::decode(&_buffer[SONIC_LOG_RECORD_HEADER], _batch.getLength(), sonic_log_filter, &query);}
+
+    return query.found;
+}
+
+/* Private function to write the batch as a record and start a new one */
+uint8_t SONIC_LOG::commit() {
+    if(_batch.empty()) {return true;}
+
+    uint16_t length = _batch.getLength();
+    uint32_t size = SONIC_LOG_RECORD_HEADER + length;
+    uint8_t ok = true;
+
+    /* Move on to the next sector of the ring if the record doesn't fit anymore */
+    if(_offset + size > SONIC_LOG_SECTOR) {ok = open_sector(_batch.getStarted());}
+
+    if(ok) {
+        uint16_t crc = SONIC_CODEC::crc16(&_buffer[SONIC_LOG_RECORD_HEADER], length);
+
+        _buffer[0] = (uint8_t)length;
+        _buffer[1] = (uint8_t)(length >> 8);
+        _buffer[2] = (uint8_t)crc;
+        _buffer[3] = (uint8_t)(crc >> 8);
+
+        ok = _storage->write(sector_at(_used - 1) * SONIC_LOG_SECTOR + _offset, _buffer, size);
+        _written += size;
+
+        /*
+            A failed write may leave an erased hole, where the record walks of query(), begin() and the reader stop - close
+            the sector so no record lands behind it (the next commit() opens a new one)
+        */
+        _offset = ok ? (_offset + size) : SONIC_LOG_SECTOR;
+    }
+
+    /* A batch that couldn't be written is dropped rather than blocking the following ones */
+    _batch.start(&_buffer[SONIC_LOG_RECORD_HEADER], SONIC_LOG_BATCH_SIZE);
+    return ok;
+}
+
+/* Private function to erase and open the next sector of the ring */
+uint8_t SONIC_LOG::open_sector(uint32_t first_timestamp) {
+    uint32_t sector = _used ? sector_at(_used) : _oldest;
+
+    /* The ring is full --> the oldest sector is recycled */
+    if(_used == _count) {
+        _oldest = (_oldest + 1) % _count;
+        _used--;
+    }
+
+    SONIC_LOG_HEADER header = {SONIC_LOG_MAGIC, _sequence + 1, first_timestamp, 0, 0xFFFF};
+    header.crc = SONIC_CODEC::crc16((const uint8_t*)&header, 12);
+
+    _erases++;
+    if(!_storage->erase(sector * SONIC_LOG_SECTOR)) {return false;}
+
+    /* 
+        Only a sector with a header belongs to the ring - if the write failed, the current sector stays the newest and
+        the next commit() erases and tries this one again
+    */
+    _written += sizeof(header);
+    if(!_storage->write(sector * SONIC_LOG_SECTOR, &header, sizeof(header))) {return false;}
+
+    _sequence++;
+    _used++;
+    _offset = SONIC_LOG_SECTOR_HEADER;
+
+    return true;
+}
+
+/* Private function to read and check a sector header */
+uint8_t SONIC_LOG::read_header(uint32_t sector, SONIC_LOG_HEADER* header) {
+    if(!_storage->read(sector * SONIC_LOG_SECTOR, header, sizeof(*header))) {return false;}
+    return (header->magic == SONIC_LOG_MAGIC) && (header->crc == SONIC_CODEC::crc16((const uint8_t*)header, 12));
+}
@@ -0,0 +1,150 @@
+/*
+    Wear leveled circular log of readings on flash.
+
+    Readings are collected into a small SONIC_BATCH in RAM and appended as one record once the batch is full,
+    older than SONIC_LOG_MAX_AGE_MS or flushed.  The storage is used as a ring of 4KB sectors written strictly
+    in order: a sector is only erased right before it is reused for the newest data, so every sector sees the
+    same number of erase cycles and no data is ever rewritten in place.
+
+    Sector:  header (magic, sequence, first timestamp, CRC) | record | record | ... | erased (0xFF)
+    Record:  payload length (u16) | CRC-16 of the payload (u16) | SONIC_BATCH payload
+
+    The sector sequence numbers recover the ring after a reset, and since the sectors are in time order a
+    time range query finds its first sector by binary search over the sector headers (no RAM index).
+    Timestamps are the 32 bit ms of the sensors, so the history kept must span less than ~49 days.
+*/
+#ifndef _UNIT_SONIC_LOG_H_
+    #define _UNIT_SONIC_LOG_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Batch.h"
+    #include "Unit_Sonic_Sink.h"
+
+    #if defined(ESP_PLATFORM)
+        #include "esp_partition.h"
+    #else
+        #include <stdio.h>
+    #endif
+
+    #ifndef SONIC_LOG_BATCH_SIZE
+        #define SONIC_LOG_BATCH_SIZE 128            //RAM buffer for the batch being collected (max record payload)
+    #endif
+    #ifndef SONIC_LOG_MAX_AGE_MS
+        #define SONIC_LOG_MAX_AGE_MS 60000          //A partly filled batch is written once its first reading is this old
+    #endif
+
+    #define SONIC_LOG_SECTOR 4096                   //Flash erase unit
+    #define SONIC_LOG_MAGIC 0x4C4E4F53UL            //"SONL"
+    #define SONIC_LOG_SECTOR_HEADER 16              //Bytes of the sector header
+    #define SONIC_LOG_RECORD_HEADER 4               //Bytes in front of every record payload
+
+    /* Raw storage the log runs on - NOR flash semantics (erase sets 0xFF, writes only clear bits) */
+    class SONIC_LOG_STORAGE {
+        public:
+            virtual ~SONIC_LOG_STORAGE() {}
+
+            /* Gets the usable size in bytes */
+            virtual uint32_t getSize() = 0;
+
+            /* Reads/writes bytes - return false on a driver error */
+            virtual uint8_t read(uint32_t offset, void* data, uint32_t length) = 0;
+            virtual uint8_t write(uint32_t offset, const void* data, uint32_t length) = 0;
+
+            /* Erases the SONIC_LOG_SECTOR bytes starting at offset */
+            virtual uint8_t erase(uint32_t offset) = 0;
+    };
+
+    /* Storage on a data partition (ESP32) or in a file that emulates one (host builds) */
+    class SONIC_LOG_FLASH : public SONIC_LOG_STORAGE {
+        public:
+            ~SONIC_LOG_FLASH();
+
+            /*
+                Opens the partition with the given label (size 0 uses all of it), or on host the file at the given
+                path, created erased with the given size.  Returns false if it can't be used.
+            */
+            uint8_t begin(const char* name, uint32_t size = 0);
+
+            uint32_t getSize() override {return _size;}
+            uint8_t read(uint32_t offset, void* data, uint32_t length) override;
+            uint8_t write(uint32_t offset, const void* data, uint32_t length) override;
+            uint8_t erase(uint32_t offset) override;
+
+        private:
+            uint32_t _size = 0;
+
+            #if defined(ESP_PLATFORM)
+                const esp_partition_t* _partition = nullptr;
+            #else
+                FILE* _file = nullptr;
+            #endif
+    };
+
+    /* Header at the start of every used sector */
+    struct SONIC_LOG_HEADER {
+        uint32_t magic;
+        uint32_t sequence;
+        uint32_t first_timestamp;
+        uint16_t crc;
+        uint16_t reserved;
+    };
+
+    class SONIC_LOG {
+        public:
+            /* Mounts the log on a storage (at least 2 sectors) - finds the ring and the append position */
+            uint8_t begin(SONIC_LOG_STORAGE* storage);
+
+            /* Adds a reading - returns false if a batch could not be written */
+            uint8_t add(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms);
+
+            /* Writes the batch being collected right away (e.g. before a planned power down) */
+            uint8_t flush();
+
+            /*
+                Calls the callback for every stored reading with from_ms <= timestamp <= to_ms, oldest first, including
+                the batch still in RAM.  Returns the number of readings found.
+            */
+            uint32_t query(uint32_t from_ms, uint32_t to_ms, SONIC_BATCH::CALLBACK callback, void* context = nullptr);
+
+            /* Gets the number of sectors in use / available */
+            uint32_t getUsedSectors() const {return _used;}
+            uint32_t getSectors() const {return _count;}
+
+            /* Gets the sector erases and the bytes written since begin() (to check the write amplification) */
+            uint32_t getErases() const {return _erases;}
+            uint32_t getWritten() const {return _written;}
+
+        private:
+            /* Private function to write the batch as a record and start a new one */
+            uint8_t commit();
+
+            /* Private function to erase and open the next sector of the ring */
+            uint8_t open_sector(uint32_t first_timestamp);
+
+            /* Private function to read and check a sector header */
+            uint8_t read_header(uint32_t sector, SONIC_LOG_HEADER* header);
+
+            /* Private function to map a position in the ring (0 = oldest) onto a sector */
+            uint32_t sector_at(uint32_t position) const {return (_oldest + position) % _count;}
+
+            /* Private variables for the ring */
+            SONIC_LOG_STORAGE* _storage = nullptr;
+            uint32_t _count = 0;
+            uint32_t _oldest = 0;
+            uint32_t _used = 0;
+            uint32_t _sequence = 0;
+            uint32_t _offset = SONIC_LOG_SECTOR;
+
+            /* Private variables for the batch being collected (the record header goes in front of it) */
+            uint8_t _buffer[SONIC_LOG_RECORD_HEADER + SONIC_LOG_BATCH_SIZE];
+            SONIC_BATCH _batch;
+
+            /* Private variables for the wear statistics */
+            uint32_t _erases = 0;
+            uint32_t _written = 0;
+    };
+
+    /* Sink that logs every reading of the sensor it is attached to under a fixed sensor id */
+    typedef SONIC_CHANNEL<SONIC_LOG> SONIC_LOG_CHANNEL;
+
+#endif
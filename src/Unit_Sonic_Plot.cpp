@@ -0,0 +1,84 @@
+#include "Unit_Sonic_Plot.h"
+
+/* Places the plot, sets the time per column and the distance range */
+void SONIC_PLOT::begin(int16_t x, int16_t y, int16_t width, int16_t height, uint32_t column_ms, uint32_t near_um, uint32_t far_um) {
+    _x = x;
+    _y = y;
+    _width = (width > SONIC_PLOT_GAP) ? width : SONIC_PLOT_GAP + 1;
+    _height = (height > 0) ? height : 1;
+    _column_ms = column_ms ? column_ms : 1;
+    _near = near_um;
+    _far = (far_um > near_um) ? far_um : near_um + 1;
+
+    _started = false;
+    _current.top = -1;
+    _head = 0;
+    _count = 0;
+    _column = 0;
+    _lost = 0;
+    _previous = -1;
+}
+
+/* Adds a reading */
+void SONIC_PLOT::add(uint32_t distance_um, uint32_t timestamp_ms) {
+    close_columns(timestamp_ms);
+
+    int16_t pixel = row(distance_um);
+    if(_current.top < 0) {
+        _current.top = pixel;
+        _current.bottom = pixel;
+    } else {
+        if(pixel < _current.top) {_current.top = pixel;}
+        if(pixel > _current.bottom) {_current.bottom = pixel;}
+    }
+    _current.last = pixel;
+}
+
+/* Private function to queue every column that ended before now_ms */
+void SONIC_PLOT::close_columns(uint32_t now_ms) {
+    if(!_started) {
+        _column_start = now_ms;
+        _started = true;
+        return;
+    }
+
+    /* 
+        After a long pause only the columns that still fit on the screen matter - the ones still queued would be
+        drawn over by them anyway
+    */
+    uint32_t ended = (now_ms - _column_start) / _column_ms;
+    if(ended > (uint32_t)_width) {
+        _skipped += ended - _width + _count;
+        lose(ended - _width + _count);
+        _count = 0;
+        _column_start += (ended - _width) * _column_ms;
+        ended = _width;
+    }
+
+    while(ended--) {
+        if(_count == SONIC_PLOT_QUEUE) {
+            _head = (_head + 1) % SONIC_PLOT_QUEUE;
+            _count--;
+            _skipped++;
+            lose(1);
+        }
+
+        _queue[(_head + _count) % SONIC_PLOT_QUEUE] = _current;
+        _count++;
+        _current.top = -1;
+        _column_start += _column_ms;
+    }
+}
+
+/* Private function to count columns that pass without being drawn - past a whole sweep only the remainder moves it */
+void SONIC_PLOT::lose(uint32_t columns) {
+    uint64_t total = (uint64_t)_lost + columns;
+    _lost = (total >= (uint64_t)_width) ? (uint32_t)_width + (uint32_t)(total % _width) : (uint32_t)total;
+}
+
+/* Private function to map a distance onto a pixel row (near at the top) */
+int16_t SONIC_PLOT::row(uint32_t distance_um) const {
+    if(distance_um <= _near) {return 0;}
+    if(distance_um >= _far) {return _height - 1;}
+    return (int16_t)((uint64_t)(distance_um - _near) * (_height - 1) / (_far - _near));
+}
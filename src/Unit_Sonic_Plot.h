@@ -0,0 +1,158 @@
+/*
+    Live distance plot for small displays that only redraws what changed.
+
+    The examples used to scroll a full screen sprite and push all of it for every reading, which costs a
+    whole frame of SPI transfers (~40ms on a 320x240 panel) per loop and starves the polling.  SONIC_PLOT
+    draws like an oscilloscope sweep instead: the trace is written left to right, one column per column_ms,
+    and a short gap ahead of it erases the previous sweep.  Every completed column is drawn once, straight
+    to the display (a vertical line from the column's min to its max reading, joined to the previous one),
+    so a frame costs a few pixel columns no matter how wide the plot is.
+
+    add() can be called at any reading rate (e.g. from a SONIC_SINK) and only folds the reading into the
+    current column; render() is called whenever the loop has time and draws the columns completed since.
+    The display is anything with fillRect(x, y, w, h, color) and drawFastVLine(x, y, h, color), like M5GFX,
+    LovyanGFX, TFT_eSPI or M5.Lcd.
+*/
+#ifndef _UNIT_SONIC_PLOT_H_
+    #define _UNIT_SONIC_PLOT_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Sink.h"
+
+    #ifndef SONIC_PLOT_QUEUE
+        #define SONIC_PLOT_QUEUE 32                 //Completed columns kept for render() (older ones are skipped)
+    #endif
+    #ifndef SONIC_PLOT_GAP
+        #define SONIC_PLOT_GAP 4                    //Columns erased ahead of the trace
+    #endif
+
+    class SONIC_PLOT : public SONIC_SINK {
+        public:
+            /* Places the plot, sets the time per column and the distance range from the top to the bottom edge */
+            void begin(int16_t x, int16_t y, int16_t width, int16_t height, uint32_t column_ms = 50,
+                       uint32_t near_um = 20000, uint32_t far_um = 4500000);
+
+            /* Sets the trace and background colors (RGB565, which every supported display library takes as uint16_t) */
+            void setColors(uint16_t trace, uint16_t background) {
+                _trace = trace;
+                _background = background;
+            }
+
+            /* Adds a reading */
+            void add(uint32_t distance_um, uint32_t timestamp_ms);
+            void onReading(uint32_t distance_um, uint32_t timestamp_ms) override {add(distance_um, timestamp_ms);}
+
+            /* Clears the plot area and starts the sweep over at the left edge - call it once before the first render() */
+            template <typename DISPLAY>
+            void clear(DISPLAY& display) {
+                display.fillRect(_x, _y, _width, _height, _background);
+                _column = 0;
+                _count = 0;
+                _lost = 0;
+                _previous = -1;
+            }
+
+            /*
+                Draws the columns completed up to now_ms, at most max_columns of them - returns how many were drawn.
+                Columns without readings stay empty, skipped columns are erased so the sweep stays in time.
+            */
+            template <typename DISPLAY>
+            uint16_t render(DISPLAY& display, uint32_t now_ms, uint16_t max_columns = 0xFFFF) {
+                close_columns(now_ms);
+
+                uint16_t drawn = 0;
+
+                /* The skipped columns come before the queued ones - a whole sweep of them is one clear */
+                if(_lost >= (uint32_t)_width) {
+                    display.fillRect(_x, _y, _width, _height, _background);
+                    _column = (int16_t)((_column + _lost) % (uint32_t)_width);
+                    _lost = 0;
+                    _previous = -1;
+                    drawn++;
+                }
+                while(_lost && (drawn < max_columns)) {
+                    display.drawFastVLine(_x + (_column + SONIC_PLOT_GAP) % _width, _y, _height, _background);
+                    display.drawFastVLine(_x + _column, _y, _height, _background);
+                    _column = (_column + 1) % _width;
+                    _previous = -1;
+                    _lost--;
+                    drawn++;
+                }
+
+                while(!_lost && _count && (drawn < max_columns)) {
+                    const column_state& column = _queue[_head];
+                    int16_t x = _x + _column;
+
+                    /* Erase ahead of the trace (the column itself was erased that way SONIC_PLOT_GAP columns ago) */
+                    display.drawFastVLine(_x + (_column + SONIC_PLOT_GAP) % _width, _y, _height, _background);
+
+                    if(column.top >= 0) {
+                        int16_t top = column.top;
+                        int16_t bottom = column.bottom;
+
+                        /* Join the previous column so the trace stays continuous */
+                        if((_previous >= 0) && _column) {
+                            if(_previous < top) {top = _previous;}
+                            if(_previous > bottom) {bottom = _previous;}
+                        }
+                        display.drawFastVLine(x, _y + top, bottom - top + 1, _trace);
+                        _previous = column.last;
+                    } else {
+                        _previous = -1;
+                    }
+
+                    _column = (_column + 1) % _width;
+                    _head = (_head + 1) % SONIC_PLOT_QUEUE;
+                    _count--;
+                    drawn++;
+                }
+                return drawn;
+            }
+
+            /* Gets the number of columns that were skipped because render() fell behind */
+            uint32_t getSkipped() const {return _skipped;}
+
+        private:
+            /* Private structure for a completed column (pixel rows relative to the top, -1 = no reading) */
+            struct column_state {
+                int16_t top;
+                int16_t bottom;
+                int16_t last;
+            };
+
+            /* Private function to queue every column that ended before now_ms */
+            void close_columns(uint32_t now_ms);
+
+            /* Private function to count columns that pass without being drawn (render() erases them) */
+            void lose(uint32_t columns);
+
+            /* Private function to map a distance onto a pixel row */
+            int16_t row(uint32_t distance_um) const;
+
+            /* Private variables for the geometry */
+            int16_t _x = 0;
+            int16_t _y = 0;
+            int16_t _width = 1;
+            int16_t _height = 1;
+            uint32_t _column_ms = 50;
+            uint32_t _near = 20000;
+            uint32_t _far = 4500000;
+            uint16_t _trace = 0xFFFF;
+            uint16_t _background = 0;
+
+            /* Private variables for the column being collected */
+            uint32_t _column_start = 0;
+            uint8_t _started = false;
+            column_state _current = {-1, -1, -1};
+
+            /* Private variables for the columns waiting for render() and the drawing position */
+            column_state _queue[SONIC_PLOT_QUEUE];
+            uint8_t _head = 0;
+            uint8_t _count = 0;
+            int16_t _column = 0;
+            int16_t _previous = -1;
+            uint32_t _lost = 0;             //Columns to erase before the queue (from _width on: clear, only the remainder moves the sweep)
+            uint32_t _skipped = 0;
+    };
+
+#endif
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include "Unit_Sonic_Publisher.h"
+
+/* Sets the topic, the measurement name and optional extra tags - returns false if the longest line can't fit */
+uint8_t SONIC_PUBLISHER::begin(const char* topic, const char* measurement, const char* tags) {
+    _topic = topic;
+    _measurement = measurement;
+    _tags = (tags && tags[0]) ? tags : nullptr;
+
+    for(uint8_t i = 0; i < SONIC_PUBLISHER_MAX_SENSORS; i++) {_sensors[i].count = 0;}
+    _known = 0;
+    _included = 0;
+    _first = 0;
+    _attempted = false;
+    _awaiting = false;
+
+    /* Every field at its widest, with a time */
+    sensor_state widest = {UINT32_MAX, (uint64_t)UINT32_MAX * UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, UINT32_MAX, 0, 0};
+    char line[SONIC_PUBLISHER_LINE];
+    uint16_t length = format(line, SONIC_PUBLISHER_MAX_SENSORS - 1, widest, UINT64_MAX);
+
+    return length && (length + 1 <= SONIC_PUBLISHER_PAYLOAD);
+}
+
+/* Adds a reading - returns false if the sensor id is invalid */
+uint8_t SONIC_PUBLISHER::add(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms) {
+    if(sensor >= SONIC_PUBLISHER_MAX_SENSORS) {return false;}
+
+    sensor_state& state = _sensors[sensor];
+    if(!state.count) {
+        state.sum = 0;
+        state.min = distance_um;
+        state.max = distance_um;
+    }
+
+    state.count++;
+    state.sum += distance_um;
+    if(distance_um < state.min) {state.min = distance_um;}
+    if(distance_um > state.max) {state.max = distance_um;}
+    state.last = distance_um;
+    state.last_ms = timestamp_ms;
+
+    return true;
+}
+
+/* Gets the next message - returns its length (0 if nothing is due) */
+uint16_t SONIC_PUBLISHER::pending(const char** payload, uint32_t now_ms) {
+    /* A message offered before that wasn't consumed has been refused by the transport */
+    if(_awaiting) {
+        _awaiting = false;
+        _rejected++;
+    }
+
+    /* One message (or attempt) per interval */
+    if(_attempted && ((now_ms - _attempt_ms) < _interval)) {return 0;}
+
+    uint16_t length = 0;
+    _included = 0;
+
+    /* Start after the sensors of the last full message, so every sensor gets its turn */
+    for(uint8_t n = 0; n < SONIC_PUBLISHER_MAX_SENSORS; n++) {
+        uint8_t i = (uint8_t)((_first + n) % SONIC_PUBLISHER_MAX_SENSORS);
+        sensor_state& state = _sensors[i];
+        if(!due(state, now_ms)) {continue;}
+
+        char line[SONIC_PUBLISHER_LINE];
+        uint16_t written = format(line, i, state, _epoch ? _epoch + state.last_ms : 0);
+
+        /* A line that can't fit even into an empty message would hold up the sensors behind it forever --> dropped */
+        if(!written || (written + 1 > SONIC_PUBLISHER_PAYLOAD)) {
+            state.count = 0;
+            _dropped++;
+            continue;
+        }
+
+        /* Sensors that don't fit anymore go into the next message */
+        if(length + written + 1 > SONIC_PUBLISHER_PAYLOAD) {
+            _first = i;
+            break;
+        }
+
+        for(uint16_t c = 0; c < written; c++) {_payload[length++] = line[c];}
+        _payload[length++] = '\n';
+        _included |= 1UL << i;
+    }
+
+    if(!length) {return 0;}
+
+    _attempt_ms = now_ms;
+    _attempted = true;
+    _awaiting = true;
+    *payload = _payload;
+    return length - 1;
+}
+
+/* Marks the message returned by pending() as published */
+void SONIC_PUBLISHER::consume() {
+    if(!_awaiting) {return;}
+
+    for(uint8_t i = 0; i < SONIC_PUBLISHER_MAX_SENSORS; i++) {
+        if(!(_included & (1UL << i))) {continue;}
+
+        sensor_state& state = _sensors[i];
+        state.published = state.last;
+        state.published_ms = _attempt_ms;
+        state.count = 0;
+        _known |= 1UL << i;
+        _lines++;
+    }
+
+    _awaiting = false;
+    _messages++;
+}
+
+/* Private function to check whether a sensor has to go into the next message */
+uint8_t SONIC_PUBLISHER::due(const sensor_state& state, uint32_t now_ms) const {
+    if(!state.count) {return false;}
+
+    uint8_t sensor = (uint8_t)(&state - _sensors);
+    if(!(_known & (1UL << sensor))) {return true;}
+
+    uint32_t change = (state.last > state.published) ? state.last - state.published : state.published - state.last;
+    return (change >= _deadband) || ((now_ms - state.published_ms) >= _heartbeat);
+}
+
+/* Private function to write the line of a sensor - returns its length, 0 if it doesn't fit in SONIC_PUBLISHER_LINE */
+uint16_t SONIC_PUBLISHER::format(char* line, uint8_t sensor, const sensor_state& state, uint64_t time) const {
+    int written = snprintf(line, SONIC_PUBLISHER_LINE, "%s,sensor=%u%s%s distance_um=%lui,mean_um=%lui,min_um=%lui,max_um=%lui,count=%lui",
+                           _measurement, sensor, _tags ? "," : "", _tags ? _tags : "", (unsigned long)state.last,
+                           (unsigned long)((state.sum + state.count / 2) / state.count), (unsigned long)state.min,
+                           (unsigned long)state.max, (unsigned long)state.count);
+    if(time && (written > 0) && (written < SONIC_PUBLISHER_LINE)) {
+        written += snprintf(&line[written], SONIC_PUBLISHER_LINE - written, " %llu", (unsigned long long)time);
+    }
+
+    /* A truncated line is no line */
+    return ((written > 0) && (written < SONIC_PUBLISHER_LINE - 1)) ? (uint16_t)written : 0;
+}
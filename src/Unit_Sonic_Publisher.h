@@ -0,0 +1,140 @@
+/*
+    Batched publisher of readings for MQTT (or any other message transport), in InfluxDB line protocol.
+
+    Readings of every sensor are summarised in RAM (last, mean, min, max, count) and at most one message per
+    interval is built from them, holding one line per sensor that is due: its last reading moved at least the
+    deadband away from the last published value, or nothing was published for it for the heartbeat time.
+
+        <measurement>,sensor=<id>[,<tags>] distance_um=<last>i,mean_um=..i,min_um=..i,max_um=..i,count=..i[ <time>]
+
+    The time is only written if setEpoch() was called (Unix ms, so the consumer has to use ms precision).
+
+    Adding a reading never blocks.  When the transport can't take a message (broker slow or gone) the readings
+    keep being summarised and the next attempt, one interval later, publishes the summary of everything since
+    the last message that got through, so backpressure costs resolution instead of stalling the acquisition.
+*/
+#ifndef _UNIT_SONIC_PUBLISHER_H_
+    #define _UNIT_SONIC_PUBLISHER_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Sink.h"
+
+    #ifndef SONIC_PUBLISHER_MAX_SENSORS
+        #define SONIC_PUBLISHER_MAX_SENSORS 8       //Sensor ids 0..7
+    #endif
+    #if SONIC_PUBLISHER_MAX_SENSORS > 32
+        #error "SONIC_PUBLISHER_MAX_SENSORS can't be more than 32"
+    #endif
+    #ifndef SONIC_PUBLISHER_PAYLOAD
+        #define SONIC_PUBLISHER_PAYLOAD 512         //Max message size (sensors that don't fit go in the next message)
+    #endif
+    #define SONIC_PUBLISHER_LINE 160                //Max line size, the measurement and the tags included
+
+    class SONIC_PUBLISHER {
+        public:
+            /* 
+                Sets the topic, the measurement name and optional extra tags ("site=lab,gw=3") - the strings are not copied.
+                Returns false if the longest possible line with them doesn't fit in SONIC_PUBLISHER_LINE or a message
+                (such lines are dropped and counted by getDropped()).
+            */
+            uint8_t begin(const char* topic, const char* measurement = "sonic", const char* tags = nullptr);
+
+            /* Sets the change in um needed to publish a sensor before its heartbeat (0 publishes every interval) */
+            void setDeadband(uint32_t deadband_um) {_deadband = deadband_um;}
+
+            /* Sets the minimum time between messages and the heartbeat time after which a sensor is published anyway */
+            void setInterval(uint32_t min_ms, uint32_t heartbeat_ms) {
+                _interval = min_ms;
+                _heartbeat = heartbeat_ms;
+            }
+
+            /* Sets the Unix time in ms at reading timestamp 0, to write the time of every line (0 leaves it to the consumer) */
+            void setEpoch(uint64_t epoch_ms) {_epoch = epoch_ms;}
+
+            /* Adds a reading - returns false if the sensor id is invalid */
+            uint8_t add(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms);
+
+            /*
+                Gets the next message - returns its length (0 if nothing is due).  The message stays valid until the
+                next call.  Call consume() once the transport took it, or it is retried one interval later.
+            */
+            uint16_t pending(const char** payload, uint32_t now_ms);
+
+            /* Marks the message returned by pending() as published */
+            void consume();
+
+            /*
+                Publishes the next message through anything with publish(topic, payload, length) returning whether
+                it was accepted (e.g. PubSubClient or SONIC_MQTT_LINUX) - call it from the user's loop.
+                Returns true if a message was published.
+            */
+            template <typename CLIENT>
+            uint8_t publishTo(CLIENT& client, uint32_t now_ms) {
+                const char* payload;
+                uint16_t length = pending(&payload, now_ms);
+
+                if(!length || !client.publish(_topic, (const uint8_t*)payload, length)) {return false;}
+
+                consume();
+                return true;
+            }
+
+            /* Gets the topic */
+            const char* getTopic() const {return _topic;}
+
+            /* Gets the number of messages published / not taken by the transport, and the lines published / too long to send */
+            uint32_t getMessages() const {return _messages;}
+            uint32_t getRejected() const {return _rejected;}
+            uint32_t getLines() const {return _lines;}
+            uint32_t getDropped() const {return _dropped;}
+
+        private:
+            /* Private structure for the summary of one sensor since it was last published */
+            struct sensor_state {
+                uint32_t count;
+                uint64_t sum;
+                uint32_t min;
+                uint32_t max;
+                uint32_t last;
+                uint32_t last_ms;
+                uint32_t published;
+                uint32_t published_ms;
+            };
+
+            /* Private function to check whether a sensor has to go into the next message */
+            uint8_t due(const sensor_state& state, uint32_t now_ms) const;
+
+            /* Private function to write the line of a sensor (time 0 = none) - returns its length, 0 if it doesn't fit in line */
+            uint16_t format(char* line, uint8_t sensor, const sensor_state& state, uint64_t time) const;
+
+            /* Private variables for the configuration */
+            const char* _topic = "sonic";
+            const char* _measurement = "sonic";
+            const char* _tags = nullptr;
+            uint32_t _deadband = 0;
+            uint32_t _interval = 1000;
+            uint32_t _heartbeat = 60000;
+            uint64_t _epoch = 0;
+
+            /* Private variables for the summaries (a bit per sensor that has ever been published) */
+            sensor_state _sensors[SONIC_PUBLISHER_MAX_SENSORS];
+            uint32_t _known = 0;
+
+            /* Private variables for the message being offered */
+            char _payload[SONIC_PUBLISHER_PAYLOAD];
+            uint32_t _included = 0;
+            uint8_t _first = 0;
+            uint32_t _attempt_ms = 0;
+            uint8_t _attempted = false;
+            uint8_t _awaiting = false;
+
+            uint32_t _messages = 0;
+            uint32_t _rejected = 0;
+            uint32_t _lines = 0;
+            uint32_t _dropped = 0;
+    };
+
+    /* Sink that publishes every reading of the sensor it is attached to under a fixed sensor id */
+    typedef SONIC_CHANNEL<SONIC_PUBLISHER> SONIC_PUBLISHER_CHANNEL;
+
+#endif
@@ -0,0 +1,128 @@
+/*
+    Future style measurement requests for the Unit Sonic sensors (no coroutines required).
+
+    requestMeasurement(sonic) returns a SONIC_REQUEST handle that lives wherever the caller puts it (stack,
+    member, array) - nothing is allocated.  The handle drives the sensor's own readingAvailable() state
+    machine when it is polled, so any number of requests on different sensors can be in flight together:
+
+        SONIC_REQUEST requests[2] = {requestMeasurement(sonic_left), requestMeasurement(sonic_right)};
+        if(SONIC_REQUEST::wait_all(requests, 2, 200, millis)) {...}
+
+    Only one request may be pending on a given sensor at a time - the first one to poll it consumes the reading.
+*/
+#ifndef _UNIT_SONIC_REQUEST_H_
+    #define _UNIT_SONIC_REQUEST_H_
+
+    #include <stdint.h>
+
+    #define SONIC_REQUEST_IDLE 0        //Empty handle
+    #define SONIC_REQUEST_PENDING 1     //Waiting for the sensor
+    #define SONIC_REQUEST_DONE 2        //Reading available through getDistance_um()
+
+    class SONIC_REQUEST {
+        public:
+            typedef uint8_t (*POLL)(void* sensor, uint32_t* distance_um);
+            typedef void (*CONTINUATION)(SONIC_REQUEST& request, void* context);
+
+            SONIC_REQUEST() {}
+            SONIC_REQUEST(void* sensor, POLL poll) : _sensor(sensor), _poll(poll), _status(SONIC_REQUEST_PENDING) {}
+
+            /* Polls the sensor once (if still pending) - returns true once the reading is available */
+            uint8_t poll() {
+                if((_status == SONIC_REQUEST_PENDING) && _poll(_sensor, &_distance_um)) {
+                    _status = SONIC_REQUEST_DONE;
+                    if(_continuation) {_continuation(*this, _context);}
+                }
+                return _status == SONIC_REQUEST_DONE;
+            }
+
+            /*
+                Polls until the reading is available or timeout_ms has passed on clock_ms (e.g. millis), calling idle
+                (e.g. yield) between polls.  Returns false on timeout - the request stays pending and can be polled on.
+            */
+            uint8_t wait(uint32_t timeout_ms, uint32_t (*clock_ms)(), void (*idle)() = nullptr) {
+                return wait_all(this, 1, timeout_ms, clock_ms, idle);
+            }
+
+            /* Sets a function called once (from poll()) when the reading arrives - right away if it already has */
+            void then(CONTINUATION continuation, void* context = nullptr) {
+                _continuation = continuation;
+                _context = context;
+                if(_continuation && (_status == SONIC_REQUEST_DONE)) {_continuation(*this, _context);}
+            }
+
+            /* Gets the state of the request (SONIC_REQUEST_IDLE/PENDING/DONE) */
+            uint8_t getStatus() const {return _status;}
+
+            /* Gets the distance in um (only valid once the request is done) */
+            uint32_t getDistance_um() const {return _distance_um;}
+
+            /* Polls every pending request once - returns true once all of them are done */
+            static uint8_t when_all(SONIC_REQUEST* requests, uint8_t count) {
+                uint8_t done = true;
+                for(uint8_t i = 0; i < count; i++) {
+                    if((requests[i]._status != SONIC_REQUEST_IDLE) && !requests[i].poll()) {done = false;}
+                }
+                return done;
+            }
+
+            /* Polls every pending request once - returns the index of the first done request, or -1 */
+            static int16_t when_any(SONIC_REQUEST* requests, uint8_t count) {
+                int16_t first = -1;
+                for(uint8_t i = 0; i < count; i++) {
+                    if((requests[i]._status != SONIC_REQUEST_IDLE) && requests[i].poll() && (first < 0)) {first = i;}
+                }
+                return first;
+            }
+
+            /* Blocking versions of when_all()/when_any() with a timeout - see wait() */
+            static uint8_t wait_all(SONIC_REQUEST* requests, uint8_t count, uint32_t timeout_ms, uint32_t (*clock_ms)(), void (*idle)() = nullptr) {
+                uint32_t started = clock_ms();
+                while(!when_all(requests, count)) {
+                    if(clock_ms() - started >= timeout_ms) {return false;}
+                    if(idle) {idle();}
+                }
+                return true;
+            }
+
+            static int16_t wait_any(SONIC_REQUEST* requests, uint8_t count, uint32_t timeout_ms, uint32_t (*clock_ms)(), void (*idle)() = nullptr) {
+                uint32_t started = clock_ms();
+                int16_t first;
+                while((first = when_any(requests, count)) < 0) {
+                    if(clock_ms() - started >= timeout_ms) {return -1;}
+                    if(idle) {idle();}
+                }
+                return first;
+            }
+
+            /* Poll function used by requestMeasurement() for any sensor with readingAvailable()/getDistance_um() */
+            template <typename SENSOR>
+            static uint8_t poll_sensor(void* sensor, uint32_t* distance_um) {
+                if(!((SENSOR*)sensor)->readingAvailable()) {return false;}
+                *distance_um = ((SENSOR*)sensor)->getDistance_um();
+                return true;
+            }
+
+        private:
+            /* Private variables for the sensor being waited on */
+            void* _sensor = nullptr;
+            POLL _poll = nullptr;
+
+            /* Private variables for the continuation */
+            CONTINUATION _continuation = nullptr;
+            void* _context = nullptr;
+
+            /* Private variables for the result */
+            uint32_t _distance_um = 0;
+            uint8_t _status = SONIC_REQUEST_IDLE;
+    };
+
+    /* Starts a measurement request on a sensor (SONIC_I2C, SONIC_IO or any of the other adapters) - polls it once to send the trigger */
+    template <typename SENSOR>
+    SONIC_REQUEST requestMeasurement(SENSOR& sensor) {
+        SONIC_REQUEST request(&sensor, &SONIC_REQUEST::poll_sensor<SENSOR>);
+        request.poll();
+        return request;
+    }
+
+#endif
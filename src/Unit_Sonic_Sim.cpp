@@ -0,0 +1,75 @@
+#include "Unit_Sonic_Sim.h"
+
+uint64_t SONIC_SIM_CLOCK::_now_us = 0;
+
+/* Same contract as SONIC_I2C::readingAvailable() */
+uint8_t SONIC_I2C_SIM::readingAvailable() {
+    SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_POLL);
+    uint64_t now = SONIC_SIM_CLOCK::now_us() / 1000;
+
+    switch(poll(now)) {
+        case SONIC_ACTION_TRIGGER: {
+            SONIC_TRACE_SCOPE(SONIC_TRACE_I2C_TRIGGER);
+            _triggered_at = now;
+            triggered(now);
+            break;
+        }
+
+        case SONIC_ACTION_READ: {
+            /* The simulated chip only answers once its own conversion is done */
+            uint8_t data[3] = {(uint8_t)(_target >> 16), (uint8_t)(_target >> 8), (uint8_t)_target};
+            uint8_t length = (_connected && (now - _triggered_at >= _latency)) ? sizeof(data) : 0;
+            return received(data, length, now);
+        }
+    }
+
+    return false;
+}
+
+/* Same contract as SONIC_I2C::burstAvailable() */
+uint8_t SONIC_I2C_SIM::burstAvailable(SONIC_BURST_RESULT* result) {
+    return readingAvailable() && collect_burst(result);
+}
+
+/* Same contract as SONIC_IO::readingAvailable() - delivers the due echo edges first */
+uint8_t SONIC_IO_SIM::readingAvailable() {
+    SONIC_TRACE_SCOPE(SONIC_TRACE_IO_POLL);
+    uint64_t now_us = SONIC_SIM_CLOCK::now_us();
+
+    /* Play the "ISR" for every edge that is due, with the edge's own timestamp */
+    if((_edges == 2) && (now_us >= _rise_at)) {
+        SONIC_TRACE_SCOPE(SONIC_TRACE_ECHO_RISING);
+        echo_rising((uint32_t)_rise_at);
+        _edges = 1;
+    }
+    if((_edges == 1) && (now_us >= _fall_at)) {
+        SONIC_TRACE_SCOPE(SONIC_TRACE_ECHO_FALLING);
+        echo_falling((uint32_t)_fall_at);
+        _edges = 0;
+    }
+
+    switch(poll(SONIC_SIM_CLOCK::now_us() / 1000)) {
+        case SONIC_ACTION_TRIGGER: {
+            SONIC_TRACE_SCOPE(SONIC_TRACE_IO_TRIGGER);
+            /* Schedule the echo pulse - twice the flight time at 343um/us */
+            _edges = 0;
+            if(_connected && (_target <= SONIC_MAX_DISTANCE_UM)) {
+                _rise_at = now_us + SONIC_IO_TRIG_PULSE_US + SONIC_SIM_ECHO_DELAY_US;
+                _fall_at = _rise_at + ((uint64_t)_target * 2) / 343;
+                _edges = 2;
+            }
+            triggered(SONIC_SIM_CLOCK::now_us() / 1000);
+            break;
+        }
+
+        case SONIC_ACTION_READING:
+            return true;
+    }
+
+    return false;
+}
+
+/* Same contract as SONIC_IO::burstAvailable() */
+uint8_t SONIC_IO_SIM::burstAvailable(SONIC_BURST_RESULT* result) {
+    return readingAvailable() && collect_burst(result);
+}
@@ -0,0 +1,106 @@
+/*
+    Simulator adapters for the Unit Sonic cores.
+
+    Drives the platform independent cores from a virtual clock and a scripted target distance instead of
+    real hardware, so the state machines can be exercised (and timed) on any host.  Advance the clock
+    with SONIC_SIM_CLOCK::advance_us() and poll readingAvailable() like on target.
+*/
+#ifndef _UNIT_SONIC_SIM_H_
+    #define _UNIT_SONIC_SIM_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Core.h"
+    #include "Unit_Sonic_Coro.h"
+
+    #define SONIC_SIM_ECHO_DELAY_US 500     //Delay between the trigger pulse and the start of the echo pulse
+
+    class SONIC_SIM_CLOCK {
+        public:
+            /* Moves the virtual time forward */
+            static void advance_us(uint32_t us) {_now_us += us;}
+
+            /* Sets the virtual time (e.g. just before a 32 bit wrap) */
+            static void set_us(uint64_t us) {_now_us = us;}
+
+            /* Gets the virtual time, truncated like the Arduino millis()/micros() */
+            static uint32_t millis() {return (uint32_t)(_now_us / 1000);}
+            static uint32_t micros() {return (uint32_t)_now_us;}
+            static uint64_t now_us() {return _now_us;}
+
+        private:
+            static uint64_t _now_us;
+    };
+
+    class SONIC_I2C_SIM : public SONIC_I2C_CORE {
+        public:
+            /* Sets the simulated target distance (um) */
+            void setTarget(uint32_t distance_um) {_target = distance_um;}
+
+            /* Sets how long (ms) the simulated chip really needs - earlier reads are NAKed */
+            void setLatency(uint32_t ms) {_latency = ms;}
+
+            /* Connects/disconnects the simulated chip (a disconnected chip NAKs everything) */
+            void setConnected(uint8_t connected) {_connected = connected;}
+
+            /* Same contract as SONIC_I2C::readingAvailable() */
+            uint8_t readingAvailable();
+
+            /* Same contract as SONIC_I2C::burstAvailable() */
+            uint8_t burstAvailable(SONIC_BURST_RESULT* result);
+
+        private:
+            /* Private variables for the simulated chip */
+            uint32_t _target = 1000000;
+            uint32_t _latency = 30;
+            uint32_t _triggered_at = 0;
+            uint8_t _connected = true;
+    };
+
+    class SONIC_IO_SIM : public SONIC_IO_CORE {
+        public:
+            /* Sets the simulated target distance (um) - anything past SONIC_MAX_DISTANCE never echoes */
+            void setTarget(uint32_t distance_um) {_target = distance_um;}
+
+            /* Connects/disconnects the simulated echo line */
+            void setConnected(uint8_t connected) {_connected = connected;}
+
+            /* Same contract as SONIC_IO::readingAvailable() - delivers the due echo edges first */
+            uint8_t readingAvailable();
+
+            /* Same contract as SONIC_IO::burstAvailable() */
+            uint8_t burstAvailable(SONIC_BURST_RESULT* result);
+
+        private:
+            /* Private variables for the simulated echo */
+            uint32_t _target = 1000000;
+            uint64_t _rise_at = 0;
+            uint64_t _fall_at = 0;
+            uint8_t _edges = 0;
+            uint8_t _connected = true;
+    };
+
+    #if defined(SONIC_HAVE_COROUTINES)
+
+        /* Host executor for tests - runs on the virtual clock and moves it forward whenever nothing is ready */
+        class SONIC_SIM_EXECUTOR : public SONIC_EXECUTOR {
+            public:
+                SONIC_SIM_EXECUTOR() : SONIC_EXECUTOR(&SONIC_SIM_CLOCK::millis) {}
+
+                /*
+                    Runs until no coroutine is waiting anymore or the virtual clock has moved by timeout_ms, advancing
+                    it by step_us on every idle pass.  Returns true if everything completed.
+                */
+                uint8_t run(uint32_t step_us = 100, uint32_t timeout_ms = 60000) {
+                    uint64_t deadline = SONIC_SIM_CLOCK::now_us() + (uint64_t)timeout_ms * 1000;
+
+                    while(pending()) {
+                        if(SONIC_SIM_CLOCK::now_us() >= deadline) {return false;}
+                        if(!run_once()) {SONIC_SIM_CLOCK::advance_us(step_us);}
+                    }
+                    return true;
+                }
+        };
+
+    #endif
+
+#endif
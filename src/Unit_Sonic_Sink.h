@@ -0,0 +1,81 @@
+/*
+    Reading sinks for the Unit Sonic drivers.
+
+    Anything that wants to see every new reading of a sensor (background models, statistics, loggers...)
+    derives from SONIC_SINK and gets attached to the sensor.  The sinks are kept in an intrusive list so
+    attaching them never allocates.
+*/
+#ifndef _UNIT_SONIC_SINK_H_
+    #define _UNIT_SONIC_SINK_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Trace.h"
+
+    class SONIC_SINK {
+        public:
+            SONIC_SINK() = default;
+            virtual ~SONIC_SINK() {}
+
+            /* Linked into a sensor's list - a copy would share the link and corrupt the list once attached */
+            SONIC_SINK(const SONIC_SINK&) = delete;
+            SONIC_SINK& operator=(const SONIC_SINK&) = delete;
+
+            /* Called by the sensor once per new reading (distance in um, timestamp in ms) */
+            virtual void onReading(uint32_t distance_um, uint32_t timestamp_ms) = 0;
+
+        private:
+            friend class SONIC_SINK_LIST;
+
+            /* Private variable for the next sink attached to the same sensor */
+            SONIC_SINK *_next_sink = nullptr;
+    };
+
+    /*
+        Sink that forwards every reading of the sensor it is attached to under a fixed sensor id, for helpers
+        that collect several sensors (anything with add(sensor, distance_um, timestamp_ms))
+    */
+    template <typename TARGET>
+    class SONIC_CHANNEL : public SONIC_SINK {
+        public:
+            SONIC_CHANNEL(TARGET* target, uint8_t sensor) : _target(target), _sensor(sensor) {}
+
+            void onReading(uint32_t distance_um, uint32_t timestamp_ms) override {_target->add(_sensor, distance_um, timestamp_ms);}
+
+        private:
+            TARGET* _target;
+            uint8_t _sensor;
+    };
+
+    class SONIC_SINK_LIST {
+        public:
+            /* Adds a sink to the list (a sink can only be attached to one sensor at a time) */
+            void attach(SONIC_SINK *sink) {
+                if(!sink) {return;}
+                detach(sink);
+                sink->_next_sink = _head;
+                _head = sink;
+            }
+
+            /* Removes a sink from the list */
+            void detach(SONIC_SINK *sink) {
+                for(SONIC_SINK **link = &_head; *link; link = &(*link)->_next_sink) {
+                    if(*link == sink) {
+                        *link = sink->_next_sink;
+                        sink->_next_sink = nullptr;
+                        return;
+                    }
+                }
+            }
+
+            /* Hands a new reading to every attached sink */
+            void publish(uint32_t distance_um, uint32_t timestamp_ms) {
+                SONIC_TRACE_SCOPE(SONIC_TRACE_PUBLISH);
+                for(SONIC_SINK *sink = _head; sink; sink = sink->_next_sink) {sink->onReading(distance_um, timestamp_ms);}
+            }
+
+        private:
+            /* Private variable for the first attached sink */
+            SONIC_SINK *_head = nullptr;
+    };
+
+#endif
@@ -0,0 +1,153 @@
+#include "Unit_Sonic_Stats.h"
+#include <math.h>
+
+SONIC_STATS::SONIC_STATS() {
+    begin();
+}
+
+/* Selects the percentiles to track (0.0 - 1.0) and resets the accumulator */
+void SONIC_STATS::begin(float q0, float q1, float q2) {
+    _lock.lock();
+    _quantile[0] = q0;
+    _quantile[1] = q1;
+    _quantile[2] = q2;
+    clear();
+    _lock.unlock();
+}
+
+/* Adds a reading (um) to the accumulator */
+void SONIC_STATS::update(uint32_t distance_um, uint32_t timestamp_ms) {
+    float distance = distance_um / 1000.0f;
+
+    _lock.lock();
+
+    if(_count == 0) {
+        _first_ms = timestamp_ms;
+        _min = distance;
+        _max = distance;
+    }
+    _last_ms = timestamp_ms;
+    _count++;
+
+    /* Welford mean/variance */
+    double delta = distance - _mean;
+    _mean += delta / _count;
+    _m2 += delta * (distance - _mean);
+
+    if(distance < _min) {_min = distance;}
+    if(distance > _max) {_max = distance;}
+
+    for(uint8_t i = 0; i < SONIC_STATS_QUANTILES; i++) {update_quantile(i, distance);}
+
+    _lock.unlock();
+}
+
+/* Copies the current statistics, optionally resetting the accumulator in the same critical section */
+void SONIC_STATS::snapshot(SONIC_STATS_SNAPSHOT *snapshot, uint8_t reset) {
+    _lock.lock();
+
+    snapshot->count = _count;
+    snapshot->first_ms = _first_ms;
+    snapshot->last_ms = _last_ms;
+    snapshot->mean = (float)_mean;
+    snapshot->stddev = (_count > 1) ? (float)sqrt(_m2 / (_count - 1)) : 0;
+    snapshot->min = _min;
+    snapshot->max = _max;
+    for(uint8_t i = 0; i < SONIC_STATS_QUANTILES; i++) {snapshot->quantile[i] = get_quantile(i);}
+
+    if(reset) {clear();}
+
+    _lock.unlock();
+}
+
+/* Clears the accumulator (keeps the selected percentiles) */
+void SONIC_STATS::reset() {
+    _lock.lock();
+    clear();
+    _lock.unlock();
+}
+
+/* Private function to clear the accumulator without taking the lock */
+void SONIC_STATS::clear() {
+    _count = 0;
+    _first_ms = 0;
+    _last_ms = 0;
+    _mean = 0;
+    _m2 = 0;
+    _min = 0;
+    _max = 0;
+
+    for(uint8_t i = 0; i < SONIC_STATS_QUANTILES; i++) {
+        float p = _quantile[i];
+        for(uint8_t j = 0; j < 5; j++) {
+            _height[i][j] = 0;
+            _position[i][j] = j + 1;
+        }
+        _desired[i][0] = 1;
+        _desired[i][1] = 1 + 2 * p;
+        _desired[i][2] = 1 + 4 * p;
+        _desired[i][3] = 3 + 2 * p;
+        _desired[i][4] = 5;
+    }
+}
+
+/* Private function to feed one P-square estimator */
+void SONIC_STATS::update_quantile(uint8_t index, float distance) {
+    float *q = _height[index];
+    int32_t *n = _position[index];
+    float *desired = _desired[index];
+    float p = _quantile[index];
+    const float increment[5] = {0, p / 2, p, (1 + p) / 2, 1};
+
+    /* The first 5 readings simply seed the markers (kept sorted) */
+    if(_count <= 5) {
+        uint8_t j = _count - 1;
+        for(; (j > 0) && (q[j - 1] > distance); j--) {q[j] = q[j - 1];}
+        q[j] = distance;
+        return;
+    }
+
+    /* Find the cell the reading falls into, extending the extremes if needed */
+    uint8_t k;
+    if(distance < q[0]) {
+        q[0] = distance;
+        k = 0;
+    } else if(distance >= q[4]) {
+        q[4] = distance;
+        k = 3;
+    } else {
+        for(k = 0; (k < 3) && (distance >= q[k + 1]); k++) {}
+    }
+
+    for(uint8_t j = k + 1; j < 5; j++) {n[j]++;}
+    for(uint8_t j = 0; j < 5; j++) {desired[j] += increment[j];}
+
+    /* Nudge the middle markers towards their desired positions (parabolic, falling back to linear) */
+    for(uint8_t j = 1; j < 4; j++) {
+        float d = desired[j] - n[j];
+
+        if(((d >= 1) && (n[j + 1] - n[j] > 1)) || ((d <= -1) && (n[j - 1] - n[j] < -1))) {
+            int32_t step = (d >= 0) ? 1 : -1;
+            float parabolic = q[j] + (float)step / (n[j + 1] - n[j - 1]) *
+                              ((n[j] - n[j - 1] + step) * (q[j + 1] - q[j]) / (n[j + 1] - n[j]) +
+                               (n[j + 1] - n[j] - step) * (q[j] - q[j - 1]) / (n[j] - n[j - 1]));
+
+            if((q[j - 1] < parabolic) && (parabolic < q[j + 1])) {
+                q[j] = parabolic;
+            } else {
+                q[j] += step * (q[j + step] - q[j]) / (n[j + step] - n[j]);
+            }
+            n[j] += step;
+        }
+    }
+}
+
+/* Private function to read one P-square estimator */
+float SONIC_STATS::get_quantile(uint8_t index) {
+    if(_count == 0) {return 0;}
+
+    /* Until the markers are initialised (up to and including the 5th reading), pick the sorted reading at rank p*(n-1) */
+    if(_count <= 5) {return _height[index][(uint8_t)(_quantile[index] * (_count - 1) + 0.5f)];}
+
+    return _height[index][2];
+}
@@ -0,0 +1,77 @@
+/*
+    Streaming distance statistics for the Unit Sonic drivers.
+
+    Keeps count, mean/variance (Welford), min/max and a few percentiles (P-square estimator) in O(1)
+    memory, so hourly reports don't need raw logs.  Attach it to a sensor and snapshot it from
+    wherever the report is generated - the snapshot (and optional reset) is atomic.
+*/
+#ifndef _UNIT_SONIC_STATS_H_
+    #define _UNIT_SONIC_STATS_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Sink.h"
+    #include "Unit_Sonic_Lock.h"
+
+    #define SONIC_STATS_QUANTILES 3     //Number of percentiles tracked by each accumulator (P50, P90, P99 by default)
+
+    /* Copy of the statistics at one point in time (distances in mm) */
+    struct SONIC_STATS_SNAPSHOT {
+        uint32_t count;
+        uint32_t first_ms;      //Timestamp of the first reading since the last reset
+        uint32_t last_ms;       //Timestamp of the latest reading
+        float mean;
+        float stddev;
+        float min;
+        float max;
+        float quantile[SONIC_STATS_QUANTILES];
+    };
+
+    class SONIC_STATS : public SONIC_SINK {
+        public:
+            SONIC_STATS();
+
+            /* Selects the percentiles to track (0.0 - 1.0) and resets the accumulator */
+            void begin(float q0 = 0.5f, float q1 = 0.9f, float q2 = 0.99f);
+
+            /* Adds a reading (um) to the accumulator */
+            void update(uint32_t distance_um, uint32_t timestamp_ms = 0);
+
+            /* Sink interface - lets the accumulator be attached directly to a sensor */
+            void onReading(uint32_t distance_um, uint32_t timestamp_ms) override {update(distance_um, timestamp_ms);}
+
+            /* Copies the current statistics, optionally resetting the accumulator in the same critical section */
+            void snapshot(SONIC_STATS_SNAPSHOT *snapshot, uint8_t reset = false);
+
+            /* Clears the accumulator (keeps the selected percentiles) */
+            void reset();
+
+        private:
+            /* Private function to clear the accumulator without taking the lock */
+            void clear();
+
+            /* Private function to feed one P-square estimator */
+            void update_quantile(uint8_t index, float distance);
+
+            /* Private function to read one P-square estimator */
+            float get_quantile(uint8_t index);
+
+            /* Private variable to protect the accumulator against concurrent snapshots */
+            SONIC_LOCK _lock;
+
+            /* Private variables for the Welford accumulator */
+            uint32_t _count;
+            uint32_t _first_ms;
+            uint32_t _last_ms;
+            double _mean;
+            double _m2;
+            float _min;
+            float _max;
+
+            /* Private variables for the P-square estimators (5 markers each) */
+            float _quantile[SONIC_STATS_QUANTILES];
+            float _height[SONIC_STATS_QUANTILES][5];
+            int32_t _position[SONIC_STATS_QUANTILES][5];
+            float _desired[SONIC_STATS_QUANTILES][5];
+    };
+
+#endif
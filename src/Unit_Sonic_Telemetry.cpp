@@ -0,0 +1,136 @@
+#include <string.h>
+#include "Unit_Sonic_Telemetry.h"
+
+/* Adds a reading - returns false if it had to be dropped */
+uint8_t SONIC_TELEMETRY::add(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms) {
+    /* Send the frame first once it is old (if the other buffer is still busy, keep filling this one) */
+    if(!_batch.empty() && ((timestamp_ms - _batch.getStarted()) >= SONIC_TELEMETRY_MAX_AGE_MS)) {seal();}
+
+    if(_batch.add(sensor, distance_um, timestamp_ms)) {return true;}
+
+    /* The frame is full --> the reading goes into the next one, unless the other buffer is still being sent */
+    if(!seal() || !_batch.add(sensor, distance_um, timestamp_ms)) {
+        _dropped++;
+        return false;
+    }
+    return true;
+}
+
+/* Seals the frame being filled so it is sent right away */
+void SONIC_TELEMETRY::flush() {seal();}
+
+/* Gets the next bytes to send */
+uint16_t SONIC_TELEMETRY::pending(const uint8_t** data, uint32_t now_ms) {
+    if(!_batch.empty() && ((now_ms - _batch.getStarted()) >= SONIC_TELEMETRY_MAX_AGE_MS)) {seal();}
+    if(!_draining) {return 0;}
+
+    uint8_t drain = _fill ^ 1;
+    *data = &_frames[drain][_sent];
+    return _length[drain] - _sent;
+}
+
+/* Marks bytes returned by pending() as sent */
+void SONIC_TELEMETRY::consume(uint16_t length) {
+    uint8_t drain = _fill ^ 1;
+
+    if(!_draining) {return;}
+
+    _sent += length;
+    if(_sent >= _length[drain]) {
+        _length[drain] = 0;
+        _draining = false;
+    }
+}
+
+/* Private function to seal the frame being filled */
+uint8_t SONIC_TELEMETRY::seal() {
+    if(_draining || _batch.empty()) {return false;}
+
+    uint8_t* frame = _frames[_fill];
+    uint16_t payload = _batch.getLength();
+    uint16_t length = SONIC_TELEMETRY_HEADER + payload;
+
+    frame[0] = SONIC_TELEMETRY_SYNC;
+    frame[1] = SONIC_TELEMETRY_TYPE_READINGS;
+    frame[2] = _sequence++;
+    frame[3] = (uint8_t)payload;
+    frame[4] = (uint8_t)(payload >> 8);
+
+    /* The CRC covers everything after the sync byte */
+    uint16_t crc = SONIC_CODEC::crc16(&frame[1], length - 1);
+    frame[length++] = (uint8_t)crc;
+    frame[length++] = (uint8_t)(crc >> 8);
+    _length[_fill] = length;
+
+    /* Hand the frame over to the sender and continue in the other buffer */
+    _draining = true;
+    _sent = 0;
+    _fill ^= 1;
+    open(_fill);
+
+    return true;
+}
+
+/* Private function to start filling the given frame buffer */
+void SONIC_TELEMETRY::open(uint8_t frame) {
+    _length[frame] = 0;
+    _batch.start(&_frames[frame][SONIC_TELEMETRY_HEADER], SONIC_TELEMETRY_FRAME_SIZE - SONIC_TELEMETRY_HEADER - SONIC_TELEMETRY_TRAILER);
+}
+
+/* Feeds received bytes */
+void SONIC_TELEMETRY_DECODER::feed(const uint8_t* data, uint32_t length) {
+    while(length) {
+        uint32_t chunk = sizeof(_buffer) - _length;
+        if(chunk > length) {chunk = length;}
+
+        memcpy(&_buffer[_length], data, chunk);
+        _length += chunk;
+        data += chunk;
+        length -= chunk;
+
+        for(uint16_t drop; (drop = parse()) != 0; ) {
+            memmove(_buffer, &_buffer[drop], _length - drop);
+            _length -= drop;
+        }
+    }
+}
+
+/* Private function to decode the frames in the buffer - returns the bytes that can be dropped */
+uint16_t SONIC_TELEMETRY_DECODER::parse() {
+    if(!_length) {return 0;}
+
+    /* Skip to the next sync byte */
+    if(_buffer[0] != SONIC_TELEMETRY_SYNC) {
+        uint16_t skip = 1;
+        while((skip < _length) && (_buffer[skip] != SONIC_TELEMETRY_SYNC)) {skip++;}
+        return skip;
+    }
+
+    if(_length < SONIC_TELEMETRY_HEADER) {return 0;}
+
+    uint16_t payload = _buffer[3] | ((uint16_t)_buffer[4] << 8);
+    uint32_t total = SONIC_TELEMETRY_HEADER + payload + SONIC_TELEMETRY_TRAILER;
+
+    /* Not a frame header after all (or a corrupt one) --> look for the next sync byte */
+    if((_buffer[1] != SONIC_TELEMETRY_TYPE_READINGS) || (total > sizeof(_buffer))) {
+        _errors++;
+        return 1;
+    }
+
+    if(_length < total) {return 0;}
+
+    uint16_t crc = SONIC_CODEC::crc16(&_buffer[1], SONIC_TELEMETRY_HEADER + payload - 1);
+    uint16_t received = _buffer[total - 2] | ((uint16_t)_buffer[total - 1] << 8);
+
+    if((crc != received) || !SONIC_BATCH::decode(&_buffer[SONIC_TELEMETRY_HEADER], payload, _callback, _context)) {
+        _errors++;
+        return 1;
+    }
+
+    /* Count the frames missing in between (the sequence is 8 bits, so long outages are undercounted) */
+    if(_frames) {_lost += (uint8_t)(_buffer[2] - _sequence);}
+    _sequence = _buffer[2] + 1;
+    _frames++;
+
+    return (uint16_t)total;
+}
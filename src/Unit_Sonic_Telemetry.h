@@ -0,0 +1,132 @@
+/*
+    Compact binary telemetry for the Unit Sonic sensors.
+
+    Instead of printing every reading as text, readings from any number of sensors are packed into small
+    framed batches and handed to the serial port only as fast as its TX buffer can take them, so logging
+    never blocks the measurement loop (readings are dropped and counted when the link can't keep up).
+
+    Frame (little endian):
+        0xA5 | type | sequence | payload length (u16) | payload | CRC-16/CCITT-FALSE of type..payload (u16)
+
+    Readings payload (type 0x01) - one SONIC_BATCH (Unit_Sonic_Batch.h), so every frame decodes on its own.
+
+    Two frame buffers are used: one is filled while the other is drained, so a sealed frame is contiguous
+    and stays put until it is consumed (DMA friendly).  extras/tools/sonic_telemetry_decode.cpp decodes it.
+*/
+#ifndef _UNIT_SONIC_TELEMETRY_H_
+    #define _UNIT_SONIC_TELEMETRY_H_
+
+    #include <stdint.h>
+    #include "Unit_Sonic_Batch.h"
+    #include "Unit_Sonic_Sink.h"
+
+    #ifndef SONIC_TELEMETRY_FRAME_SIZE
+        #define SONIC_TELEMETRY_FRAME_SIZE 256      //Bytes per frame buffer (two of them are kept)
+    #endif
+    #ifndef SONIC_TELEMETRY_MAX_AGE_MS
+        #define SONIC_TELEMETRY_MAX_AGE_MS 50       //A partly filled frame is sent once its first reading is this old
+    #endif
+
+    #define SONIC_TELEMETRY_SYNC 0xA5               //First byte of every frame
+    #define SONIC_TELEMETRY_TYPE_READINGS 0x01      //Frame type of the readings payload
+    #define SONIC_TELEMETRY_HEADER 5                //sync + type + sequence + length
+    #define SONIC_TELEMETRY_TRAILER 2               //CRC
+
+    class SONIC_TELEMETRY {
+        public:
+            SONIC_TELEMETRY() {open(0);}
+
+            /* Adds a reading - returns false if it had to be dropped (both buffers busy or an invalid sensor id) */
+            uint8_t add(uint8_t sensor, uint32_t distance_um, uint32_t timestamp_ms);
+
+            /* Seals the frame being filled so it is sent right away (if the other buffer is free) */
+            void flush();
+
+            /*
+                Gets the next bytes to send - returns their number (0 if nothing is ready).  A partly filled frame is
+                sealed here once it is older than SONIC_TELEMETRY_MAX_AGE_MS.  The data stays valid until consume().
+            */
+            uint16_t pending(const uint8_t** data, uint32_t now_ms);
+
+            /* Marks bytes returned by pending() as sent */
+            void consume(uint16_t length);
+
+            /*
+                Writes as much as fits into the TX buffer of a serial port (anything with availableForWrite() and
+                write(data, length), e.g. Serial) without blocking - call it from the user's loop.  Returns the bytes written.
+            */
+            template <typename OUT>
+            uint16_t writeTo(OUT& out, uint32_t now_ms) {
+                const uint8_t* data;
+                uint16_t length = pending(&data, now_ms);
+                int room = out.availableForWrite();
+
+                if(!length || (room <= 0)) {return 0;}
+                if(length > room) {length = (uint16_t)room;}
+
+                length = (uint16_t)out.write(data, length);
+                consume(length);
+                return length;
+            }
+
+            /* Gets the number of readings dropped because the link couldn't keep up */
+            uint32_t getDropped() const {return _dropped;}
+
+        private:
+            /* Private function to seal the frame being filled - returns false if the other buffer is still busy */
+            uint8_t seal();
+
+            /* Private function to start filling the given frame buffer */
+            void open(uint8_t frame);
+
+            /* Private variables for the two frame buffers */
+            uint8_t _frames[2][SONIC_TELEMETRY_FRAME_SIZE];
+            uint16_t _length[2] = {0, 0};
+            uint16_t _sent = 0;
+            uint8_t _fill = 0;
+            uint8_t _draining = false;
+            uint8_t _sequence = 0;
+
+            /* Private variable for the payload of the frame being filled */
+            SONIC_BATCH _batch;
+
+            uint32_t _dropped = 0;
+    };
+
+    /* Sink that streams every reading of the sensor it is attached to under a fixed sensor id */
+    typedef SONIC_CHANNEL<SONIC_TELEMETRY> SONIC_TELEMETRY_CHANNEL;
+
+    /* Stream decoder for the frames above - resynchronises on the next sync byte after corrupt or lost data */
+    class SONIC_TELEMETRY_DECODER {
+        public:
+            typedef SONIC_BATCH::CALLBACK CALLBACK;
+
+            SONIC_TELEMETRY_DECODER(CALLBACK callback, void* context = nullptr) : _callback(callback), _context(context) {}
+
+            /* Feeds received bytes - the callback is called for every reading of every valid frame */
+            void feed(const uint8_t* data, uint32_t length);
+
+            /* Gets the number of valid frames, corrupt frames and frames missing from the sequence */
+            uint32_t getFrames() const {return _frames;}
+            uint32_t getErrors() const {return _errors;}
+            uint32_t getLost() const {return _lost;}
+
+        private:
+            /* Private function to decode the frames in the buffer - returns the bytes that can be dropped */
+            uint16_t parse();
+
+            CALLBACK _callback;
+            void* _context;
+
+            /* Private variables for the receive buffer */
+            uint8_t _buffer[SONIC_TELEMETRY_FRAME_SIZE];
+            uint16_t _length = 0;
+
+            /* Private variables for the statistics */
+            uint32_t _frames = 0;
+            uint32_t _errors = 0;
+            uint32_t _lost = 0;
+            uint8_t _sequence = 0;
+    };
+
+#endif
@@ -0,0 +1,121 @@
+#include "Unit_Sonic_Trace.h"
+
+#if defined(SONIC_ENABLE_TRACE)
+
+#include <stdio.h>
+
+#if defined(ESP_PLATFORM)
+    #include "esp_rom_sys.h"
+#elif defined(__x86_64__) || defined(__i386__)
+    #include "Unit_Sonic_Clock.h"
+#endif
+
+static_assert((SONIC_TRACE_EVENTS & (SONIC_TRACE_EVENTS - 1)) == 0, "SONIC_TRACE_EVENTS must be a power of 2 so the ring survives the index wrap");
+
+SONIC_TRACE_EVENT SONIC_TRACE::_events[SONIC_TRACE_EVENTS];
+uint32_t SONIC_TRACE::_head = 0;
+
+/* Private table of the trace point names and the thread (1 = loop, 2 = ISR) they show up on */
+static const struct {
+    const char *name;
+    uint8_t thread;
+} sonic_trace_points[SONIC_TRACE_POINTS] = {
+    {"i2c poll", 1},
+    {"i2c trigger", 1},
+    {"i2c read", 1},
+    {"i2c convert", 1},
+    {"io poll", 1},
+    {"io trigger", 1},
+    {"io convert", 1},
+    {"echo rising", 2},
+    {"echo falling", 2},
+    {"publish", 1},
+};
+
+/* Empties the ring */
+void SONIC_TRACE::clear() {__atomic_store_n(&_head, 0, __ATOMIC_RELAXED);}
+
+/* Gets the events recorded since the last clear() */
+uint32_t SONIC_TRACE::getCount() {return __atomic_load_n(&_head, __ATOMIC_RELAXED);}
+
+/* Gets the cycle counter frequency in Hz */
+uint64_t SONIC_TRACE::getFrequency() {
+    #if defined(ESP_PLATFORM)
+        return (uint64_t)esp_rom_get_cpu_ticks_per_us() * 1000000ULL;
+    #elif defined(__x86_64__) || defined(__i386__)
+        /* The TSC rate isn't exposed anywhere portable --> count it over 20ms of SONIC_CLOCK once */
+        static uint64_t frequency = 0;
+        if(!frequency) {
+            uint64_t start_ns = SONIC_CLOCK::nanos64();
+            uint64_t start = __rdtsc();
+            while(SONIC_CLOCK::nanos64() - start_ns < 20000000ULL) {}
+            frequency = (__rdtsc() - start) * 1000000000ULL / (SONIC_CLOCK::nanos64() - start_ns);
+        }
+        return frequency;
+    #else
+        return 1000000000ULL;
+    #endif
+}
+
+/* Copies up to max of the kept events, oldest first */
+uint32_t SONIC_TRACE::copy(SONIC_TRACE_EVENT *events, uint32_t max) {
+    uint32_t head = getCount();
+    uint32_t count = (head < SONIC_TRACE_EVENTS) ? head : SONIC_TRACE_EVENTS;
+    if(count > max) {count = max;}
+
+    for(uint32_t i = 0; i < count; i++) {events[i] = _events[(head - count + i) % SONIC_TRACE_EVENTS];}
+    return count;
+}
+
+/* Gets the name of a trace point */
+const char *SONIC_TRACE::getName(uint8_t point) {
+    return (point < SONIC_TRACE_POINTS) ? sonic_trace_points[point].name : "unknown";
+}
+
+/* Writes the kept events as Chrome trace JSON, oldest first */
+void SONIC_TRACE::exportJson(output_t output, void *context) {
+    char text[128];
+    uint32_t head = getCount();
+    uint32_t count = (head < SONIC_TRACE_EVENTS) ? head : SONIC_TRACE_EVENTS;
+    double us_per_cycle = 1000000.0 / (double)getFrequency();
+
+    output("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", context);
+    output("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"loop\"}},\n", context);
+    output("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"echo ISR\"}}", context);
+
+    /*
+        The counter wraps at 32 bits --> unwrap it from event to event (the events are far less than a wrap apart).
+        An event can hold an earlier count than the one before it (an ISR recording between another event's slot
+        and its counter read, or the unsynchronised counter of the other core) --> count such a step as 0 instead
+        of as a wrap.
+    */
+    uint64_t elapsed = 0;
+    uint32_t previous = count ? _events[(head - count) % SONIC_TRACE_EVENTS].cycles : 0;
+    uint8_t depth[3] = {0, 0, 0};
+
+    for(uint32_t i = head - count; i != head; i++) {
+        const SONIC_TRACE_EVENT &event = _events[i % SONIC_TRACE_EVENTS];
+        if(event.point >= SONIC_TRACE_POINTS) {continue;}
+
+        int32_t delta = (int32_t)(event.cycles - previous);
+        if(delta > 0) {elapsed += (uint32_t)delta;}
+        previous = event.cycles;
+
+        /* The ring may start in the middle of a trace point - drop ends that have no begin */
+        uint8_t thread = sonic_trace_points[event.point].thread;
+        if(event.phase == SONIC_TRACE_END) {
+            if(!depth[thread]) {continue;}
+            depth[thread]--;
+        } else {
+            depth[thread]++;
+        }
+
+        snprintf(text, sizeof(text), ",\n{\"name\":\"%s\",\"cat\":\"sonic\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+                 sonic_trace_points[event.point].name, event.phase, elapsed * us_per_cycle, thread);
+        output(text, context);
+    }
+
+    output("\n]}\n", context);
+}
+
+#endif
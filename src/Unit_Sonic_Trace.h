@@ -0,0 +1,137 @@
+/*
+    Cycle counter trace points for the hot paths of the Unit Sonic drivers.
+
+    Built with SONIC_ENABLE_TRACE defined (for every file of the library, e.g. in build_flags), the polling,
+    bus, conversion and echo ISR paths record a begin and an end event with the raw CPU cycle counter (CCOUNT
+    on Xtensa, the esp_cpu counter on the other ESP32s, the TSC on x86 hosts, CLOCK_MONOTONIC elsewhere) into
+    a static ring of SONIC_TRACE_EVENTS events.  Recording is a counter read, an atomic increment and a store,
+    so it is safe from ISRs and either core - but the cycle counters of the two ESP32 cores are not synchronised
+    and the event keeps no core id, so the exported timeline is only exact for events recorded on one core.
+    exportJson() writes the ring as Chrome trace JSON (open it in Perfetto or chrome://tracing) through an
+    output callback - a file on host, the serial port on target.
+    Without SONIC_ENABLE_TRACE the trace points compile to nothing.
+*/
+#ifndef _UNIT_SONIC_TRACE_H_
+    #define _UNIT_SONIC_TRACE_H_
+
+    #include <stdint.h>
+
+    /* Trace points */
+    #define SONIC_TRACE_I2C_POLL 0          //I2C readingAvailable()
+    #define SONIC_TRACE_I2C_TRIGGER 1       //I2C trigger command on the bus
+    #define SONIC_TRACE_I2C_READ 2          //I2C read of the data bytes
+    #define SONIC_TRACE_I2C_CONVERT 3       //I2C data to corrected distance (core received())
+    #define SONIC_TRACE_IO_POLL 4           //IO readingAvailable()
+    #define SONIC_TRACE_IO_TRIGGER 5        //IO trigger pulse
+    #define SONIC_TRACE_IO_CONVERT 6        //IO pulse width to corrected distance
+    #define SONIC_TRACE_ECHO_RISING 7       //IO echo ISR, rising edge
+    #define SONIC_TRACE_ECHO_FALLING 8      //IO echo ISR, falling edge
+    #define SONIC_TRACE_PUBLISH 9           //Attached sinks handling a new reading
+    #define SONIC_TRACE_POINTS 10
+
+    #if defined(SONIC_ENABLE_TRACE)
+
+        #if defined(__XTENSA__)
+        #elif defined(ESP_PLATFORM)
+            #include "esp_idf_version.h"
+            #include "esp_cpu.h"
+        #elif defined(__x86_64__) || defined(__i386__)
+            #include <x86intrin.h>
+        #else
+            #include <time.h>
+        #endif
+
+        #ifndef SONIC_TRACE_EVENTS
+            #define SONIC_TRACE_EVENTS 1024         //Events kept in the ring (8 bytes each)
+        #endif
+
+        #define SONIC_TRACE_BEGIN 'B'
+        #define SONIC_TRACE_END 'E'
+
+        /* One recorded event */
+        struct SONIC_TRACE_EVENT {
+            uint32_t cycles;
+            uint8_t point;
+            uint8_t phase;
+            uint16_t reserved;
+        };
+
+        class SONIC_TRACE {
+            public:
+                /* Signature of the export output callback (one zero terminated piece of text per call) */
+                typedef void (*output_t)(const char *text, void *context);
+
+                /* Reads the raw cycle counter (wraps at 32 bits) */
+                static inline __attribute__((always_inline)) uint32_t cycles() {
+                    #if defined(__XTENSA__)
+                        uint32_t count;
+                        __asm__ __volatile__("rsr %0, ccount" : "=a"(count));
+                        return count;
+                    #elif defined(ESP_PLATFORM) && (ESP_IDF_VERSION_MAJOR >= 5)
+                        return (uint32_t)esp_cpu_get_cycle_count();
+                    #elif defined(ESP_PLATFORM)
+                        return esp_cpu_get_ccount();
+                    #elif defined(__x86_64__) || defined(__i386__)
+                        return (uint32_t)__rdtsc();
+                    #else
+                        struct timespec now;
+                        clock_gettime(CLOCK_MONOTONIC, &now);
+                        return (uint32_t)((uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec);
+                    #endif
+                }
+
+                /* Records an event (ISR safe) */
+                static inline __attribute__((always_inline)) void record(uint8_t point, uint8_t phase) {
+                    uint32_t slot = __atomic_fetch_add(&_head, 1, __ATOMIC_RELAXED) % SONIC_TRACE_EVENTS;
+                    _events[slot].cycles = cycles();
+                    _events[slot].point = point;
+                    _events[slot].phase = phase;
+                }
+
+                /* Empties the ring (call it while nothing is being traced) */
+                static void clear();
+
+                /* Gets the events recorded since the last clear() - only the newest SONIC_TRACE_EVENTS are kept */
+                static uint32_t getCount();
+
+                /* Gets the cycle counter frequency in Hz (measured once against the system clock on x86 hosts) */
+                static uint64_t getFrequency();
+
+                /* Copies up to max of the kept events, oldest first - returns how many (call it while nothing is being traced) */
+                static uint32_t copy(SONIC_TRACE_EVENT *events, uint32_t max);
+
+                /* Gets the name of a trace point */
+                static const char *getName(uint8_t point);
+
+                /* Writes the kept events as Chrome trace JSON, oldest first (call it while nothing is being traced) */
+                static void exportJson(output_t output, void *context = nullptr);
+
+            private:
+                /* Private variables for the ring */
+                static SONIC_TRACE_EVENT _events[SONIC_TRACE_EVENTS];
+                static uint32_t _head;
+        };
+
+        /* Records the begin of a trace point on construction and its end on destruction */
+        class SONIC_TRACE_GUARD {
+            public:
+                explicit SONIC_TRACE_GUARD(uint8_t point) : _point(point) {SONIC_TRACE::record(point, SONIC_TRACE_BEGIN);}
+                ~SONIC_TRACE_GUARD() {SONIC_TRACE::record(_point, SONIC_TRACE_END);}
+
+            private:
+                uint8_t _point;
+        };
+
+        #define SONIC_TRACE_JOIN2(a, b) a##b
+        #define SONIC_TRACE_JOIN(a, b) SONIC_TRACE_JOIN2(a, b)
+
+        /* Traces the rest of the enclosing scope */
+        #define SONIC_TRACE_SCOPE(point) SONIC_TRACE_GUARD SONIC_TRACE_JOIN(sonic_trace_, __LINE__)(point)
+
+    #else
+
+        #define SONIC_TRACE_SCOPE(point) do {} while(0)
+
+    #endif
+
+#endif